@@ -0,0 +1,325 @@
+#include "Analytical.h"
+#include "LocalSearch.h"
+#include <Eigen/Sparse>
+#include <Eigen/IterativeLinearSolvers>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+
+AnalyticalPlacer::AnalyticalPlacer(const PlacementProblem &prob)
+    : m_prob(prob)
+{
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            const int c = prob.cellId(i, j);
+            if (j + 1 < prob.arraySizeX) m_edges.push_back(std::make_pair(c, c + 1));
+            if (i + 1 < prob.arraySizeY) m_edges.push_back(std::make_pair(c, c + prob.arraySizeX));
+        }
+    }
+
+    for (int sy = 0; sy < prob.siteSizeY; sy++) {
+        m_coordY.push_back(prob.geometry ? prob.geometry->coordY(sy) : sy);
+    }
+    for (int sx = 0; sx < prob.siteSizeX; sx++) {
+        m_coordX.push_back(prob.geometry ? prob.geometry->coordX(sx) : sx);
+    }
+
+    const int w = prob.siteSizeX + 1;
+    m_freePrefix.assign((prob.siteSizeY + 1) * w, 0);
+    for (int sy = 0; sy < prob.siteSizeY; sy++) {
+        for (int sx = 0; sx < prob.siteSizeX; sx++) {
+            m_freePrefix[(sy + 1) * w + sx + 1] = m_freePrefix[sy * w + sx + 1] + m_freePrefix[(sy + 1) * w + sx]
+                - m_freePrefix[sy * w + sx] + !prob.isSiteBlocked(sy, sx);
+        }
+    }
+}
+
+/**
+ * @brief Global placement and the constructive start of LocalSearch, each refined by local search; the shorter wins,
+ * so the result is never worse than the constructive start. The refinements share the rest of the time limit.
+ *
+ * @param timeLimit seconds for the whole run; <= 0: no limit.
+ * @param pl the result.
+ * @return true if <pl> is legal.
+ */
+bool AnalyticalPlacer::run(double timeLimit, Placement &pl) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+    // Half of what is left for the first refinement, all of it for the second.
+    auto budget = [&](double share) {
+        return (timeLimit > 0) ? std::max(1e-3, share * (timeLimit - elapsed())) : -1.0;
+    };
+
+    double wl = 0;
+    const bool global = globalPlace(timeLimit, pl);
+    if (global) {
+        wl = LocalSearch(m_prob).run(pl, budget(0.5));
+        printf("Analytical: refined wirelength %.1f (%.3fs)\n", wl, elapsed());
+    }
+
+    Placement base;
+    if (LocalSearch::initialPlacement(m_prob, base) && isPlacementLegal(m_prob, base)) {
+        double baseWl = LocalSearch(m_prob).run(base, budget(1.0));
+        printf("Analytical: constructive start refined to %.1f (%.3fs)\n", baseWl, elapsed());
+        if (!global || baseWl < wl) {
+            pl = base;
+            wl = baseWl;
+        }
+    }
+    else if (!global) {
+        return false;
+    }
+    return isPlacementLegal(m_prob, pl);
+}
+
+/**
+ * @brief Alternate the anchored quadratic solves and the legalization.
+ *
+ * @param timeLimit seconds; <= 0: no limit. The first legalization always runs.
+ * @param pl the shortest legal placement found.
+ * @return true if one was found.
+ */
+bool AnalyticalPlacer::globalPlace(double timeLimit, Placement &pl) {
+    const int n = m_prob.numCells();
+    if (n == 0 || n > m_prob.numFreeSites()) {
+        printf("ERR: Analytical: %d cells for %d free sites.\n", n, m_prob.numFreeSites());
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+
+    // The array spread over the site grid; the first, weakly anchored solve shrinks it to a compact mesh.
+    std::vector<double> posY(n), posX(n);
+    for (int i = 0; i < m_prob.arraySizeY; i++) {
+        for (int j = 0; j < m_prob.arraySizeX; j++) {
+            posY[m_prob.cellId(i, j)] = m_coordY.front() + (m_coordY.back() - m_coordY.front()) * (i + 0.5) / m_prob.arraySizeY;
+            posX[m_prob.cellId(i, j)] = m_coordX.front() + (m_coordX.back() - m_coordX.front()) * (j + 0.5) / m_prob.arraySizeX;
+        }
+    }
+    std::vector<double> anchorY = posY, anchorX = posX;
+
+    double bestWl = 0;
+    Placement cur;
+    double factor = 0.01;
+    for (m_iterations = 1; m_iterations <= m_maxIterations; m_iterations++, factor *= 1.6) {
+        solveAxis(true, factor, anchorY, posY);
+        solveAxis(false, factor, anchorX, posX);
+        legalize(posY, posX, cur);
+        if (!isPlacementLegal(m_prob, cur)) {
+            LocalSearch::repairRelativeOrder(m_prob, cur);
+        }
+
+        const double global = linearWirelength(posY, posX);
+        const bool legal = isPlacementLegal(m_prob, cur);
+        const double wl = placementWirelength(m_prob, cur);
+        if (legal && (pl.empty() || wl < bestWl)) {
+            pl = cur;
+            bestWl = wl;
+        }
+        for (int c = 0; c < n; c++) {
+            anchorY[c] = m_coordY[cur.y(c)];
+            anchorX[c] = m_coordX[cur.x(c)];
+        }
+        // Done once the legalization costs little over the continuous solution.
+        if ((legal && wl <= 1.05 * global) || (timeLimit > 0 && elapsed() >= timeLimit)) {
+            break;
+        }
+    }
+    m_iterations = std::min(m_iterations, m_maxIterations);
+    if (pl.empty()) {
+        printf("ERR: Analytical: no legalization met the relative constraints.\n");
+        return false;
+    }
+    printf("Analytical: legalized wirelength %.1f after %d iterations (%.3fs)\n", bestWl, m_iterations, elapsed());
+    return true;
+}
+
+/**
+ * @brief One axis of the anchored quadratic program:
+ * min sum_e w_e (v_a - v_b)^2 + alpha sum_c (v_c - anchor_c)^2, with w_e = weight / max(|v_a - v_b|, 1) at the
+ * current <pos> and alpha = <anchorFactor> times the mean diagonal of the edge Laplacian.
+ *
+ * @param isY
+ * @param anchorFactor
+ * @param anchor
+ * @param pos current coordinates in, the solution out.
+ */
+void AnalyticalPlacer::solveAxis(bool isY, double anchorFactor, const std::vector<double> &anchor, std::vector<double> &pos) const {
+    typedef Eigen::SparseMatrix<double> SpMat;
+    const int n = m_prob.numCells();
+    const double weight = isY ? m_prob.weightY : m_prob.weightX;
+    const std::vector<double> &coords = isY ? m_coordY : m_coordX;
+    if (coords.size() == 1 || weight <= 0) {
+        std::fill(pos.begin(), pos.end(), coords.front());
+        return;
+    }
+
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(2 * m_edges.size() + n);
+    std::vector<double> diag(n, 0);
+    for (const std::pair<int, int> &e: m_edges) {
+        const double w = weight / std::max(std::fabs(pos[e.first] - pos[e.second]), 1.0);
+        triplets.push_back(Eigen::Triplet<double>(e.first, e.second, -w));
+        triplets.push_back(Eigen::Triplet<double>(e.second, e.first, -w));
+        diag[e.first] += w;
+        diag[e.second] += w;
+    }
+    double mean = 0;
+    for (double d: diag) {
+        mean += d;
+    }
+    const double alpha = anchorFactor * std::max(mean / n, 1e-9);
+    Eigen::VectorXd rhs(n), guess(n);
+    for (int c = 0; c < n; c++) {
+        triplets.push_back(Eigen::Triplet<double>(c, c, diag[c] + alpha));
+        rhs[c] = alpha * anchor[c];
+        guess[c] = pos[c];
+    }
+    SpMat a(n, n);
+    a.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen::ConjugateGradient<SpMat, Eigen::Lower | Eigen::Upper> cg;
+    cg.setTolerance(1e-6);
+    cg.compute(a);
+    Eigen::VectorXd v = cg.solveWithGuess(rhs, guess);
+    for (int c = 0; c < n; c++) {
+        pos[c] = std::min(coords.back(), std::max(coords.front(), v[c]));
+    }
+}
+
+/**
+ * @brief Assign every cell a free site near its coordinates by recursive bisection of the site grid.
+ * Ties are broken by the array index along the cut, which keeps the relative constraints where the coordinates do.
+ *
+ * @param posY
+ * @param posX
+ * @param pl
+ */
+void AnalyticalPlacer::legalize(const std::vector<double> &posY, const std::vector<double> &posX, Placement &pl) const {
+    pl.resize(m_prob);
+    std::vector<int> cells(m_prob.numCells());
+    for (int c = 0; c < m_prob.numCells(); c++) {
+        cells[c] = c;
+    }
+    bisect(cells, 0, m_prob.siteSizeY, 0, m_prob.siteSizeX, posY, posX, pl);
+}
+
+/**
+ * @brief Place <cells> on the free sites of [y0, y1) x [x0, x1), which has room for them.
+ * The longer side (in sites) is cut in half; the cells whose coordinate falls below the cut go low, moved across it
+ * by rank only as far as the free sites of each half demand.
+ *
+ */
+void AnalyticalPlacer::bisect(std::vector<int> &cells, int y0, int y1, int x0, int x1,
+                              const std::vector<double> &posY, const std::vector<double> &posX, Placement &pl) const {
+    if (cells.empty()) {
+        return;
+    }
+    if (y1 - y0 == 1 && x1 - x0 == 1) {
+        pl.y(cells[0]) = y0;
+        pl.x(cells[0]) = x0;
+        return;
+    }
+
+    const bool cutY = (y1 - y0 >= x1 - x0);
+    const std::vector<double> &pos = cutY ? posY : posX;
+    const int nx = m_prob.arraySizeX;
+    std::sort(cells.begin(), cells.end(), [&](int a, int b) {
+        if (pos[a] != pos[b]) return pos[a] < pos[b];
+        if (cutY && a / nx != b / nx) return a / nx < b / nx;
+        if (!cutY && a % nx != b % nx) return a % nx < b % nx;
+        return a < b;
+    });
+
+    int mid, capLow, capHigh;
+    double boundary;
+    if (cutY) {
+        mid = (y0 + y1) / 2;
+        capLow = freeSites(y0, mid, x0, x1);
+        capHigh = freeSites(mid, y1, x0, x1);
+        boundary = 0.5 * (m_coordY[mid - 1] + m_coordY[mid]);
+    }
+    else {
+        mid = (x0 + x1) / 2;
+        capLow = freeSites(y0, y1, x0, mid);
+        capHigh = freeSites(y0, y1, mid, x1);
+        boundary = 0.5 * (m_coordX[mid - 1] + m_coordX[mid]);
+    }
+    const int n = cells.size();
+    int k = std::lower_bound(cells.begin(), cells.end(), boundary, [&](int c, double b) { return pos[c] < b; }) - cells.begin();
+    k = std::min(capLow, std::max(n - capHigh, k));
+
+    std::vector<int> low(cells.begin(), cells.begin() + k), high(cells.begin() + k, cells.end());
+    if (cutY) {
+        bisect(low, y0, mid, x0, x1, posY, posX, pl);
+        bisect(high, mid, y1, x0, x1, posY, posX, pl);
+    }
+    else {
+        bisect(low, y0, y1, x0, mid, posY, posX, pl);
+        bisect(high, y0, y1, mid, x1, posY, posX, pl);
+    }
+}
+
+int AnalyticalPlacer::freeSites(int y0, int y1, int x0, int x1) const {
+    const int w = m_prob.siteSizeX + 1;
+    return m_freePrefix[y1 * w + x1] - m_freePrefix[y0 * w + x1] - m_freePrefix[y1 * w + x0] + m_freePrefix[y0 * w + x0];
+}
+
+double AnalyticalPlacer::linearWirelength(const std::vector<double> &posY, const std::vector<double> &posX) const {
+    double wl = 0;
+    for (const std::pair<int, int> &e: m_edges) {
+        wl += m_prob.weightY * std::fabs(posY[e.first] - posY[e.second]) + m_prob.weightX * std::fabs(posX[e.first] - posX[e.second]);
+    }
+    return wl;
+}
+
+
+/**
+ * @brief Time AnalyticalPlacer on <prob>: the global placement alone, run() (which also tries the constructive start),
+ * and the proportional start of LocalSearch.
+ *
+ * @param prob
+ */
+void benchmarkAnalytical(const PlacementProblem &prob) {
+    printf("Analytical benchmark: %d x %d => %d x %d, weights %g / %g\n", prob.arraySizeY, prob.arraySizeX,
+        prob.siteSizeY, prob.siteSizeX, prob.weightX, prob.weightY);
+    if (prob.numCells() > prob.numSites() || prob.numCells() == 0) {
+        printf("ERR: invalid benchmark size.\n");
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto lap = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        return d.count();
+    };
+    AnalyticalPlacer analytical(prob);
+    Placement pl;
+    if (!analytical.globalPlace(-1, pl)) {
+        return;
+    }
+    printf("  global placement: wirelength %.1f, legal %d, %d iterations, %.3fs\n", placementWirelength(prob, pl),
+        (int)isPlacementLegal(prob, pl), analytical.iterations(), lap());
+    double wl = LocalSearch(prob).run(pl, -1);
+    printf("  refined: wirelength %.1f, %.3fs\n", wl, lap());
+    if (analytical.run(-1, pl)) {
+        printf("  run(): wirelength %.1f, %.3fs\n", placementWirelength(prob, pl), lap());
+    }
+
+    Placement base;
+    if (LocalSearch::initialPlacement(prob, base)) {
+        printf("  proportional start: wirelength %.1f", placementWirelength(prob, base));
+        lap();
+        wl = LocalSearch(prob).run(base, -1);
+        printf(", refined %.1f, %.3fs\n", wl, lap());
+    }
+}
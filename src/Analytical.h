@@ -0,0 +1,52 @@
+#ifndef __ANALYTICAL_H__
+#define __ANALYTICAL_H__
+
+#include "Placement.h"
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Analytical global placement for a site grid, in the spirit of SimPL. Cells get continuous coordinates
+ * (physical site coordinates, or site indices for unit-spaced sites) minimizing the quadratic wirelength of the array
+ * mesh, with edge weights weight / |distance| from the previous solution so that the quadratic tracks the Manhattan
+ * wirelength. The two axes are independent sparse systems solved by Eigen's conjugate gradient.
+ * Density comes from spreading: the solution is legalized by recursive bisection of the site grid (each cut keeps the
+ * cells on the side their coordinate falls on unless that side has too few free sites), and the next solve is pulled
+ * towards the legalized sites by anchors of growing weight. The shortest legalized placement is refined by LocalSearch,
+ * and so is the constructive start of LocalSearch: on small, nearly full grids the proportional placement is often
+ * shorter, and run() returns the better of the two.
+ *
+ */
+class AnalyticalPlacer
+{
+public:
+    explicit AnalyticalPlacer(const PlacementProblem &prob);
+
+    void    setIterations(int iterations) { m_maxIterations = iterations; }
+
+    bool    run(double timeLimit, Placement &pl);
+    bool    globalPlace(double timeLimit, Placement &pl);
+    void    legalize(const std::vector<double> &posY, const std::vector<double> &posX, Placement &pl) const;
+    int     iterations() const { return m_iterations; }
+
+private:
+    void    solveAxis(bool isY, double anchorFactor, const std::vector<double> &anchor, std::vector<double> &pos) const;
+    void    bisect(std::vector<int> &cells, int y0, int y1, int x0, int x1,
+                   const std::vector<double> &posY, const std::vector<double> &posX, Placement &pl) const;
+    int     freeSites(int y0, int y1, int x0, int x1) const;
+    double  linearWirelength(const std::vector<double> &posY, const std::vector<double> &posX) const;
+
+    PlacementProblem    m_prob;
+    std::vector<std::pair<int, int>>    m_edges; // Array neighbors (c0, c1).
+    std::vector<double> m_coordY; // Coordinate of every site row / column.
+    std::vector<double> m_coordX;
+    std::vector<int>    m_freePrefix; // Free sites in [0, sy) x [0, sx) at sy * (siteSizeX + 1) + sx.
+    int                 m_maxIterations = 30;
+    int                 m_iterations = 0;
+};
+
+void    benchmarkAnalytical(const PlacementProblem &prob);
+
+
+#endif
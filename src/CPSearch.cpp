@@ -0,0 +1,645 @@
+#include "CPSearch.h"
+#include "LocalSearch.h"
+#include "Presolve.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+
+namespace {
+
+double wallTime() {
+    std::chrono::duration<double> d = std::chrono::steady_clock::now().time_since_epoch();
+    return d.count();
+}
+
+} // namespace
+
+
+CPPlacer::CPPlacer(const PlacementProblem &prob)
+    : m_prob(prob), m_pending(0), m_idle(0), m_stop(false), m_best(0)
+{
+    m_numCells = prob.numCells();
+    m_numSites = prob.siteSizeY;
+    m_words = (m_numSites + 63) / 64;
+
+    m_adj.resize(m_numCells);
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c = prob.cellId(i, j);
+            if (j + 1 < prob.arraySizeX) {
+                m_edges.push_back(std::make_pair(c, prob.cellId(i, j + 1)));
+            }
+            if (i + 1 < prob.arraySizeY) {
+                m_edges.push_back(std::make_pair(c, prob.cellId(i + 1, j)));
+            }
+        }
+    }
+    for (const std::pair<int, int> &e: m_edges) {
+        m_adj[e.first].push_back(e.second);
+        m_adj[e.second].push_back(e.first);
+    }
+
+    // Precedences: the ROC chains, and for a square array y(0,1) < y(1,0) against the transposed solution.
+    // Both lists are sorted by the first cell, a topological order of the grid.
+    const bool square = (prob.arraySizeY == prob.arraySizeX && prob.arraySizeY >= 2);
+    if (prob.strictOrderY) {
+        m_before = m_edges;
+    }
+    if (square) {
+        m_before.push_back(std::make_pair(prob.cellId(0, 1), prob.cellId(1, 0)));
+        std::stable_sort(m_before.begin(), m_before.end());
+    }
+
+    m_coef.assign(m_numCells, 0);
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        m_coef[prob.cellId(i, prob.arraySizeX - 1)]++;
+        m_coef[prob.cellId(i, 0)]--;
+    }
+    for (int j = 0; j < prob.arraySizeX; j++) {
+        m_coef[prob.cellId(prob.arraySizeY - 1, j)]++;
+        m_coef[prob.cellId(0, j)]--;
+    }
+
+    m_minGap = 1;
+    if (prob.geometry) {
+        m_minGap = prob.distY(0, std::min(1, m_numSites - 1));
+        for (int s = 1; s + 1 < m_numSites; s++) {
+            m_minGap = std::min(m_minGap, prob.distY(s, s + 1));
+        }
+    }
+}
+
+/**
+ * @brief Search for the placement with the minimum wirelength.
+ *
+ * @param timeLimit seconds; <= 0 for an exhaustive search.
+ * @param pl the best placement found.
+ * @return true if a placement was found (certified() tells whether it is optimal).
+ */
+bool CPPlacer::run(double timeLimit, Placement &pl) {
+    if (m_prob.siteSizeX != 1) {
+        printf("ERR: CP: only for one column.\n");
+        return false;
+    }
+    m_timeLimit = timeLimit;
+    m_startTime = wallTime();
+
+    // Root domains: free rows within the ROC presolve bounds.
+    RocPresolve presolve(m_prob);
+    m_rootDom.assign((size_t)m_numCells * m_words, 0);
+    for (int c = 0; c < m_numCells; c++) {
+        uint64_t *d = domain(m_rootDom, c);
+        for (int s = presolve.lowerY(c); s <= presolve.upperY(c); s++) {
+            if (!m_prob.isSiteBlocked(s, 0)) {
+                d[s / 64] |= 1ULL << (s % 64);
+            }
+        }
+    }
+    // Unit-spaced rows without ROC: a mirrored placement costs the same, keep cell 0 in the lower half.
+    if (!m_prob.strictOrderY && !m_prob.geometry) {
+        uint64_t *d = domain(m_rootDom, 0);
+        for (int s = (m_numSites + 1) / 2; s < m_numSites; s++) {
+            d[s / 64] &= ~(1ULL << (s % 64));
+        }
+    }
+    if (!propagate(m_rootDom)) {
+        printf("CP: infeasible at the root.\n");
+        m_certified = true;
+        return false;
+    }
+    m_lowerBound = bound(m_rootDom);
+
+    // Incumbent: the given start if legal, else a refined constructive placement.
+    m_best = 1e300;
+    m_bestPl = Placement();
+    Placement start = m_start;
+    if (start.empty() || !isPlacementLegal(m_prob, start)) {
+        start = Placement();
+        if (LocalSearch::initialPlacement(m_prob, start)) {
+            LocalSearch(m_prob).run(start, -1);
+        }
+    }
+    if (!start.empty() && isPlacementLegal(m_prob, start)) {
+        m_bestPl = start;
+        m_best = placementWirelength(m_prob, start);
+    }
+    printf("CP: %d cells on %d rows, root bound %.1f, start %.1f, %d threads%s\n", m_numCells, m_numSites, m_lowerBound,
+        m_bestPl.empty() ? -1.0 : m_best.load(), std::max(1, m_threads), (timeLimit > 0) ? "" : ", exhaustive");
+
+    const int threads = std::max(1, m_threads);
+    m_workers.clear();
+    for (int t = 0; t < threads; t++) {
+        m_workers.emplace_back(new Worker());
+        m_workers.back()->dom.resize(m_numCells + 2);
+    }
+    m_stop = false;
+    m_idle = 0;
+    m_pending = 1;
+    m_workers[0]->tasks.push_back(Decisions());
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back(&CPPlacer::workerLoop, this, t);
+    }
+    for (std::thread &t: pool) {
+        t.join();
+    }
+
+    m_numNodes = 0;
+    for (const std::unique_ptr<Worker> &w: m_workers) {
+        m_numNodes += w->nodes;
+    }
+    m_certified = !m_stop;
+    if (m_certified) {
+        m_lowerBound = m_bestPl.empty() ? 1e300 : m_best.load();
+    }
+    printf("CP: %s, wirelength %.1f, bound %.1f, %lld nodes, %.2fs\n", m_certified ? "optimal (search complete)" : "time limit",
+        m_bestPl.empty() ? -1.0 : m_best.load(), m_lowerBound, m_numNodes, wallTime() - m_startTime);
+
+    if (m_bestPl.empty()) {
+        return false;
+    }
+    pl = m_bestPl;
+    return true;
+}
+
+int CPPlacer::count(const uint64_t *d) const {
+    int n = 0;
+    for (int k = 0; k < m_words; k++) {
+        n += __builtin_popcountll(d[k]);
+    }
+    return n;
+}
+
+int CPPlacer::first(const uint64_t *d) const {
+    return nextAtOrAbove(d, 0);
+}
+
+int CPPlacer::last(const uint64_t *d) const {
+    return nextAtOrBelow(d, m_numSites - 1);
+}
+
+/**
+ * @brief Smallest row >= s in the domain, -1 if none.
+ *
+ */
+int CPPlacer::nextAtOrAbove(const uint64_t *d, int s) const {
+    if (s < 0) {
+        s = 0;
+    }
+    if (s >= m_numSites) {
+        return -1;
+    }
+    int k = s / 64;
+    uint64_t w = d[k] & (~0ULL << (s % 64));
+    while (true) {
+        if (w) {
+            return k * 64 + __builtin_ctzll(w);
+        }
+        if (++k >= m_words) {
+            return -1;
+        }
+        w = d[k];
+    }
+}
+
+/**
+ * @brief Largest row <= s in the domain, -1 if none.
+ *
+ */
+int CPPlacer::nextAtOrBelow(const uint64_t *d, int s) const {
+    if (s >= m_numSites) {
+        s = m_numSites - 1;
+    }
+    if (s < 0) {
+        return -1;
+    }
+    int k = s / 64;
+    uint64_t w = d[k] & ((s % 64 == 63) ? ~0ULL : ((1ULL << (s % 64 + 1)) - 1));
+    while (true) {
+        if (w) {
+            return k * 64 + 63 - __builtin_clzll(w);
+        }
+        if (--k < 0) {
+            return -1;
+        }
+        w = d[k];
+    }
+}
+
+/**
+ * @brief Distance from row s to the nearest row of the domain.
+ *
+ */
+double CPPlacer::nearest(const uint64_t *d, int s) const {
+    int lo = nextAtOrBelow(d, s), hi = nextAtOrAbove(d, s);
+    double best = 1e300;
+    if (lo >= 0) {
+        best = m_prob.distY(lo, s);
+    }
+    if (hi >= 0) {
+        best = std::min(best, m_prob.distY(hi, s));
+    }
+    return best;
+}
+
+bool CPPlacer::assign(std::vector<uint64_t> &dom, int c, int s) const {
+    uint64_t *d = domain(dom, c);
+    if (!(d[s / 64] >> (s % 64) & 1)) {
+        return false;
+    }
+    std::fill(d, d + m_words, 0);
+    d[s / 64] = 1ULL << (s % 64);
+    return propagate(dom);
+}
+
+/**
+ * @brief Propagate to a fixpoint: assigned rows leave all other domains, precedence bounds (forward for the lower,
+ * backward for the upper bounds), pigeonhole on the union of the domains.
+ *
+ * @param dom
+ * @return false if a domain became empty or the cells do not fit.
+ */
+bool CPPlacer::propagate(std::vector<uint64_t> &dom) const {
+    std::vector<uint64_t> taken(m_words), all(m_words);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        // All-different on the assigned cells.
+        std::fill(taken.begin(), taken.end(), 0);
+        for (int c = 0; c < m_numCells; c++) {
+            const uint64_t *d = domain(dom, c);
+            if (count(d) == 1) {
+                for (int k = 0; k < m_words; k++) {
+                    if (taken[k] & d[k]) {
+                        return false;
+                    }
+                    taken[k] |= d[k];
+                }
+            }
+        }
+        for (int c = 0; c < m_numCells; c++) {
+            uint64_t *d = domain(dom, c);
+            int n = count(d);
+            if (n <= 1) {
+                if (n == 0) {
+                    return false;
+                }
+                continue;
+            }
+            bool shrunk = false;
+            for (int k = 0; k < m_words; k++) {
+                if (d[k] & taken[k]) {
+                    d[k] &= ~taken[k];
+                    shrunk = true;
+                }
+            }
+            if (shrunk) {
+                int m = count(d);
+                if (m == 0) {
+                    return false;
+                }
+                changed |= (m == 1);
+            }
+        }
+
+        // Precedence: y(a) < y(b).
+        for (size_t e = 0; e < m_before.size(); e++) {
+            int lo = first(domain(dom, m_before[e].first));
+            uint64_t *d = domain(dom, m_before[e].second);
+            for (int k = 0; k < m_words && k * 64 <= lo; k++) {
+                uint64_t mask = (lo + 1 >= (k + 1) * 64) ? ~0ULL : ((1ULL << (lo + 1 - k * 64)) - 1);
+                if (d[k] & mask) {
+                    d[k] &= ~mask;
+                    changed = true;
+                }
+            }
+        }
+        for (size_t e = m_before.size(); e-- > 0; ) {
+            int hi = last(domain(dom, m_before[e].second));
+            uint64_t *d = domain(dom, m_before[e].first);
+            for (int k = m_words - 1; k >= 0 && (k + 1) * 64 > hi; k--) {
+                uint64_t mask = (hi <= k * 64) ? ~0ULL : ~((1ULL << (hi - k * 64)) - 1);
+                if (d[k] & mask) {
+                    d[k] &= ~mask;
+                    changed = true;
+                }
+            }
+        }
+
+        // Pigeonhole.
+        std::fill(all.begin(), all.end(), 0);
+        for (int c = 0; c < m_numCells; c++) {
+            const uint64_t *d = domain(dom, c);
+            for (int k = 0; k < m_words; k++) {
+                all[k] |= d[k];
+            }
+        }
+        int n = 0;
+        for (int k = 0; k < m_words; k++) {
+            n += __builtin_popcountll(all[k]);
+        }
+        if (n < m_numCells) {
+            return false;
+        }
+    }
+    for (int c = 0; c < m_numCells; c++) {
+        if (count(domain(dom, c)) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Lower bound of the wirelength under the domains (see the class comment). Exact when all cells are assigned.
+ *
+ * @param dom
+ * @return double
+ */
+double CPPlacer::bound(const std::vector<uint64_t> &dom) const {
+    std::vector<int> val(m_numCells, -1);
+    for (int c = 0; c < m_numCells; c++) {
+        const uint64_t *d = domain(dom, c);
+        if (count(d) == 1) {
+            val[c] = first(d);
+        }
+    }
+
+    // Edge bound per edge.
+    std::vector<double> edgeLb(m_edges.size());
+    for (size_t e = 0; e < m_edges.size(); e++) {
+        int a = m_edges[e].first, b = m_edges[e].second;
+        if (val[a] >= 0 && val[b] >= 0) {
+            edgeLb[e] = m_prob.distY(val[a], val[b]);
+        }
+        else if (val[a] >= 0) {
+            edgeLb[e] = nearest(domain(dom, b), val[a]);
+        }
+        else if (val[b] >= 0) {
+            edgeLb[e] = nearest(domain(dom, a), val[b]);
+        }
+        else {
+            edgeLb[e] = m_minGap;
+        }
+    }
+
+    double edgeSum = 0;
+    if (m_prob.strictOrderY) {
+        // Each array row and column is a strictly increasing chain, so its length is at least the span between its ends.
+        const int Y = m_prob.arraySizeY, X = m_prob.arraySizeX;
+        std::vector<double> rowSum(Y, 0), colSum(X, 0);
+        for (size_t e = 0; e < m_edges.size(); e++) {
+            int a = m_edges[e].first, b = m_edges[e].second;
+            if (a / X == b / X) {
+                rowSum[a / X] += edgeLb[e];
+            }
+            else {
+                colSum[a % X] += edgeLb[e];
+            }
+        }
+        for (int i = 0; i < Y; i++) {
+            int s0 = last(domain(dom, m_prob.cellId(i, 0))), s1 = first(domain(dom, m_prob.cellId(i, X - 1)));
+            double span = (s1 > s0) ? m_prob.distY(s0, s1) : 0;
+            edgeSum += std::max(rowSum[i], span);
+        }
+        for (int j = 0; j < X; j++) {
+            int s0 = last(domain(dom, m_prob.cellId(0, j))), s1 = first(domain(dom, m_prob.cellId(Y - 1, j)));
+            double span = (s1 > s0) ? m_prob.distY(s0, s1) : 0;
+            edgeSum += std::max(colSum[j], span);
+        }
+    }
+    else {
+        for (double l: edgeLb) {
+            edgeSum += l;
+        }
+    }
+
+    // Boundary bound: the positive cells on the lowest distinct rows above their lower bounds, the negative ones on the
+    // highest distinct rows below their upper bounds; multiplicities beyond one at the bounds themselves.
+    double boundarySum = 0;
+    if (m_prob.strictOrderY) {
+        std::vector<int> lo, hi;
+        for (int c = 0; c < m_numCells; c++) {
+            const uint64_t *d = domain(dom, c);
+            if (m_coef[c] > 0) {
+                lo.push_back(first(d));
+                boundarySum += (m_coef[c] - 1) * coordY(first(d));
+            }
+            else if (m_coef[c] < 0) {
+                hi.push_back(last(d));
+                boundarySum += (m_coef[c] + 1) * coordY(last(d));
+            }
+        }
+        std::sort(lo.begin(), lo.end());
+        std::sort(hi.begin(), hi.end());
+        for (int k = 0, v = -1; k < (int)lo.size(); k++) {
+            v = std::max(lo[k], v + 1);
+            if (v >= m_numSites) {
+                return 1e300;
+            }
+            boundarySum += coordY(v);
+        }
+        for (int k = hi.size() - 1, v = m_numSites; k >= 0; k--) {
+            v = std::min(hi[k], v - 1);
+            if (v < 0) {
+                return 1e300;
+            }
+            boundarySum -= coordY(v);
+        }
+    }
+
+    // Star bound: half the sum over cells of the lengths of their edges.
+    double starSum = 0;
+    for (int c = 0; c < m_numCells; c++) {
+        bool anyAssigned = (val[c] >= 0);
+        for (int n: m_adj[c]) {
+            anyAssigned |= (val[n] >= 0);
+        }
+        if (!anyAssigned) {
+            for (size_t k = 1; k <= m_adj[c].size(); k++) {
+                starSum += m_minGap * ((k + 1) / 2);
+            }
+            continue;
+        }
+        for (int n: m_adj[c]) {
+            if (val[c] >= 0 && val[n] >= 0) {
+                starSum += m_prob.distY(val[c], val[n]);
+            }
+            else if (val[c] >= 0) {
+                starSum += nearest(domain(dom, n), val[c]);
+            }
+            else if (val[n] >= 0) {
+                starSum += nearest(domain(dom, c), val[n]);
+            }
+            else {
+                starSum += m_minGap;
+            }
+        }
+    }
+
+    return m_prob.weightY * std::max(std::max(edgeSum, starSum / 2), boundarySum);
+}
+
+void CPPlacer::workerLoop(int id) {
+    Worker &w = *m_workers[id];
+    bool idle = false;
+    while (!m_stop) {
+        Decisions task;
+        if (nextTask(id, task)) {
+            if (idle) {
+                m_idle--;
+                idle = false;
+            }
+            runTask(w, task);
+            m_pending--;
+            continue;
+        }
+        if (!idle) {
+            m_idle++;
+            idle = true;
+        }
+        if (m_pending == 0) {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    if (idle) {
+        m_idle--;
+    }
+}
+
+/**
+ * @brief The newest task of worker <id>, or else the oldest task of another worker.
+ *
+ */
+bool CPPlacer::nextTask(int id, Decisions &task) {
+    {
+        Worker &w = *m_workers[id];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.tasks.empty()) {
+            task = w.tasks.back();
+            w.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < m_workers.size(); k++) {
+        Worker &v = *m_workers[(id + k) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(v.mutex);
+        if (!v.tasks.empty()) {
+            task = v.tasks.front();
+            v.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Replay the decisions of a task from the root domains and search its subtree.
+ *
+ */
+void CPPlacer::runTask(Worker &w, const Decisions &task) {
+    w.dom[0] = m_rootDom;
+    for (const std::pair<int, int> &d: task) {
+        if (!assign(w.dom[0], d.first, d.second)) {
+            return;
+        }
+    }
+    w.decisions = task;
+    search(w, 0);
+}
+
+void CPPlacer::search(Worker &w, int depth) {
+    const std::vector<uint64_t> &dom = w.dom[depth];
+    if ((++w.nodes & 1023) == 0 && m_timeLimit > 0 && wallTime() - m_startTime >= m_timeLimit) {
+        m_stop = true;
+    }
+    if (m_stop || bound(dom) >= m_best - 1e-9) {
+        return;
+    }
+
+    // Boundary cells (the wirelength terms) first, then the smallest domain, ties to the cell with the most assigned neighbors.
+    int cell = -1, bestSize = 0, bestLinks = 0;
+    bool bestBoundary = false;
+    for (int c = 0; c < m_numCells; c++) {
+        int n = count(domain(dom, c));
+        if (n == 1) {
+            continue;
+        }
+        bool boundary = m_prob.strictOrderY && m_coef[c] != 0;
+        int links = 0;
+        for (int a: m_adj[c]) {
+            links += (count(domain(dom, a)) == 1);
+        }
+        if (cell < 0 || (boundary && !bestBoundary)
+            || (boundary == bestBoundary && (n < bestSize || (n == bestSize && links > bestLinks)))) {
+            cell = c;
+            bestSize = n;
+            bestLinks = links;
+            bestBoundary = boundary;
+        }
+    }
+    if (cell < 0) {
+        offer(dom);
+        return;
+    }
+
+    // Cheapest rows first: the distance to the assigned neighbors.
+    std::vector<std::pair<double, int>> values;
+    const uint64_t *d = domain(dom, cell);
+    for (int s = first(d); s >= 0; s = nextAtOrAbove(d, s + 1)) {
+        double cost = 0;
+        for (int a: m_adj[cell]) {
+            const uint64_t *da = domain(dom, a);
+            if (count(da) == 1) {
+                cost += m_prob.distY(s, first(da));
+            }
+        }
+        values.push_back(std::make_pair(cost, s));
+    }
+    std::sort(values.begin(), values.end());
+
+    for (size_t k = 0; k < values.size() && !m_stop; k++) {
+        // Hand the untried siblings to idle workers.
+        if (k + 1 < values.size() && m_idle > 0) {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (w.tasks.empty()) {
+                for (size_t r = values.size(); r-- > k + 1; ) {
+                    Decisions task = w.decisions;
+                    task.push_back(std::make_pair(cell, values[r].second));
+                    m_pending++;
+                    w.tasks.push_back(task);
+                }
+                values.resize(k + 1);
+            }
+        }
+        w.dom[depth + 1] = dom;
+        if (assign(w.dom[depth + 1], cell, values[k].second)) {
+            w.decisions.push_back(std::make_pair(cell, values[k].second));
+            search(w, depth + 1);
+            w.decisions.pop_back();
+        }
+    }
+}
+
+/**
+ * @brief A complete assignment: keep it if it is the best so far.
+ *
+ */
+void CPPlacer::offer(const std::vector<uint64_t> &dom) {
+    Placement pl(m_prob);
+    for (int c = 0; c < m_numCells; c++) {
+        pl.x(c) = 0;
+        pl.y(c) = first(domain(dom, c));
+    }
+    double wl = placementWirelength(m_prob, pl);
+    std::lock_guard<std::mutex> lock(m_bestMutex);
+    if (wl < m_best - 1e-9) {
+        m_best = wl;
+        m_bestPl = pl;
+    }
+}
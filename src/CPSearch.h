@@ -0,0 +1,107 @@
+#ifndef __CPSEARCH_H__
+#define __CPSEARCH_H__
+
+#include "Placement.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Constraint-programming branch and bound for one column (siteSizeX == 1): a permutation of the cells onto the
+ * site rows, with the ROC as precedences y0 < y1 when PlacementProblem::strictOrderY is set.
+ *
+ * Domains are bitsets of site rows. Propagation: all-different (assigned rows leave every other domain, pigeonhole on
+ * the union), precedence bounds along the ROC chains, and a transpose / mirror symmetry break.
+ * The lower bound is the largest of
+ *  - the edge bound: exact for assigned ends, nearest domain row for half-assigned edges, the smallest row gap otherwise;
+ *  - the star bound: neighbors of a cell lie on distinct rows, so the k-th one is at least ceil(k/2) gaps away;
+ *  - with ROC, the boundary bound: the wirelength is then sum(coef * y) over the boundary cells (the spans of the rows
+ *    and columns, as in run3()), bounded by giving the positive cells the lowest and the negative cells the highest
+ *    distinct rows their domains allow.
+ *
+ * Search is depth-first, boundary cells first, smallest domain first, cheapest row first, on several threads with work stealing: a worker
+ * that sees idle threads donates its untried siblings to its deque, thieves take the oldest (largest) subtrees.
+ * Without a time limit the search is exhaustive and the result is a certified optimum.
+ *
+ */
+class CPPlacer
+{
+public:
+    explicit CPPlacer(const PlacementProblem &prob);
+
+    void    setThreads(int threads) { m_threads = threads; }
+    void    setStart(const Placement &pl) { m_start = pl; }
+
+    bool    run(double timeLimit, Placement &pl);
+
+    bool        certified() const { return m_certified; }
+    double      lowerBound() const { return m_lowerBound; }
+    long long   numNodes() const { return m_numNodes; }
+
+private:
+    typedef std::vector<std::pair<int, int>> Decisions; // (cell, site row) in assignment order.
+
+    struct Worker {
+        std::vector<std::vector<uint64_t>> dom; // Domains per search depth.
+        Decisions               decisions;
+        std::deque<Decisions>   tasks;
+        std::mutex              mutex;
+        long long               nodes = 0;
+    };
+
+    const uint64_t * domain(const std::vector<uint64_t> &dom, int c) const { return dom.data() + (size_t)c * m_words; }
+    uint64_t *  domain(std::vector<uint64_t> &dom, int c) const { return dom.data() + (size_t)c * m_words; }
+    int     count(const uint64_t *d) const;
+    int     first(const uint64_t *d) const;
+    int     last(const uint64_t *d) const;
+    int     nextAtOrAbove(const uint64_t *d, int s) const;
+    int     nextAtOrBelow(const uint64_t *d, int s) const;
+    double  nearest(const uint64_t *d, int s) const;
+    double  coordY(int s) const { return m_prob.geometry ? m_prob.geometry->coordY(s) : s; }
+
+    bool    assign(std::vector<uint64_t> &dom, int c, int s) const;
+    bool    propagate(std::vector<uint64_t> &dom) const;
+    double  bound(const std::vector<uint64_t> &dom) const;
+
+    void    workerLoop(int id);
+    bool    nextTask(int id, Decisions &task);
+    void    runTask(Worker &w, const Decisions &task);
+    void    search(Worker &w, int depth);
+    void    offer(const std::vector<uint64_t> &dom);
+
+    PlacementProblem    m_prob;
+    int                 m_numCells = 0;
+    int                 m_numSites = 0;
+    int                 m_words = 0;
+    std::vector<std::pair<int, int>>    m_edges; // Array neighbor edges.
+    std::vector<std::pair<int, int>>    m_before; // y(a) < y(b), in topological order.
+    std::vector<std::vector<int>>       m_adj;
+    std::vector<int>    m_coef; // With ROC: wirelength == weightY * sum(m_coef[c] * y(c)).
+    std::vector<uint64_t> m_rootDom;
+    double              m_minGap = 1;
+
+    int                 m_threads = 1;
+    Placement           m_start;
+    double              m_timeLimit = -1;
+    double              m_startTime = 0;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<int>    m_pending;
+    std::atomic<int>    m_idle;
+    std::atomic<bool>   m_stop;
+    std::atomic<double> m_best;
+    std::mutex          m_bestMutex;
+    Placement           m_bestPl;
+
+    bool                m_certified = false;
+    double              m_lowerBound = 0;
+    long long           m_numNodes = 0;
+};
+
+
+#endif
@@ -0,0 +1,336 @@
+#include "CostKernel.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+
+// Array shapes with a specialized kernel (arraySizeY, arraySizeX), each for one site column and for several.
+#define COST_KERNEL_SHAPES(F) \
+    F(4, 4) F(6, 6) F(8, 8) F(10, 10) F(12, 12) F(16, 16) F(20, 20) F(22, 22) F(24, 24) F(32, 32) F(40, 10)
+
+
+namespace {
+
+/**
+ * @brief Runtime-shaped kernel: any array, site geometry (distance tables) and neighbor checks per edge.
+ *
+ */
+class GenericCostKernel : public CostKernel
+{
+public:
+    explicit GenericCostKernel(const PlacementProblem &prob) : m_prob(prob) {}
+
+    const char * name() const { return "generic"; }
+
+    double wirelength(const int *x, const int *y) const {
+        double wl = 0;
+        for (int i = 0; i < m_prob.arraySizeY; i++) {
+            for (int j = 0; j < m_prob.arraySizeX; j++) {
+                const int c0 = m_prob.cellId(i, j);
+                if (i + 1 < m_prob.arraySizeY) {
+                    const int c1 = c0 + m_prob.arraySizeX;
+                    wl += m_prob.weightX * m_prob.distX(x[c0], x[c1]) + m_prob.weightY * m_prob.distY(y[c0], y[c1]);
+                }
+                if (j + 1 < m_prob.arraySizeX) {
+                    const int c1 = c0 + 1;
+                    wl += m_prob.weightX * m_prob.distX(x[c0], x[c1]) + m_prob.weightY * m_prob.distY(y[c0], y[c1]);
+                }
+            }
+        }
+        return wl;
+    }
+
+    double moveDelta(const int *x, const int *y, int c, int c2, int sy, int sx) const {
+        const int oy = y[c], ox = x[c];
+        double delta = 0;
+        // Cell <m> goes from (fy, fx) to (ty, tx); the edge to <other> keeps its length.
+        auto side = [&](int m, int other, int fy, int fx, int ty, int tx) {
+            const int i = m / m_prob.arraySizeX, j = m % m_prob.arraySizeX;
+            auto edge = [&](int n) {
+                if (n != other) {
+                    delta += m_prob.weightX * (m_prob.distX(tx, x[n]) - m_prob.distX(fx, x[n]))
+                           + m_prob.weightY * (m_prob.distY(ty, y[n]) - m_prob.distY(fy, y[n]));
+                }
+            };
+            if (i > 0) edge(m - m_prob.arraySizeX);
+            if (i + 1 < m_prob.arraySizeY) edge(m + m_prob.arraySizeX);
+            if (j > 0) edge(m - 1);
+            if (j + 1 < m_prob.arraySizeX) edge(m + 1);
+        };
+        side(c, c2, oy, ox, sy, sx);
+        if (c2 >= 0) {
+            side(c2, c, sy, sx, oy, ox);
+        }
+        return delta;
+    }
+
+private:
+    PlacementProblem    m_prob;
+};
+
+
+// Compile-time integer sequence 0 .. N-1, built in log(N) instantiation depth.
+template <int... Is> struct Seq {};
+template <typename A, typename B> struct Concat;
+template <int... A, int... B> struct Concat<Seq<A...>, Seq<B...>> { typedef Seq<A..., (int)sizeof...(A) + B...> type; };
+template <int N> struct MakeSeq {
+    typedef typename Concat<typename MakeSeq<N / 2>::type, typename MakeSeq<N - N / 2>::type>::type type;
+};
+template <> struct MakeSeq<0> { typedef Seq<> type; };
+template <> struct MakeSeq<1> { typedef Seq<0> type; };
+
+// Down, up, left and right neighbor of a cell; a missing neighbor is the cell itself (a zero-length edge).
+struct Neighbors {
+    int n[4];
+};
+
+template <int Y, int X>
+constexpr Neighbors neighborsOf(int c) {
+    return Neighbors{{(c / X > 0) ? c - X : c, (c / X + 1 < Y) ? c + X : c,
+                      (c % X > 0) ? c - 1 : c, (c % X + 1 < X) ? c + 1 : c}};
+}
+
+template <int Y, int X, typename S = typename MakeSeq<Y * X>::type> struct NeighborTable;
+template <int Y, int X, int... Is> struct NeighborTable<Y, X, Seq<Is...>> {
+    static constexpr Neighbors table[Y * X] = {neighborsOf<Y, X>(Is)...};
+};
+template <int Y, int X, int... Is> constexpr Neighbors NeighborTable<Y, X, Seq<Is...>>::table[Y * X];
+
+
+/**
+ * @brief Kernel compiled for a Y x X array with unit-spaced sites. OneColumn drops the x terms (all cells share
+ * site column 0). Distances are summed as integers and weighted once.
+ *
+ */
+template <int Y, int X, bool OneColumn>
+class ShapeCostKernel : public CostKernel
+{
+public:
+    explicit ShapeCostKernel(const PlacementProblem &prob) : m_weightX(prob.weightX), m_weightY(prob.weightY) {
+        snprintf(m_name, sizeof(m_name), "%dx%d%s", Y, X, OneColumn ? ", one column" : "");
+    }
+
+    const char * name() const { return m_name; }
+
+    double wirelength(const int *x, const int *y) const {
+        int sumX = 0, sumY = 0;
+        // Vertical edges (c, c + X) are contiguous; horizontal ones run along each row.
+        for (int c = 0; c < (Y - 1) * X; c++) {
+            sumY += abs(y[c] - y[c + X]);
+            if (!OneColumn) {
+                sumX += abs(x[c] - x[c + X]);
+            }
+        }
+        for (int i = 0; i < Y; i++) {
+            for (int j = 0; j + 1 < X; j++) {
+                const int c = i * X + j;
+                sumY += abs(y[c] - y[c + 1]);
+                if (!OneColumn) {
+                    sumX += abs(x[c] - x[c + 1]);
+                }
+            }
+        }
+        return m_weightX * sumX + m_weightY * sumY;
+    }
+
+    double moveDelta(const int *x, const int *y, int c, int c2, int sy, int sx) const {
+        const int oy = y[c], ox = x[c];
+        int dX = 0, dY = 0;
+        const Neighbors &a = NeighborTable<Y, X>::table[c];
+        for (int k = 0; k < 4; k++) {
+            const int n = a.n[k];
+            const int live = (n != c) & (n != c2);
+            dY += live * (abs(sy - y[n]) - abs(oy - y[n]));
+            if (!OneColumn) {
+                dX += live * (abs(sx - x[n]) - abs(ox - x[n]));
+            }
+        }
+        if (c2 >= 0) {
+            const Neighbors &b = NeighborTable<Y, X>::table[c2];
+            for (int k = 0; k < 4; k++) {
+                const int n = b.n[k];
+                const int live = (n != c2) & (n != c);
+                dY += live * (abs(oy - y[n]) - abs(sy - y[n]));
+                if (!OneColumn) {
+                    dX += live * (abs(ox - x[n]) - abs(sx - x[n]));
+                }
+            }
+        }
+        return m_weightX * dX + m_weightY * dY;
+    }
+
+private:
+    double  m_weightX;
+    double  m_weightY;
+    char    m_name[32];
+};
+
+} // namespace
+
+
+/**
+ * @brief The kernel for <prob>: specialized for a common array shape with unit-spaced sites, generic otherwise.
+ *
+ * @param prob
+ * @param allowSpecialized false forces the generic kernel (for comparison).
+ * @return std::shared_ptr<const CostKernel>
+ */
+std::shared_ptr<const CostKernel> makeCostKernel(const PlacementProblem &prob, bool allowSpecialized) {
+    if (allowSpecialized && !prob.geometry) {
+        const bool oneColumn = (prob.siteSizeX == 1);
+#define COST_KERNEL_CASE(Y, X) \
+        if (prob.arraySizeY == Y && prob.arraySizeX == X) { \
+            if (oneColumn) return std::make_shared<ShapeCostKernel<Y, X, true>>(prob); \
+            return std::make_shared<ShapeCostKernel<Y, X, false>>(prob); \
+        }
+        COST_KERNEL_SHAPES(COST_KERNEL_CASE)
+#undef COST_KERNEL_CASE
+    }
+    return std::make_shared<GenericCostKernel>(prob);
+}
+
+/**
+ * @brief Throughput of the generic and the specialized kernel (wirelength, move deltas, LocalSearch to convergence) on random
+ * placements, checked against placementWirelength().
+ *
+ * @param prob
+ * @param seconds run time of each timed variant.
+ */
+void benchmarkCostKernels(const PlacementProblem &prob, double seconds) {
+    const int numCells = prob.numCells();
+    std::shared_ptr<const CostKernel> generic = makeCostKernel(prob, false);
+    std::shared_ptr<const CostKernel> special = makeCostKernel(prob);
+    if (std::string(special->name()) == generic->name()) {
+        special = generic;
+    }
+    printf("Cost kernel benchmark: %d x %d => %d x %d, weights %g / %g, %.1fs per variant, kernel <%s>\n",
+        prob.arraySizeY, prob.arraySizeX, prob.siteSizeY, prob.siteSizeX, prob.weightX, prob.weightY, seconds, special->name());
+    if (numCells > prob.numSites() || numCells == 0) {
+        printf("ERR: invalid benchmark size.\n");
+        return;
+    }
+
+    // Random overlap-free placements and random moves on them.
+    const int numPls = 64, numMoves = 4096;
+    std::mt19937 rng(1);
+    std::vector<int> sites(prob.numSites());
+    for (size_t s = 0; s < sites.size(); s++) {
+        sites[s] = s;
+    }
+    std::vector<Placement> pls(numPls, Placement(prob));
+    std::vector<std::vector<int>> siteCell(numPls, std::vector<int>(prob.numSites(), -1));
+    for (int p = 0; p < numPls; p++) {
+        std::shuffle(sites.begin(), sites.end(), rng);
+        for (int c = 0; c < numCells; c++) {
+            pls[p].y(c) = sites[c] / prob.siteSizeX;
+            pls[p].x(c) = sites[c] % prob.siteSizeX;
+            siteCell[p][sites[c]] = c;
+        }
+    }
+    struct Move { int p, c, c2, sy, sx; };
+    std::vector<Move> moves(numMoves);
+    for (Move &m: moves) {
+        m.p = rng() % numPls;
+        m.c = rng() % numCells;
+        do {
+            m.sy = rng() % prob.siteSizeY;
+            m.sx = rng() % prob.siteSizeX;
+            m.c2 = siteCell[m.p][prob.siteId(m.sy, m.sx)];
+        } while (m.c2 == m.c);
+    }
+
+    // Correctness: wirelength against placementWirelength(), deltas against the wirelength after the move.
+    double maxErr = 0;
+    for (const CostKernel *k: {generic.get(), special.get()}) {
+        for (const Placement &pl: pls) {
+            maxErr = std::max(maxErr, std::fabs(k->wirelength(pl.xs().data(), pl.ys().data()) - placementWirelength(prob, pl)));
+        }
+        for (int t = 0; t < 256; t++) {
+            const Move &m = moves[t];
+            Placement pl = pls[m.p];
+            const double before = placementWirelength(prob, pl);
+            const double delta = k->moveDelta(pl.xs().data(), pl.ys().data(), m.c, m.c2, m.sy, m.sx);
+            if (m.c2 >= 0) {
+                pl.y(m.c2) = pl.y(m.c);
+                pl.x(m.c2) = pl.x(m.c);
+            }
+            pl.y(m.c) = m.sy;
+            pl.x(m.c) = m.sx;
+            maxErr = std::max(maxErr, std::fabs(before + delta - placementWirelength(prob, pl)));
+        }
+    }
+    printf("  max error against placementWirelength(): %g\n", maxErr);
+
+    auto timeIt = [&](const char *label, int batch, std::function<double()> body) {
+        long long evals = 0;
+        double sink = 0, elapsed = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (elapsed < seconds) {
+            sink += body();
+            evals += batch;
+            std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+            elapsed = d.count();
+        }
+        printf("  %-36s %14.0f evals/s  (checksum %g)\n", label, evals / elapsed, sink / (evals / batch));
+        return evals / elapsed;
+    };
+    auto wirelengthLoop = [&](const CostKernel *k) {
+        return [&, k]() {
+            double s = 0;
+            for (const Placement &pl: pls) {
+                s += k->wirelength(pl.xs().data(), pl.ys().data());
+            }
+            return s;
+        };
+    };
+    auto deltaLoop = [&](const CostKernel *k) {
+        return [&, k]() {
+            double s = 0;
+            for (const Move &m: moves) {
+                s += k->moveDelta(pls[m.p].xs().data(), pls[m.p].ys().data(), m.c, m.c2, m.sy, m.sx);
+            }
+            return s;
+        };
+    };
+
+    double base = timeIt("wirelength, placementWirelength()", numPls, [&]() {
+        double s = 0;
+        for (const Placement &pl: pls) {
+            s += placementWirelength(prob, pl);
+        }
+        return s;
+    });
+    double g = timeIt("wirelength, generic kernel", numPls, wirelengthLoop(generic.get()));
+    if (special != generic) {
+        double s = timeIt("wirelength, specialized kernel", numPls, wirelengthLoop(special.get()));
+        printf("  wirelength speedup: %.2fx over placementWirelength(), %.2fx over the generic kernel\n", s / base, s / g);
+    }
+    g = timeIt("move delta, generic kernel", numMoves, deltaLoop(generic.get()));
+    if (special != generic) {
+        double s = timeIt("move delta, specialized kernel", numMoves, deltaLoop(special.get()));
+        printf("  move delta speedup: %.2fx\n", s / g);
+    }
+
+    // LocalSearch to convergence from the same random placement with either kernel; the trajectories match.
+    if (!prob.relativeConstraintX && !prob.relativeConstraintY) {
+        for (const std::shared_ptr<const CostKernel> &k: {generic, special}) {
+            Placement pl = pls[0];
+            LocalSearch ls(prob);
+            ls.setKernel(k);
+            auto t0 = std::chrono::steady_clock::now();
+            double wl = ls.run(pl, -1);
+            std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+            printf("  LocalSearch, %s kernel: wirelength %.1f in %.3fs\n", k->name(), wl, d.count());
+            if (special == generic) {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef __COSTKERNEL_H__
+#define __COSTKERNEL_H__
+
+#include "Placement.h"
+#include <memory>
+
+
+/**
+ * @brief Wirelength and move-delta evaluation of one problem. makeCostKernel() returns a kernel compiled for the
+ * array shape when it is one of the common ones (see COST_KERNEL_SHAPES in CostKernel.cpp) and the sites are
+ * unit-spaced: its neighbor table is a constexpr array in which a missing neighbor is the cell itself, so the inner
+ * loops have fixed trip counts and no bounds checks. Other problems get the generic kernel.
+ * Coordinates are the x / y arrays of a Placement.
+ *
+ */
+class CostKernel
+{
+public:
+    virtual ~CostKernel() {}
+
+    virtual const char * name() const = 0;
+    virtual double  wirelength(const int *x, const int *y) const = 0;
+    // Wirelength change when cell c moves to (sy, sx) and cell c2 (-1: none), now at (sy, sx), takes c's site.
+    virtual double  moveDelta(const int *x, const int *y, int c, int c2, int sy, int sx) const = 0;
+};
+
+
+std::shared_ptr<const CostKernel>   makeCostKernel(const PlacementProblem &prob, bool allowSpecialized = true);
+void    benchmarkCostKernels(const PlacementProblem &prob, double seconds);
+
+
+#endif
@@ -0,0 +1,229 @@
+#include "CutSeparator.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+
+
+namespace {
+
+// Gaps between consecutive site lines (1 for unit-spaced sites); empty if the coordinates are not ascending.
+std::vector<double> lineGaps(const PlacementProblem &prob, bool isY) {
+    const int numLines = isY ? prob.siteSizeY : prob.siteSizeX;
+    std::vector<double> gaps(std::max(0, numLines - 1), 1.0);
+    if (prob.geometry) {
+        const std::vector<double> &coords = isY ? prob.geometry->coordsY() : prob.geometry->coordsX();
+        for (size_t s = 0; s < gaps.size(); s++) {
+            gaps[s] = coords[s + 1] - coords[s];
+            if (gaps[s] < 0) {
+                return std::vector<double>();
+            }
+        }
+    }
+    return gaps;
+}
+
+} // namespace
+
+
+CutSeparator::CutSeparator(const PlacementProblem &prob)
+    : m_prob(prob)
+{
+    const int n = prob.numCells();
+    m_lowY.assign(n + 1, 0);
+    m_highY.assign(n + 1, 0);
+    m_lowX.assign(n + 1, 0);
+    m_highX.assign(n + 1, 0);
+    for (int t = 0; t < n; t++) {
+        m_lowY[t + 1] = m_lowY[t] + t / prob.siteSizeX;
+        m_highY[t + 1] = m_highY[t] + (prob.siteSizeY - 1 - t / prob.siteSizeX);
+        m_lowX[t + 1] = m_lowX[t] + t / prob.siteSizeY;
+        m_highX[t + 1] = m_highX[t] + (prob.siteSizeX - 1 - t / prob.siteSizeY);
+    }
+
+    // Boundaries between site rows are crossed by vertical distances; rows hold siteSizeX cells. Likewise columns.
+    std::vector<double> gapsY = lineGaps(prob, true), gapsX = lineGaps(prob, false);
+    if (!gapsY.empty()) {
+        m_boundY = crossingBound(prob.arraySizeY, prob.arraySizeX, gapsY, prob.siteSizeX);
+    }
+    if (!gapsX.empty()) {
+        m_boundX = crossingBound(prob.arraySizeY, prob.arraySizeX, gapsX, prob.siteSizeY);
+    }
+}
+
+/**
+ * @brief Minimum number of mesh edges between k cells of an arraySizeY x arraySizeX array and the other cells.
+ * Compression makes some optimal set a staircase in a corner (or the complement of one). A staircase with r < Y
+ * rows and c < X columns has r + c boundary edges and holds r + c - 1 .. r * c cells; one spanning all X columns
+ * has X plus one per partial row, and likewise for all Y rows.
+ *
+ * @param arraySizeY
+ * @param arraySizeX
+ * @param k
+ * @return int
+ */
+int CutSeparator::edgeBoundary(int arraySizeY, int arraySizeX, int k) {
+    const int n = arraySizeY * arraySizeX;
+    if (k <= 0 || k >= n) {
+        return 0;
+    }
+    auto staircase = [&](int m) {
+        int best = std::numeric_limits<int>::max();
+        for (int r = 1; r < arraySizeY && r <= m; r++) {
+            const int c = (m + r - 1) / r;
+            if (c < arraySizeX) {
+                best = std::min(best, r + c);
+            }
+        }
+        if (m >= arraySizeX && (m + arraySizeX - 1) / arraySizeX < arraySizeY) {
+            best = std::min(best, arraySizeX + (m % arraySizeX != 0));
+        }
+        if (m >= arraySizeY && (m + arraySizeY - 1) / arraySizeY < arraySizeX) {
+            best = std::min(best, arraySizeY + (m % arraySizeY != 0));
+        }
+        return best;
+    };
+    return std::min(staircase(k), staircase(n - k));
+}
+
+/**
+ * @brief Lower bound on the wirelength along one axis: the boundary after site line s is crossed by at least
+ * edgeBoundary(k_s) edges, each paying gaps[s], where k_s cells lie on lines 0 .. s. The cheapest k_0 <= k_1 <= ..
+ * with at most <capacity> cells per line is found by dynamic programming over the lines.
+ *
+ * @param arraySizeY
+ * @param arraySizeX
+ * @param gaps distance between consecutive site lines.
+ * @param capacity sites per line.
+ * @return double 0 if the cells do not fit.
+ */
+double CutSeparator::crossingBound(int arraySizeY, int arraySizeX, const std::vector<double> &gaps, int capacity) {
+    const int n = arraySizeY * arraySizeX;
+    const int numLines = gaps.size() + 1;
+    if ((long long)numLines * capacity < n) {
+        return 0;
+    }
+    std::vector<int> theta(n + 1);
+    for (int k = 0; k <= n; k++) {
+        theta[k] = edgeBoundary(arraySizeY, arraySizeX, k);
+    }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> prev(n + 1, inf), cur(n + 1);
+    prev[0] = 0;
+    for (int s = 0; s < numLines; s++) {
+        for (int k = 0; k <= n; k++) {
+            double best = inf;
+            for (int k0 = std::max(0, k - capacity); k0 <= k; k0++) {
+                best = std::min(best, prev[k0]);
+            }
+            cur[k] = best + ((s + 1 < numLines) ? gaps[s] * theta[k] : 0);
+        }
+        prev.swap(cur);
+    }
+    return prev[n];
+}
+
+/**
+ * @brief Spread cuts violated by the relaxed coordinates <relX, relY> (relX empty: one site column).
+ *
+ * @param relX
+ * @param relY
+ * @param maxCuts most violated cuts per axis and side.
+ * @param cuts appended.
+ * @return int number of cuts appended.
+ */
+int CutSeparator::separateSpread(const std::vector<double> &relX, const std::vector<double> &relY, int maxCuts, std::vector<Cut> &cuts) const {
+    const size_t before = cuts.size();
+    if (m_prob.siteSizeY > 1) {
+        separateAxis(relY, true, maxCuts, cuts);
+    }
+    if (!relX.empty() && m_prob.siteSizeX > 1) {
+        separateAxis(relX, false, maxCuts, cuts);
+    }
+    return cuts.size() - before;
+}
+
+void CutSeparator::separateAxis(const std::vector<double> &rel, bool isY, int maxCuts, std::vector<Cut> &cuts) const {
+    const int n = rel.size();
+    const std::vector<double> &low = isY ? m_lowY : m_lowX;
+    const std::vector<double> &high = isY ? m_highY : m_highX;
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return rel[a] < rel[b]; });
+
+    // Violation per prefix (the k lowest against low[k]) and suffix (the k highest against high[k]), scaled by the
+    // norm of the cut.
+    std::vector<std::pair<double, int>> violated; // (scaled violation, +k lower / -k upper)
+    double prefix = 0, suffix = 0;
+    for (int k = 1; k <= n; k++) {
+        prefix += rel[order[k - 1]];
+        suffix += rel[order[n - k]];
+        if (prefix < low[k] - 1e-6) {
+            violated.push_back(std::make_pair((low[k] - prefix) / std::sqrt((double)k), k));
+        }
+        if (suffix > high[k] + 1e-6) {
+            violated.push_back(std::make_pair((suffix - high[k]) / std::sqrt((double)k), -k));
+        }
+    }
+    std::sort(violated.begin(), violated.end(), [](const std::pair<double, int> &a, const std::pair<double, int> &b) { return a.first > b.first; });
+
+    int numLower = 0, numUpper = 0;
+    for (const std::pair<double, int> &v: violated) {
+        const bool lower = v.second > 0;
+        int &count = lower ? numLower : numUpper;
+        if (count >= maxCuts) {
+            continue;
+        }
+        count++;
+        const int k = lower ? v.second : -v.second;
+        Cut cut;
+        cut.isY = isY;
+        cut.lower = lower;
+        cut.rhs = lower ? low[k] : high[k];
+        cut.cells.assign(lower ? order.begin() : order.end() - k, lower ? order.begin() + k : order.end());
+        cuts.push_back(cut);
+    }
+}
+
+
+/**
+ * @brief Print the wirelength bound of the cuts against the bound of the neighbor no-overlap rows alone (every
+ * array edge at least min(weightX, weightY) long) and a LocalSearch placement, as the share of the gap it closes.
+ *
+ * @param prob
+ */
+void benchmarkCuts(const PlacementProblem &prob) {
+    printf("Cut benchmark: %d x %d => %d x %d, weights %g / %g\n", prob.arraySizeY, prob.arraySizeX,
+        prob.siteSizeY, prob.siteSizeX, prob.weightX, prob.weightY);
+    if (prob.numCells() > prob.numSites() || prob.numCells() == 0) {
+        printf("ERR: invalid benchmark size.\n");
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    CutSeparator sep(prob);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const int edges = prob.arraySizeY * (prob.arraySizeX - 1) + (prob.arraySizeY - 1) * prob.arraySizeX;
+    double minWeight = std::min(prob.siteSizeX > 1 ? prob.weightX : prob.weightY, prob.siteSizeY > 1 ? prob.weightY : prob.weightX);
+    const double baseBound = edges * minWeight;
+    printf("  crossing bound: y %.0f, x %.0f, weighted %.1f (%.3fs)\n", sep.boundY(), sep.boundX(), sep.wirelengthBound(), elapsed.count());
+    printf("  no-overlap bound: %.1f (%d edges)\n", baseBound, edges);
+
+    Placement pl;
+    if (LocalSearch::initialPlacement(prob, pl)) {
+        const double ub = LocalSearch(prob).run(pl, 10);
+        const double closed = (ub > baseBound) ? (sep.wirelengthBound() - baseBound) / (ub - baseBound) : 1;
+        printf("  LocalSearch placement: %.1f; gap to it %.1f%% with the cuts, %.1f%% without; %.1f%% of the gap closed\n",
+            ub, 100 * (ub - sep.wirelengthBound()) / ub, 100 * (ub - baseBound) / ub, 100 * closed);
+    }
+
+    // Spread cuts at the all-equal relaxation shifted to the bottom (every cell at row 0.5).
+    std::vector<double> relX(prob.siteSizeX > 1 ? prob.numCells() : 0, 0.5), relY(prob.numCells(), 0.5);
+    std::vector<CutSeparator::Cut> cuts;
+    sep.separateSpread(relX, relY, 4, cuts);
+    printf("  spread cuts at the collapsed relaxation: %zu\n", cuts.size());
+}
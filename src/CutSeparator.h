@@ -0,0 +1,54 @@
+#ifndef __CUTSEPARATOR_H__
+#define __CUTSEPARATOR_H__
+
+#include "Placement.h"
+#include <vector>
+
+
+/**
+ * @brief Valid inequalities of the grid-to-site placement, separated from a relaxed placement. Gurobi-free;
+ * PlacerCallback adds them as user cuts.
+ * - Spread cuts: any k cells sit on k distinct sites, so their y sum to at least the k lowest row indices with
+ *   siteSizeX sites per row, and to at most the k highest; likewise x with siteSizeY sites per column. With one
+ *   site column these are the facets of the permutahedron. Separated exactly by sorting the relaxed coordinates.
+ * - Wirelength bound: the boundary between site rows s and s + 1 is crossed by at least theta(k) array edges,
+ *   k the number of cells below it and theta the edge-isoperimetric profile of the array mesh. The cheapest row
+ *   occupation (by dynamic programming) bounds the y wirelength; likewise x. Unit-spaced sites only.
+ *
+ */
+class CutSeparator
+{
+public:
+    // Sum of <isY ? y : x> over <cells>, >= rhs if lower, else <= rhs.
+    struct Cut {
+        std::vector<int>    cells;
+        bool                isY = true;
+        bool                lower = true;
+        double              rhs = 0;
+    };
+
+    explicit CutSeparator(const PlacementProblem &prob);
+
+    double  wirelengthBound() const { return m_prob.weightX * m_boundX + m_prob.weightY * m_boundY; }
+    double  boundX() const { return m_boundX; }
+    double  boundY() const { return m_boundY; }
+
+    int     separateSpread(const std::vector<double> &relX, const std::vector<double> &relY, int maxCuts, std::vector<Cut> &cuts) const;
+
+    static int      edgeBoundary(int arraySizeY, int arraySizeX, int k);
+    static double   crossingBound(int arraySizeY, int arraySizeX, const std::vector<double> &gaps, int capacity);
+
+private:
+    void    separateAxis(const std::vector<double> &rel, bool isY, int maxCuts, std::vector<Cut> &cuts) const;
+
+    PlacementProblem    m_prob;
+    double              m_boundX = 0;
+    double              m_boundY = 0;
+    std::vector<double> m_lowY, m_highY; // Sum of the k lowest / highest row indices at index k.
+    std::vector<double> m_lowX, m_highX;
+};
+
+void    benchmarkCuts(const PlacementProblem &prob);
+
+
+#endif
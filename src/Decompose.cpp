@@ -0,0 +1,266 @@
+#include "Decompose.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <thread>
+
+
+ColumnPlacer::ColumnPlacer(const PlacementProblem &prob, ColumnSolver solver)
+    : m_prob(prob), m_solver(solver)
+{}
+
+/**
+ * @brief Alternate column assignment and column ordering from the legal placement <pl>.
+ *
+ * @param pl start placement, replaced by the best placement found.
+ * @param timeLimit seconds in total; <= 0 for no limit.
+ * @return double the wirelength of <pl>.
+ */
+double ColumnPlacer::run(Placement &pl, double timeLimit) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+    std::mt19937 rng(m_prob.numCells());
+
+    Placement best = pl;
+    double bestWl = placementWirelength(m_prob, pl);
+    printf("Columns: start wirelength %.1f\n", bestWl);
+    for (int it = 0; it < m_iterations; it++) {
+        if (timeLimit > 0 && elapsed() >= timeLimit) {
+            break;
+        }
+        int moves = assignColumns(pl, rng);
+        printf("Columns: iteration %d: assignment, %d moves, wirelength %.1f (%.2fs)\n", it, moves, placementWirelength(m_prob, pl), elapsed());
+
+        double orderTime = (timeLimit > 0) ? (timeLimit - elapsed()) / (m_iterations - it) : -1;
+        int improved = orderColumns(pl, orderTime);
+        double wl = placementWirelength(m_prob, pl);
+        printf("Columns: iteration %d: ordering, %d columns improved, wirelength %.1f (%.2fs)\n", it, improved, wl, elapsed());
+
+        if (wl < bestWl - 1e-6) {
+            best = pl;
+            bestWl = wl;
+        }
+        else if (moves == 0 && improved == 0) {
+            break;
+        }
+    }
+    pl = best;
+    return bestWl;
+}
+
+/**
+ * @brief Stage 1: move or swap cells between site columns while the wirelength of their edges drops.
+ *
+ * @param pl
+ * @param rng
+ * @return int the number of moves.
+ */
+int ColumnPlacer::assignColumns(Placement &pl, std::mt19937 &rng) {
+    const int numCells = m_prob.numCells();
+    m_siteCell.assign(m_prob.numSites(), -1);
+    for (int c = 0; c < numCells; c++) {
+        m_siteCell[m_prob.siteId(pl.y(c), pl.x(c))] = c;
+    }
+
+    std::vector<int> order(numCells);
+    std::iota(order.begin(), order.end(), 0);
+    int moves = 0;
+    bool improved = true;
+    for (int pass = 0; pass < 20 && improved; pass++) {
+        improved = false;
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int c: order) {
+            const int sx = pl.x(c), mx = medianColumn(pl, c);
+            bool moved = false;
+            for (int k: {sx - 1, sx + 1, mx}) {
+                if (!moved && k >= 0 && k < m_prob.siteSizeX && k != sx) {
+                    moved = tryColumnMove(pl, c, k);
+                }
+            }
+            moves += moved;
+            improved |= moved;
+        }
+    }
+    return moves;
+}
+
+/**
+ * @brief Move cell <c> to site column <sx> at the nearest row within m_searchRows, swapping with the cell there if
+ * occupied, if that shortens the edges of the moved cells and keeps the relative ordering.
+ *
+ * @param pl
+ * @param c
+ * @param sx
+ * @return true if moved.
+ */
+bool ColumnPlacer::tryColumnMove(Placement &pl, int c, int sx) {
+    const int y0 = pl.y(c), x0 = pl.x(c);
+    for (int r = 0; r <= m_searchRows; r++) {
+        // Row y0 once, then y0 - r and y0 + r.
+        for (int sign = (r == 0) ? 1 : -1; sign <= 1; sign += 2) {
+            const int sy = y0 + sign * r;
+            if (sy < 0 || sy >= m_prob.siteSizeY || m_prob.isSiteBlocked(sy, sx)) {
+                continue;
+            }
+            const int d = m_siteCell[m_prob.siteId(sy, sx)];
+            double before = cellCost(pl, c) + ((d >= 0) ? cellCost(pl, d) : 0);
+            pl.y(c) = sy;
+            pl.x(c) = sx;
+            if (d >= 0) {
+                pl.y(d) = y0;
+                pl.x(d) = x0;
+            }
+            double after = cellCost(pl, c) + ((d >= 0) ? cellCost(pl, d) : 0);
+            if (after < before - 1e-9 && isCellOrderLegal(pl, c) && (d < 0 || isCellOrderLegal(pl, d))) {
+                m_siteCell[m_prob.siteId(sy, sx)] = c;
+                m_siteCell[m_prob.siteId(y0, x0)] = d;
+                return true;
+            }
+            pl.y(c) = y0;
+            pl.x(c) = x0;
+            if (d >= 0) {
+                pl.y(d) = sy;
+                pl.x(d) = sx;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Stage 2: re-solve every site column with the other columns fixed, even columns in parallel, then odd ones.
+ * Columns the solver cannot improve are refined by LocalSearch restricted to vertical moves.
+ *
+ * @param pl
+ * @param timeLimit seconds for all columns; <= 0 for no limit.
+ * @return int the number of column results kept.
+ */
+int ColumnPlacer::orderColumns(Placement &pl, double timeLimit) {
+    // Batches of the even columns ((siteSizeX + 1) / 2 of them) and of the odd ones.
+    const int numBatches = std::max(1, ((m_prob.siteSizeX + 1) / 2 + m_threads - 1) / m_threads)
+                         + std::max(1, (m_prob.siteSizeX / 2 + m_threads - 1) / m_threads);
+    double columnTime = m_columnTime;
+    if (timeLimit > 0) {
+        columnTime = std::min(columnTime, timeLimit / numBatches);
+    }
+
+    int accepted = 0;
+    for (int parity = 0; parity < 2 && m_solver; parity++) {
+        std::vector<int> columns;
+        for (int sx = parity; sx < m_prob.siteSizeX; sx += 2) {
+            columns.push_back(sx);
+        }
+        for (size_t b = 0; b < columns.size(); b += m_threads) {
+            const size_t e = std::min(columns.size(), b + m_threads);
+            const Placement snapshot = pl;
+            std::vector<SiteWindow> windows(e - b);
+            std::vector<Placement> results(e - b);
+            std::vector<char> solved(e - b, 0);
+            std::vector<std::thread> workers;
+            for (size_t k = 0; k < e - b; k++) {
+                windows[k].y0 = 0;
+                windows[k].y1 = m_prob.siteSizeY;
+                windows[k].x0 = columns[b + k];
+                windows[k].x1 = columns[b + k] + 1;
+                workers.emplace_back([&, k]() {
+                    solved[k] = m_solver(m_prob, snapshot, windows[k], columnTime, results[k]);
+                });
+            }
+            for (std::thread &t: workers) {
+                t.join();
+            }
+
+            double wl = placementWirelength(m_prob, pl);
+            for (size_t k = 0; k < e - b; k++) {
+                if (!solved[k]) {
+                    continue;
+                }
+                Placement cand = pl;
+                for (int c = 0; c < m_prob.numCells(); c++) {
+                    if (windows[k].contains(snapshot.y(c), snapshot.x(c))) {
+                        cand.y(c) = results[k].y(c);
+                        cand.x(c) = results[k].x(c);
+                    }
+                }
+                double candWl = placementWirelength(m_prob, cand);
+                if (candWl < wl - 1e-6 && isPlacementLegal(m_prob, cand)) {
+                    pl = cand;
+                    wl = candWl;
+                    accepted++;
+                }
+            }
+        }
+    }
+
+    LocalSearch ls(m_prob);
+    ls.setWindow(m_prob.siteSizeY, 0);
+    ls.run(pl, (timeLimit > 0) ? std::max(1e-3, columnTime) : -1);
+    return accepted;
+}
+
+/**
+ * @brief Weighted wirelength of the array edges of cell <c>.
+ *
+ * @param pl
+ * @param c
+ * @return double
+ */
+double ColumnPlacer::cellCost(const Placement &pl, int c) const {
+    const int i = c / m_prob.arraySizeX, j = c % m_prob.arraySizeX;
+    double cost = 0;
+    auto add = [&](int ni, int nj) {
+        if (ni < 0 || ni >= m_prob.arraySizeY || nj < 0 || nj >= m_prob.arraySizeX) {
+            return;
+        }
+        int n = m_prob.cellId(ni, nj);
+        cost += m_prob.weightX * m_prob.distX(pl.x(c), pl.x(n)) + m_prob.weightY * m_prob.distY(pl.y(c), pl.y(n));
+    };
+    add(i - 1, j);
+    add(i + 1, j);
+    add(i, j - 1);
+    add(i, j + 1);
+    return cost;
+}
+
+/**
+ * @brief The relative ordering constraints between cell <c> and its array neighbors.
+ *
+ * @param pl
+ * @param c
+ * @return true if none is violated.
+ */
+bool ColumnPlacer::isCellOrderLegal(const Placement &pl, int c) const {
+    const int i = c / m_prob.arraySizeX, j = c % m_prob.arraySizeX;
+    if (m_prob.relativeConstraintX) {
+        if (j > 0 && pl.x(c - 1) > pl.x(c)) return false;
+        if (j + 1 < m_prob.arraySizeX && pl.x(c) > pl.x(c + 1)) return false;
+    }
+    if (m_prob.relativeConstraintY) {
+        if (i > 0 && pl.y(c - m_prob.arraySizeX) > pl.y(c)) return false;
+        if (i + 1 < m_prob.arraySizeY && pl.y(c) > pl.y(c + m_prob.arraySizeX)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Median site column of the array neighbors of cell <c>.
+ *
+ * @param pl
+ * @param c
+ * @return int
+ */
+int ColumnPlacer::medianColumn(const Placement &pl, int c) const {
+    const int i = c / m_prob.arraySizeX, j = c % m_prob.arraySizeX;
+    std::vector<int> xs;
+    if (i > 0) xs.push_back(pl.x(c - m_prob.arraySizeX));
+    if (i + 1 < m_prob.arraySizeY) xs.push_back(pl.x(c + m_prob.arraySizeX));
+    if (j > 0) xs.push_back(pl.x(c - 1));
+    if (j + 1 < m_prob.arraySizeX) xs.push_back(pl.x(c + 1));
+    std::sort(xs.begin(), xs.end());
+    return xs.empty() ? pl.x(c) : xs[(xs.size() - 1) / 2];
+}
@@ -0,0 +1,52 @@
+#ifndef __DECOMPOSE_H__
+#define __DECOMPOSE_H__
+
+#include "LNS.h"
+#include "Placement.h"
+#include <random>
+#include <vector>
+
+
+/**
+ * @brief Two-stage decomposition for several site columns: assign cells to site columns, then order every column.
+ * Stage 1 refines the column of each cell: a cell moves or swaps into an adjacent column (or its neighbors' median
+ * column) at a nearby row when the crossing cost of its array edges drops, capacities being the free sites per column.
+ * Stage 2 re-solves every site column as a one-column ordering problem (a full-height, one-column window of the
+ * LNS window solver), with the cells of the other columns fixed as anchors; columns of one parity share no sites,
+ * so they are solved in parallel, then applied one by one while the placement stays legal and improves.
+ * The two stages alternate for a few iterations and the best placement is kept.
+ *
+ */
+class ColumnPlacer
+{
+public:
+    // Column solver: (problem, current placement, full-height one-column window, time limit, result) -> success.
+    typedef LNSPlacer::WindowSolver ColumnSolver;
+
+    ColumnPlacer(const PlacementProblem &prob, ColumnSolver solver);
+
+    void    setIterations(int iterations) { m_iterations = iterations; }
+    void    setColumnTime(double seconds) { m_columnTime = seconds; }
+    void    setThreads(int threads) { m_threads = threads; }
+
+    double  run(Placement &pl, double timeLimit);
+
+private:
+    int     assignColumns(Placement &pl, std::mt19937 &rng);
+    int     orderColumns(Placement &pl, double timeLimit);
+    bool    tryColumnMove(Placement &pl, int c, int sx);
+    double  cellCost(const Placement &pl, int c) const;
+    bool    isCellOrderLegal(const Placement &pl, int c) const;
+    int     medianColumn(const Placement &pl, int c) const;
+
+    PlacementProblem    m_prob;
+    ColumnSolver        m_solver;
+    std::vector<int>    m_siteCell; // Cell on each site, -1 if empty.
+    int                 m_iterations = 3;
+    double              m_columnTime = 5;
+    int                 m_threads = 1;
+    int                 m_searchRows = 2; // Stage 1 looks this many rows above and below the cell.
+};
+
+
+#endif
@@ -0,0 +1,105 @@
+#include "Embed.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+
+namespace {
+
+/**
+ * @brief Old array index of new index <i> (fractional; beyond the old array in mode 1 when it grows).
+ *
+ */
+double oldIndex(int i, int oldSize, int newSize, int mode) {
+    if (mode == 1) {
+        return i;
+    }
+    if (newSize == 1) {
+        return 0;
+    }
+    return (double)i * (oldSize - 1) / (newSize - 1);
+}
+
+/**
+ * @brief Linear interpolation of v(k) between the two old indices around t, extrapolated outside [0, size - 1].
+ *
+ */
+template <typename F>
+double interpolate(F v, double t, int size) {
+    if (size == 1) {
+        return v(0);
+    }
+    int k = std::min(size - 2, std::max(0, (int)t));
+    double f = t - k;
+    return (1 - f) * v(k) + f * v(k + 1);
+}
+
+/**
+ * @brief Site position <p> of a grid of <from> sites on a grid of <to> sites, keeping the relative position.
+ *
+ */
+double rescale(double p, int from, int to) {
+    return (p + 0.5) * to / from - 0.5;
+}
+
+} // namespace
+
+
+/**
+ * @brief Carry a placement over to a job of another shape (array rows / columns added or removed, site grid resized),
+ * to warm-start the new job instead of solving it cold.
+ * Every new cell takes the position interpolated (or, past the old array, extrapolated) from the old cells around its
+ * index in the old array, scaled to the new site grid; the result is legalized by LocalSearch::roundAndRepair(),
+ * ROC-repaired, and refined by LocalSearch.
+ * mode 0 spreads the added / removed rows and columns evenly over the array (new index i maps to old index
+ * i * (oldSize - 1) / (newSize - 1)); mode 1 keeps the old indices and adds / removes at the high-index end.
+ *
+ * @param from the old problem.
+ * @param fromPl the old placement.
+ * @param to the new problem.
+ * @param mode
+ * @param pl the placement of <to>.
+ * @return true if <pl> is legal.
+ */
+bool embedPlacement(const PlacementProblem &from, const Placement &fromPl, const PlacementProblem &to, int mode, Placement &pl) {
+    const int n = to.numCells();
+    std::vector<double> relY(n), relX(n);
+    for (int i = 0; i < to.arraySizeY; i++) {
+        const double ti = oldIndex(i, from.arraySizeY, to.arraySizeY, mode);
+        for (int j = 0; j < to.arraySizeX; j++) {
+            const double tj = oldIndex(j, from.arraySizeX, to.arraySizeX, mode);
+            // Bilinear: along the old columns in each of the two old rows around ti, then between the rows.
+            auto at = [&](bool isY) {
+                return interpolate([&](int oi) {
+                    return interpolate([&](int oj) {
+                        int c = from.cellId(oi, oj);
+                        return (double)(isY ? fromPl.y(c) : fromPl.x(c));
+                    }, tj, from.arraySizeX);
+                }, ti, from.arraySizeY);
+            };
+            const int c = to.cellId(i, j);
+            relY[c] = rescale(at(true), from.siteSizeY, to.siteSizeY);
+            relX[c] = rescale(at(false), from.siteSizeX, to.siteSizeX);
+        }
+    }
+    if (to.siteSizeX == 1) {
+        relX.clear();
+    }
+
+    bool legal = LocalSearch::roundAndRepair(to, relX, relY, pl);
+    if (!legal && pl.numCells() == n && isPlacementLegal(to, pl, false)) {
+        legal = LocalSearch::repairRelativeOrder(to, pl);
+    }
+    if (!legal) {
+        printf("ERR: Embedding %d x %d => %d x %d into %d x %d => %d x %d found no legal placement.\n",
+            from.arraySizeY, from.arraySizeX, from.siteSizeY, from.siteSizeX, to.arraySizeY, to.arraySizeX, to.siteSizeY, to.siteSizeX);
+        return false;
+    }
+    double legalWl = placementWirelength(to, pl);
+    double wl = LocalSearch(to).run(pl, -1);
+    printf("Embedded %d x %d => %d x %d into %d x %d => %d x %d: legalized wirelength %.1f, refined %.1f\n",
+        from.arraySizeY, from.arraySizeX, from.siteSizeY, from.siteSizeX, to.arraySizeY, to.arraySizeX, to.siteSizeY, to.siteSizeX,
+        legalWl, wl);
+    return true;
+}
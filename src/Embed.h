@@ -0,0 +1,10 @@
+#ifndef __EMBED_H__
+#define __EMBED_H__
+
+#include "Placement.h"
+
+
+bool    embedPlacement(const PlacementProblem &from, const Placement &fromPl, const PlacementProblem &to, int mode, Placement &pl);
+
+
+#endif
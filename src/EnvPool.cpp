@@ -0,0 +1,81 @@
+#include "EnvPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+
+EnvPool::EnvPool(int capacity)
+    : m_capacity(std::max(1, capacity))
+{}
+
+/**
+ * @brief Change the number of environments the pool may hold. Environments beyond a lowered capacity are kept until the pool is destroyed.
+ *
+ * @param capacity
+ */
+void EnvPool::setCapacity(int capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = std::max(1, capacity);
+    m_released.notify_all();
+}
+
+/**
+ * @brief Raise the capacity to at least <capacity>, e.g. before launching that many concurrent solves.
+ *
+ * @param capacity
+ */
+void EnvPool::reserve(int capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (capacity > m_capacity) {
+        m_capacity = capacity;
+        m_released.notify_all();
+    }
+}
+
+/**
+ * @brief Lease an idle environment, starting a new one if all are leased and the capacity allows, waiting otherwise.
+ * The job's log goes to <logFile> (none if empty); <output> false silences the environment completely.
+ *
+ * @param logFile
+ * @param output
+ * @return Lease
+ */
+EnvPool::Lease EnvPool::lease(const std::string &logFile, bool output) {
+    GRBEnv *env = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [this]() { return !m_idle.empty() || (int)m_envs.size() < m_capacity; });
+        if (!m_idle.empty()) {
+            env = m_idle.back();
+            m_idle.pop_back();
+        }
+        else {
+            // Started under the lock: creation is rare, and it keeps the count within the capacity.
+            // Pooled only once started, so a failed start (license, token server) leaves the capacity unchanged.
+            std::unique_ptr<GRBEnv> started(new GRBEnv(true));
+            started->set(GRB_IntParam_OutputFlag, 0);
+            started->start();
+            env = started.get();
+            m_envs.push_back(std::move(started));
+            printf("EnvPool: started environment %d of %d\n", (int)m_envs.size(), m_capacity);
+        }
+    }
+
+    // Leased before the parameters are set: if setting them throws, the lease returns the environment to the pool.
+    Lease lease(this, env);
+    env->set(GRB_IntParam_OutputFlag, output);
+    env->set(GRB_StringParam_LogFile, logFile);
+    return lease;
+}
+
+void EnvPool::release(GRBEnv *env) {
+    try {
+        env->resetParams();
+        env->set(GRB_StringParam_LogFile, "");
+    } catch (GRBException e) {
+        printf("EnvPool: %s\n", e.getMessage().c_str());
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(env);
+    m_released.notify_one();
+}
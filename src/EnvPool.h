@@ -0,0 +1,62 @@
+#ifndef __ENVPOOL_H__
+#define __ENVPOOL_H__
+
+#include "gurobi_c++.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Started Gurobi environments shared by all jobs of a MacroPlacer, so a sweep of short jobs checks out
+ * a license and starts an environment once per pool slot instead of once per job.
+ * Environments are created on demand up to the capacity; lease() blocks while all of them are leased.
+ * A returned environment gets its parameters reset, so no job inherits the settings of the previous one.
+ *
+ */
+class EnvPool
+{
+public:
+    /**
+     * @brief An environment leased to one job; returned to the pool on destruction.
+     *
+     */
+    class Lease
+    {
+    public:
+        Lease(EnvPool *pool, GRBEnv *env) : m_pool(pool), m_env(env) {}
+        Lease(Lease &&other) : m_pool(other.m_pool), m_env(other.m_env) { other.m_env = nullptr; }
+        Lease(const Lease &) = delete;
+        Lease & operator=(const Lease &) = delete;
+        ~Lease() { if (m_env) m_pool->release(m_env); }
+
+        GRBEnv &    env() { return *m_env; }
+
+    private:
+        EnvPool *   m_pool;
+        GRBEnv *    m_env;
+    };
+
+    explicit EnvPool(int capacity);
+
+    void    setCapacity(int capacity);
+    void    reserve(int capacity);
+    int     capacity() const { return m_capacity; }
+    int     numCreated() const { return m_envs.size(); }
+
+    Lease   lease(const std::string &logFile, bool output = true);
+
+private:
+    void    release(GRBEnv *env);
+
+    std::mutex                              m_mutex;
+    std::condition_variable                 m_released;
+    std::vector<std::unique_ptr<GRBEnv>>    m_envs;
+    std::vector<GRBEnv *>                   m_idle;
+    int                                     m_capacity = 1;
+};
+
+
+#endif
@@ -1,6 +1,27 @@
 #include "ILPSolver.h"
+#include "SolverCallback.h"
+#include "CutSeparator.h"
+#include "Multilevel.h"
+#include "Presolve.h"
+#include "ModelPlan.h"
+#include "LNS.h"
+#include "CPSearch.h"
+#include "Tiling.h"
+#include "Embed.h"
+#include "Decompose.h"
+#include "Spectral.h"
+#include "Analytical.h"
+#include "ModelBuild.h"
+#include "ResultCache.h"
+#include "EnvPool.h"
+#include "LocalSearch.h"
 #include "util.h"
+#include <algorithm>
 #include <memory>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <cmath>
 // #include "../or-tools/ortools/linear_solver/linear_solver.h"
 #include "gurobi_c++.h"
 #include <string>
@@ -237,6 +258,260 @@ void MacroPlacer::setInitSolFileName(const std::string initSolFileName) {
     m_initSolFileName = initSolFileName;
 }
 
+/**
+ * @brief Set the no-overlap constraint formulation (0: abs; 1: indicator plus OR). 
+ * 
+ * @param NOCMode 
+ */
+void MacroPlacer::setNOCMode(int NOCMode) {
+    m_NOCMode = NOCMode;
+}
+
+/**
+ * @brief Set the total number of solver threads of a job (0: all hardware threads).
+ * 
+ * @param threads 
+ */
+void MacroPlacer::setThreads(int threads) {
+    m_threads = threads;
+}
+
+/**
+ * @brief Set the number of concurrent solvers used by runPortfolio() (0: default).
+ * 
+ * @param portfolioSize 
+ */
+void MacroPlacer::setPortfolioSize(int portfolioSize) {
+    m_portfolioSize = portfolioSize;
+}
+
+/**
+ * @brief Enable the local search callback on the Gurobi models (see PlacerCallback).
+ * 
+ * @param enable 
+ * @param timeBudget seconds of local search per callback call.
+ * @param relaxInterval minimum seconds between two node relaxation roundings.
+ */
+void MacroPlacer::setHeuristicCallback(bool enable, double timeBudget, double relaxInterval) {
+    m_heurCallback = enable;
+    m_heurTime = timeBudget;
+    m_heurInterval = relaxInterval;
+}
+
+/**
+ * @brief Set the share of the time limit given to the ROC-restricted stage of runPipeline().
+ * 
+ * @param fraction 
+ */
+void MacroPlacer::setPipelineFraction(double fraction) {
+    m_pipelineFraction = fraction;
+}
+
+/**
+ * @brief Set the number of super-cells at which runMultilevel() stops coarsening.
+ * 
+ * @param numCells 
+ */
+void MacroPlacer::setMultilevelCoarsestCells(int numCells) {
+    m_mlCoarsestCells = numCells;
+}
+
+/**
+ * @brief Set the site window of runLNS().
+ * 
+ * @param rows site rows of a window (0: default).
+ * @param cols site columns of a window (0: default).
+ * @param timeLimit seconds per window sub-MIP.
+ */
+void MacroPlacer::setLNSWindow(int rows, int cols, double timeLimit) {
+    m_lnsWindowRows = rows;
+    m_lnsWindowCols = cols;
+    m_lnsWindowTime = timeLimit;
+}
+
+/**
+ * @brief Let runCP() search to completion (a certified optimum) instead of stopping at the time limit.
+ * 
+ * @param b 
+ */
+void MacroPlacer::setCPExhaustive(bool b) {
+    m_cpExhaustive = b;
+}
+
+/**
+ * @brief Set the tile of runTile().
+ * 
+ * @param rows cell rows of the tile (0: chosen automatically).
+ * @param cols cell columns of the tile (0: chosen automatically).
+ */
+void MacroPlacer::setTileSize(int rows, int cols) {
+    m_tileRows = rows;
+    m_tileCols = cols;
+}
+
+/**
+ * @brief Set how an initial solution of another shape is embedded (see embedPlacement()).
+ * 
+ * @param mode 0: added / removed rows and columns spread over the array; 1: at the high-index end.
+ */
+void MacroPlacer::setEmbedMode(int mode) {
+    m_embedMode = mode;
+}
+
+/**
+ * @brief Set the rounds and the column sub-MIP time limit of runColumns().
+ * 
+ * @param iterations 
+ * @param columnTime 
+ */
+void MacroPlacer::setColumnDecomposition(int iterations, double columnTime) {
+    m_colIterations = iterations;
+    m_colTime = columnTime;
+}
+
+/**
+ * @brief Solve the run2()/run3()/run4() models in phases (see optimizeInPhases()); empty for a single optimize().
+ * 
+ * @param phases 
+ * @param tol relative improvement of the incumbent or bound that counts as progress.
+ */
+void MacroPlacer::setSolvePhases(const std::vector<SolvePhase> &phases, double tol) {
+    m_solvePhases = phases;
+    m_phaseTol = tol;
+}
+
+/**
+ * @brief Add the CutSeparator inequalities as user cuts to the run2()/run3() models.
+ * 
+ * @param enable 
+ */
+void MacroPlacer::setUserCuts(bool enable) {
+    m_userCuts = enable;
+}
+
+/**
+ * @brief Use the site coordinates and blocked sites of <siteFileName> (see readSiteGeometry()); "" for unit-spaced sites.
+ * The file is read again only when the name or the site size changes.
+ * 
+ * @param siteFileName 
+ * @return true if the geometry is in place.
+ */
+bool MacroPlacer::setSiteFile(const std::string &siteFileName) {
+    if (siteFileName == "") {
+        m_siteFileName = "";
+        m_siteGeometry.reset();
+        return true;
+    }
+    if (siteFileName == m_siteFileName && m_siteGeometry
+        && m_siteGeometry->sizeY() == m_siteSizeY && m_siteGeometry->sizeX() == m_siteSizeX) {
+        return true;
+    }
+    m_siteFileName = siteFileName;
+    if (!readSiteGeometry(siteFileName, m_siteSizeY, m_siteSizeX, m_siteGeometry)) {
+        m_siteFileName = "";
+        m_siteGeometry.reset();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read the design netlist <netlistFileName> (see Netlist) for setProblemSizeFromNetlist(), fillDspIdArray()
+ * and flow(). The file is read again only when the name changes.
+ * 
+ * @param netlistFileName 
+ * @return true if the netlist is in place.
+ */
+bool MacroPlacer::setNetlistFile(const std::string &netlistFileName) {
+    if (netlistFileName == m_netlistFileName && m_nl) {
+        return true;
+    }
+    std::shared_ptr<Netlist> nl = std::make_shared<Netlist>();
+    if (!nl->read(netlistFileName)) {
+        m_netlistFileName = "";
+        m_nl.reset();
+        return false;
+    }
+    m_netlistFileName = netlistFileName;
+    m_nl = nl;
+    return true;
+}
+
+/**
+ * @brief Set the number of Gurobi environments kept by the pool shared across jobs. Only takes effect before the first solve.
+ * 
+ * @param size 0: hardware concurrency.
+ */
+void MacroPlacer::setEnvPoolSize(int size) {
+    m_envPoolSize = size;
+}
+
+/**
+ * @brief Set the memory budget the model plan of a job must fit in (see planJob()).
+ * 
+ * @param megabytes 0: physical memory.
+ */
+void MacroPlacer::setMemoryBudget(double megabytes) {
+    m_memBudget = megabytes;
+}
+
+/**
+ * @brief The environment pool of this placer, created on first use. Sub-placers of solvePlacement() lease from it too.
+ * 
+ * @return EnvPool& 
+ */
+EnvPool & MacroPlacer::envPool() {
+    std::lock_guard<std::mutex> lock(m_envPoolMutex);
+    if (!m_envPool) {
+        int size = (m_envPoolSize > 0) ? m_envPoolSize : std::max(1u, std::thread::hardware_concurrency());
+        m_envPool.reset(new EnvPool(size));
+    }
+    return *m_envPool;
+}
+
+/**
+ * @brief The current problem settings as a PlacementProblem.
+ * 
+ * @return PlacementProblem 
+ */
+PlacementProblem MacroPlacer::problem() const {
+    PlacementProblem prob;
+    prob.arraySizeY = m_arraySizeY;
+    prob.arraySizeX = m_arraySizeX;
+    prob.siteSizeY = m_siteSizeY;
+    prob.siteSizeX = m_siteSizeX;
+    prob.weightX = m_weightX;
+    prob.weightY = m_weightY;
+    prob.relativeConstraintX = m_relativeConstraintX;
+    prob.relativeConstraintY = m_relativeConstraintY;
+    prob.geometry = m_siteGeometry;
+    return prob;
+}
+
+/**
+ * @brief Output file name (without extension) encoding the problem settings.
+ * 
+ * @return std::string 
+ */
+std::string MacroPlacer::solFileBaseName() const {
+    std::string fileName = "output/macroPl_" + std::to_string(m_arraySizeY) + "_" + std::to_string(m_arraySizeX) 
+                            + "_to_" + std::to_string(m_siteSizeY) + "_" + std::to_string(m_siteSizeX); 
+        
+    // Relative position constraints in X/Y direction.
+    fileName += "_rpXY_" + std::to_string(m_relativeConstraintX) + "_" + std::to_string(m_relativeConstraintY);
+
+    // Weights in X/Y direction.
+    fileName += "_wtXY_" + std::to_string(m_weightX) + "_" + std::to_string(m_weightY);
+
+    // Site geometry file, without directory and extension.
+    if (m_siteFileName != "") {
+        std::string name = m_siteFileName.substr(m_siteFileName.find_last_of('/') + 1);
+        fileName += "_sites_" + name.substr(0, name.find('.'));
+    }
+
+    return fileName;
+}
+
 /**
  * @brief Entry function of the macro placer.
  * 
@@ -259,9 +534,158 @@ void MacroPlacer::dbg_printProblemInfo() {
     printf("|relative ordering in Y direction:%d\n", m_relativeConstraintY);
     printf("|TimeLimit: %f\n", m_timeLimit);
     printf("|Initial solution file: %s\n", m_initSolFileName.c_str());
+    printf("|NOCMode: %d\n", m_NOCMode);
+    printf("|Threads: %d\n", m_threads);
+    printf("|Heuristic callback: %d (%.1fs per call, relaxation every %.1fs)\n", m_heurCallback, m_heurTime, m_heurInterval);
+    printf("|User cuts: %d\n", m_userCuts);
+    if (!m_solvePhases.empty()) {
+        printf("|Solve phases: %s (tolerance %g)\n", solvePhasesString(m_solvePhases).c_str(), m_phaseTol);
+    }
+    if (m_siteGeometry) {
+        printf("|Site geometry: %s (%d blocked sites)\n", m_siteFileName.c_str(), m_siteGeometry->numBlocked());
+    }
+    if (m_envPool) {
+        printf("|Environment pool: %d started, capacity %d\n", m_envPool->numCreated(), m_envPool->capacity());
+    }
     printf("-----------------------------------------------------\n");
 }
 
+/**
+ * @brief Print the model plan of a job: the predicted size of the model <method> builds and the memory budget.
+ * 
+ * @param method 
+ * @param size 
+ */
+void MacroPlacer::dbg_printModelPlan(int method, const ModelSize &size) {
+    double budget = (m_memBudget > 0) ? m_memBudget : physicalMemoryMB();
+    printf("|Model plan: method %d, memory budget %.0f MB\n", method, budget);
+    if (size.name != "") {
+        size.print("|  ");
+    }
+}
+
+/**
+ * @brief Predict the size of the largest model(s) alive at once when running <method> with the current settings.
+ * Methods 0, 7, 10 and 11 build no model; methods 5 and 6 are predicted with the current coarsest size and LNS window.
+ * 
+ * @param method 
+ * @return ModelSize 
+ */
+ModelSize MacroPlacer::estimateMethod(int method) {
+    PlacementProblem prob = problem();
+    const bool oneColumnROC = (m_siteSizeX == 1 && m_relativeConstraintY);
+    ModelSize size;
+    if (method == 1 && m_siteSizeX == 1) {
+        prob.strictOrderY = m_relativeConstraintY;
+        size = estimateOneColumnModel(prob, m_NOCMode);
+    }
+    else if (method == 1 || method == 2) {
+        size = estimateGeneralModel(prob, m_NOCMode);
+    }
+    else if (method == 3) {
+        prob.strictOrderY = oneColumnROC;
+        size = oneColumnROC ? estimateOneColumnModel(prob, m_NOCMode) : estimateGeneralModel(prob, m_NOCMode);
+        size.copies = (m_portfolioSize > 0) ? m_portfolioSize : 2;
+        size.finish();
+    }
+    else if (method == 4) {
+        // Stage 2 is the larger model: run2() with the job's own relative constraints.
+        size = estimateGeneralModel(prob, m_NOCMode);
+    }
+    else if (method == 5) {
+        prob.strictOrderY = oneColumnROC;
+        MultilevelPlacer ml(prob, nullptr);
+        ml.setCoarsestCells(m_mlCoarsestCells);
+        PlacementProblem coarse = ml.coarsestProblem();
+        size = coarse.strictOrderY ? estimateOneColumnModel(coarse, m_NOCMode) : estimateGeneralModel(coarse, m_NOCMode);
+        size.name += ", coarsest level " + std::to_string(coarse.arraySizeY) + " x " + std::to_string(coarse.arraySizeX);
+    }
+    else if (method == 6) {
+        LNSPlacer lns(prob, nullptr);
+        if (m_lnsWindowRows > 0) {
+            lns.setWindowSize(m_lnsWindowRows, (m_lnsWindowCols > 0) ? m_lnsWindowCols : std::min(m_siteSizeX, 4));
+        }
+        size = estimateWindowModel(prob, lns.windowRows(), lns.windowCols(), m_NOCMode);
+        size.copies = (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+        size.finish();
+    }
+    else if (method == 8) {
+        prob.strictOrderY = oneColumnROC;
+        TilePlacer tiler(prob, nullptr);
+        tiler.setTileSize(m_tileRows, m_tileCols);
+        PlacementProblem tile;
+        if (!tiler.tileProblem(tile)) {
+            size.name = "tiling, no tile fits";
+        }
+        else if (m_siteSizeX == 1) {
+            // One-column tiles are solved by CPPlacer, without a model.
+            size.name = "CP tile";
+        }
+        else {
+            size = estimateGeneralModel(tile, m_NOCMode);
+        }
+        size.name += ", tile " + std::to_string(tile.arraySizeY) + " x " + std::to_string(tile.arraySizeX);
+        size.finish();
+    }
+    else if (method == 9) {
+        // One full-height column window per thread.
+        size = estimateWindowModel(prob, m_siteSizeY, 1, m_NOCMode);
+        size.copies = (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+        size.finish();
+    }
+    return size;
+}
+
+/**
+ * @brief Plan the job before any model is built: predict the model size of <method> and, if it exceeds the memory
+ * budget, down-select to a method that fits: one portfolio member instead of several, then multilevel (decomposed)
+ * with the largest coarsest level that fits, then LNS with the largest window that fits.
+ * 
+ * @param method 
+ * @return int the method to run, -1 if nothing fits.
+ */
+int MacroPlacer::planJob(int method) {
+    const double budget = (m_memBudget > 0) ? m_memBudget : physicalMemoryMB();
+    ModelSize size = estimateMethod(method);
+    dbg_printModelPlan(method, size);
+    if (method == 0 || method == 7 || method == 10 || method == 11 || size.fits(budget)) {
+        return method;
+    }
+    printf("WRN: method %d needs ~%.0f MB, over the budget of %.0f MB.\n", method, size.memoryMB, budget);
+
+    if (method == 3) {
+        size = estimateMethod(1);
+        if (size.fits(budget)) {
+            printf("|=> method 1 (single model)\n");
+            size.print("|  ");
+            return 1;
+        }
+    }
+    if (method != 6) {
+        for (int cells = m_mlCoarsestCells; cells >= 4; cells /= 2) {
+            setMultilevelCoarsestCells(cells);
+            size = estimateMethod(5);
+            if (size.fits(budget)) {
+                printf("|=> method 5 (multilevel, coarsest %d cells)\n", cells);
+                size.print("|  ");
+                return 5;
+            }
+        }
+    }
+    LNSPlacer lns(problem(), nullptr);
+    int rows = (m_lnsWindowRows > 0) ? m_lnsWindowRows : lns.windowRows();
+    for (; rows >= 2; rows /= 2) {
+        setLNSWindow(rows, m_lnsWindowCols, m_lnsWindowTime);
+        size = estimateMethod(6);
+        if (size.fits(budget)) {
+            printf("|=> method 6 (LNS, windows of %d rows)\n", rows);
+            size.print("|  ");
+            return 6;
+        }
+    }
+    return -1;
+}
+
 /**
  * @brief Another ILP routine with differenct formulation from run();
  * 
@@ -270,194 +694,59 @@ void MacroPlacer::run2() {
     printf("run2() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
     dbg_printProblemInfo();
     
-    GRBEnv env = GRBEnv();
-    GRBModel model = GRBModel(env);
+    EnvPool::Lease lease = envPool().lease(solFileBaseName() + ".log");
+    GRBModel model = GRBModel(lease.env());
 
     // Set time limit.
     printf("set time limit");
     if (m_timeLimit > 0) {
         model.set(GRB_DoubleParam_TimeLimit, m_timeLimit);
     }
-    model.set(GRB_DoubleParam_NoRelHeurTime, m_timeLimit * 0.80);
-
-    // Add decision variables.
-    
-    // DBG("Adding variables..\n");
-    printf("Start Adding variables..\n");
-    GRBVar x[m_arraySizeY][m_arraySizeX]; 
-    GRBVar y[m_arraySizeY][m_arraySizeX]; 
-    
-    // dx[i0][j0][i1][j1] = x[i0][j0] - x[i1][j1]
-    // dy[i0][j0][i1][j1] = y[i0][j0] - y[i1][j1]
-    GRBVar dx[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-    GRBVar dy[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-
-    // absDx[i0][j0][i1][j1] = |dx[i0][j0][i1][j1]|
-    // absDy[i0][j0][i1][j1] = |dy[i0][j0][i1][j1]|
-    GRBVar absDx[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-    GRBVar absDy[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-
-
-    // Add constraints.
-
-    int i, j, m, n;
-    int i0, j0, i1, j1;
-    std::string s, s_index;
-
-    // 0 <= xi <= m_siteSizeX.
-    // 0 <= yi <= m_siteSizeY.
-
-    printf("Adding variables..\n");
-    for (i = 0; i < m_arraySizeY; i++) {
-        for (j = 0; j < m_arraySizeX; j++) {
-            s = "X_" + std::to_string(i) + "_" + std::to_string(j);
-            x[i][j] = model.addVar(0, m_siteSizeX - 1, 0, GRB_INTEGER, s);
-            s = "Y_" + std::to_string(i) + "_" + std::to_string(j);
-            y[i][j] = model.addVar(0, m_siteSizeY - 1, 0, GRB_INTEGER, s);
-        }
+    if (m_solvePhases.empty()) {
+        model.set(GRB_DoubleParam_NoRelHeurTime, m_timeLimit * 0.80);
     }
 
-    // x0 <= x1, y0 <= y1 to remove mirrored solutions.
-    // model.addConstr(x[0][0] <= x[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_x");
-    // model.addConstr(y[0][0] <= y[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_y");
-
-
-    // |x0 - x1| + |y0 - y1| >= 1 to make sure cell[0] and cell[1] don't overlap.
-    // DBG("Setting constraints..\n");
-    printf("Setting constraints..\n");
-    for (i0 = 0; i0 < m_arraySizeY; i0++) {
-        for (j0 = 0; j0 < m_arraySizeX; j0++) {
-            for (i1 = i0; i1 < m_arraySizeY; i1++) {
-                for (j1 = 0; j1 < m_arraySizeX; j1++) {
-                    
-                    if (i0 == i1 && j0 >= j1) {
-                        continue;
-                    }
-                    
-                    s_index = "[" + std::to_string(i0) + "][" + std::to_string(j0) + "]_["
-                        + std::to_string(i1) + "][" + std::to_string(j1) + "]";
-
-                    dx[i0][j0][i1][j1] = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER, "dx" + s_index);
-                    model.addConstr(dx[i0][j0][i1][j1] == x[i0][j0] - x[i1][j1], "constr_dx" + s_index);
-
-                    // DBG("AddVar: absDx[%d][%d][%d][%d]\n", i0, j0, i1, j1);
-                    absDx[i0][j0][i1][j1] = model.addVar(0, GRB_INFINITY, 0, GRB_INTEGER, "absDx" + s_index);
-                    model.addGenConstrAbs(absDx[i0][j0][i1][j1], dx[i0][j0][i1][j1], "constr_absDx" + s_index);
-
-                    dy[i0][j0][i1][j1] = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER, "dy" + s_index);
-                    model.addConstr(dy[i0][j0][i1][j1] == y[i0][j0] - y[i1][j1], "constr_dy" + s_index);
-
-                    // DBG("AddVar: absDy[%d][%d][%d][%d]\n", i0, j0, i1, j1);
-                    absDy[i0][j0][i1][j1] = model.addVar(0, GRB_INFINITY, 0, GRB_INTEGER, "absDy" + s_index);
-                    model.addGenConstrAbs(absDy[i0][j0][i1][j1], dy[i0][j0][i1][j1], "constr_absDy" + s_index);
-
-                    model.addConstr(absDx[i0][j0][i1][j1] + absDy[i0][j0][i1][j1] >= 1, "no_overlap" + s_index);
-
-                }
-            }
-        }
-    } 
-
-
-    if (m_relativeConstraintX || m_relativeConstraintY) {
-        printf("Adding relative constraints..\n");
-        // set additional constraints on relative position.
-        for (i = 0; i < m_arraySizeY; i++) {
-            for (j = 0; j < m_arraySizeX; j++) {
-                if (m_relativeConstraintX && j < m_arraySizeX - 1) {
-                    s = "const_relativeX_" + std::to_string(i) + "_" + std::to_string(j);
-                    model.addConstr(x[i][j] <= x[i][j+1], s);
-                }
-                if (m_relativeConstraintY && i < m_arraySizeY - 1) {
-                    s = "const_relativeY_" + std::to_string(i) + "_" + std::to_string(j);
-                    model.addConstr(y[i][j] <= y[i+1][j], s);
-                }
-            }
-        }
-    }
+    std::vector<GRBVar> x, y;
+    GRBLinExpr objective;
+    buildModel2(model, x, y, m_NOCMode, &objective);
 
     // Add initial solution if available.
-    // Initial solution is a file with the format:
-    // X i j value or Y i j value
-    // where it means x[i][j] = value or y[i][j] = value.
     if (m_initSolFileName != "") {
         printf("Adding initial solution from %s\n", m_initSolFileName.c_str());
-        std::ifstream file(m_initSolFileName);
-        if (file.is_open()) {
-            std::string line;
-            std::vector<std::string> tokens;
-            while (read_line_as_tokens(file, tokens)) {
-                if (tokens.size() == 4) {
-                    if (tokens[0] == "X") {
-                        i = std::stoi(tokens[1]);
-                        j = std::stoi(tokens[2]);
-                        x[i][j].set(GRB_DoubleAttr_Start, std::stod(tokens[3]));
-                    }
-                    else if (tokens[0] == "Y") {
-                        i = std::stoi(tokens[1]);
-                        j = std::stoi(tokens[2]);
-                        y[i][j].set(GRB_DoubleAttr_Start, std::stod(tokens[3]));
-                    }
-                }
-            }
-        }
+        setStartFromFile(m_initSolFileName, x, y);
     }
     else {
         printf("No initial solution file provided.\n");
     }
-                    
-
-
-    // DBG("Setting Objective..\n");
-    // objective
-
-    GRBLinExpr objTotalWl = 0;
-
-    for (i0 = 0; i0 < m_arraySizeY; i0++) {
-        for (j0 = 0; j0 < m_arraySizeX; j0++) {
-            
-            // top neighbor.
-
-            i1 = i0 + 1;
-            j1 = j0;
 
-            if (i1 < m_arraySizeY && j1 < m_arraySizeX) {
-                // DBG("AddObj: absDx[%d][%d][%d][%d] + absDy[%d][%d][%d][%d]\n", i0, j0, i1, j1, i0, j0, i1, j1);
-                objTotalWl += m_weightX * absDx[i0][j0][i1][j1] + m_weightY * absDy[i0][j0][i1][j1];
-            }
-
-            // right neighbor.
-            i1 = i0;
-            j1 = j0 + 1;
-
-            if (i1 < m_arraySizeY && j1 < m_arraySizeX) {
-                // DBG("AddObj: absDx[%d][%d][%d][%d] + absDy[%d][%d][%d][%d]\n", i0, j0, i1, j1, i0, j0, i1, j1);
-                objTotalWl += m_weightX * absDx[i0][j0][i1][j1] + m_weightY * absDy[i0][j0][i1][j1];
-            }
-            
-        }
+    // Native local search injected through the callback.
+    PlacerCallback cb(problem(), x, y);
+    if (m_heurCallback) {
+        cb.enableLocalSearch(m_heurTime, m_heurInterval);
+        model.setCallback(&cb);
     }
 
-    // Set cell[0][0] to the lower-left corner if possible.
-    // objTotalWl += 0.01 * (x[0][0] + y[0][0]);
-
-    // DBG("Setting Objective..\n");
-    printf("set objective\n");
-    try {
-        model.setObjective(objTotalWl, GRB_MINIMIZE);
-        // assert(0);
-    } catch (GRBException e) {
-        // DBG("%s\n", e.getMessage().c_str());
-        printf("Exception message: %s.\n", e.getMessage().c_str());
+    // Problem-specific user cuts from the node relaxations.
+    std::unique_ptr<CutSeparator> separator;
+    if (m_userCuts) {
+        separator.reset(new CutSeparator(problem()));
+        printf("User cuts: wirelength bound %.1f\n", separator->wirelengthBound());
+        model.set(GRB_IntParam_PreCrush, 1);
+        cb.enableCuts(separator.get(), objective, separator->wirelengthBound());
+        model.setCallback(&cb);
     }
 
-    // model.setObjective(objTotalWl, GRB_MINIMIZE);
-
     // DBG("Solve model..\n");
     printf("Solving model..\n");
     try {
         printf("optimize()\n");
-        model.optimize();
+        if (m_solvePhases.empty()) {
+            model.optimize();
+        }
+        else {
+            optimizeInPhases(model, cb);
+        }
+        noteBound(model, 1);
     } catch (GRBException e) {
         printf("Exception message: %s.\n", e.getMessage().c_str());
     }
@@ -467,14 +756,7 @@ void MacroPlacer::run2() {
     // DVD();
 
     // DBG("Writing model..\n");
-    std::string fileName = "output/macroPl_" + std::to_string(m_arraySizeY) + "_" + std::to_string(m_arraySizeX) 
-                            + "_to_" + std::to_string(m_siteSizeY) + "_" + std::to_string(m_siteSizeX); 
-        
-    // Relative position constraints in X/Y direction.
-    fileName += "_rpXY_" + std::to_string(m_relativeConstraintX) + "_" + std::to_string(m_relativeConstraintY);
-
-    // Weights in X/Y direction.
-    fileName += "_wtXY_" + std::to_string(m_weightX) + "_" + std::to_string(m_weightY);
+    std::string fileName = solFileBaseName();
 
     // Time Limit.
     fileName += "_time_" + std::to_string(m_timeLimit);
@@ -486,6 +768,7 @@ void MacroPlacer::run2() {
     try {
         printf("Writing model to %s.sol\n", fileName.c_str());
         model.write(fileName + ".sol");
+        m_lastSolFileName = fileName + ".sol";
         // DBG("Solution written to %s\n", fileName.c_str());
     } catch (GRBException e) {
         printf("Exception message: %s.\n", e.getMessage().c_str());
@@ -500,172 +783,277 @@ void MacroPlacer::run2() {
 }
 
 /**
- * @brief Mapping an m x n array into one column.
+ * @brief Build the general (multi-column) formulation used by run2() into <model>.
+ * x/y are the site coordinates of cell (i, j) at index i * m_arraySizeX + j.
  * 
+ * The no-overlap constraint |x0 - x1| + |y0 - y1| >= 1 is modeled by NOCMode:
+ * 0: absDx + absDy >= 1 with abs general constraints for every pair;
+ * 1: b == OR(x0 - x1 >= 1, x1 - x0 >= 1, y0 - y1 >= 1, y1 - y0 >= 1) with indicator constraints, b == True.
+ * On an axis where the ROC orders the pair (same row for X, same column for Y), |x0 - x1| is x1 - x0 and the
+ * impossible direction is left out of the OR.
+ * 
+ * @param model 
+ * @param x 
+ * @param y 
+ * @param NOCMode 
+ * @param objective if given, receives the objective (the weighted wirelength).
  */
-void MacroPlacer::run3() {
-    printf("run3() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
-    if (m_siteSizeX != 1) {
-        printf("WRN: %s is only used for mapping into one column! Function stops.\n", __func__);
-        return;
-    }
-    
-    GRBEnv env = GRBEnv();
-    GRBModel model = GRBModel(env);
-
-    // Set time limit.
-    if (m_timeLimit > 0) {
-        model.set(GRB_DoubleParam_TimeLimit, m_timeLimit);
-    }
+void MacroPlacer::buildModel2(GRBModel &model, std::vector<GRBVar> &x, std::vector<GRBVar> &y, int NOCMode, GRBLinExpr *objective) {
 
     // Add decision variables.
     
     // DBG("Adding variables..\n");
-    GRBVar y[m_arraySizeY][m_arraySizeX]; 
-    
-    // // dx[i0][j0][i1][j1] = x[i0][j0] - x[i1][j1]
-    // // dy[i0][j0][i1][j1] = y[i0][j0] - y[i1][j1]
-    // GRBVar dx[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-    // GRBVar dy[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-
-    // // absDx[i0][j0][i1][j1] = |dx[i0][j0][i1][j1]|
-    // // absDy[i0][j0][i1][j1] = |dy[i0][j0][i1][j1]|
-    // GRBVar absDx[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-    // GRBVar absDy[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-
+    printf("Start Adding variables..\n");
+    x.resize(m_arraySizeY * m_arraySizeX);
+    y.resize(m_arraySizeY * m_arraySizeX);
 
     // Add constraints.
 
-    int i, j, m, n;
-    int i0, j0, i1, j1;
-    std::string s, s_index;
+    int i, j;
+    std::string s;
 
     // 0 <= xi <= m_siteSizeX.
     // 0 <= yi <= m_siteSizeY.
 
+    printf("Adding variables..\n");
     for (i = 0; i < m_arraySizeY; i++) {
         for (j = 0; j < m_arraySizeX; j++) {
-            // s = "X_" + std::to_string(i) + "_" + std::to_string(j);
-            // x[i][j] = model.addVar(0, m_siteSizeX - 1, 0, GRB_INTEGER, s);
+            s = "X_" + std::to_string(i) + "_" + std::to_string(j);
+            x[cellId(i, j)] = model.addVar(0, m_siteSizeX - 1, 0, GRB_INTEGER, s);
             s = "Y_" + std::to_string(i) + "_" + std::to_string(j);
-            y[i][j] = model.addVar(0, m_siteSizeY - 1, 0, GRB_INTEGER, s);
+            y[cellId(i, j)] = model.addVar(0, m_siteSizeY - 1, 0, GRB_INTEGER, s);
         }
     }
 
     // x0 <= x1, y0 <= y1 to remove mirrored solutions.
     // model.addConstr(x[0][0] <= x[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_x");
-    model.addConstr(y[0][0] <= y[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_y");
+    // model.addConstr(y[0][0] <= y[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_y");
 
+    // Physical site coordinates for the objective (x/y themselves for unit-spaced sites) and blocked sites.
+    std::vector<GRBVar> px, py;
+    addPhysicalCoords(model, x, false, px);
+    addPhysicalCoords(model, y, true, py);
+    addBlockedSiteConstrs(model, x, y);
 
-    // No-overlap constraint (NOC) and relative ordering constraint (ROC):
-    // NOC: For each pair, y0 != y1. 
-    // ROC: If cell 0 and cell 1 are in the same row or column in the array, y0 + 1 <= y1.
-    // If the ROC is applied, we can skip the NOC as it is implicitly satisfied. 
+    // Objective: weighted WL of the array neighbors, collected while the pair variables are created.
+    GRBLinExpr objTotalWl = 0;
 
-    // There are two methods to add the NOC: (y0 != y1) => ( abs(y0-y1) >= 1 )
+    // |x0 - x1| + |y0 - y1| >= 1 to make sure cell[0] and cell[1] don't overlap.
+    // DBG("Setting constraints..\n");
+    printf("Setting constraints..\n");
+    std::vector<GRBVar> baseVars(x);
+    baseVars.insert(baseVars.end(), y.begin(), y.end());
+    baseVars.insert(baseVars.end(), px.begin(), px.end());
+    baseVars.insert(baseVars.end(), py.begin(), py.end());
+    ModelBuilder builder(model, baseVars, (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency()));
+    addPairConstrs(builder, problem(), std::vector<char>(), NOCMode);
+    builder.printStats("Pair constraints: ");
+    objTotalWl += builder.objective();
 
-    // 0: 
-    // dy = y1 - y0;
-    // dyAbs = abs(dy);
-    // dyAbs >= 1;
+    if (m_relativeConstraintX || m_relativeConstraintY) {
+        printf("Adding relative constraints..\n");
+        addRelativeConstrs(model, problem(), x, y, std::vector<char>());
+    }
 
-    // 1:
-    // b0 == 1 if y0 - y1 >= 1; 
-    // b1 == 1 if y1 - y0 >= 1; 
-    // b = b0 OR b1;
-    // b == True;
+    // Set cell[0][0] to the lower-left corner if possible.
+    // objTotalWl += 0.01 * (x[0][0] + y[0][0]);
 
-    // Toggle between these two methods by assigning values to this variable:
-    int NOCMode = 0;
+    // DBG("Setting Objective..\n");
+    printf("set objective\n");
+    if (objective) {
+        *objective = objTotalWl;
+    }
+    try {
+        model.setObjective(objTotalWl, GRB_MINIMIZE);
+        // assert(0);
+    } catch (GRBException e) {
+        // DBG("%s\n", e.getMessage().c_str());
+        printf("Exception message: %s.\n", e.getMessage().c_str());
+    }
+}
 
-    GRBVar dy[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-    GRBVar dyAbs[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
+/**
+ * @brief Set the start of x/y from a solution file.
+ * Initial solution is a file with the format:
+ * X i j value or Y i j value
+ * where it means x[i][j] = value or y[i][j] = value. Gurobi .sol files (X_i_j value) are accepted too.
+ * x is empty for the one-column formulations.
+ * 
+ * @param fileName 
+ * @param x 
+ * @param y 
+ * @return true if the file could be read.
+ */
+bool MacroPlacer::setStartFromFile(const std::string &fileName, std::vector<GRBVar> &x, std::vector<GRBVar> &y) {
+    PlacementProblem prob = problem();
+    Placement pl;
+    if (!readStartPlacement(fileName, prob, pl)) {
+        return false;
+    }
+    setStart(pl, x, y);
+    return true;
+}
 
-    GRBVar bList[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX][2];
-    GRBVar b[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
+/**
+ * @brief Read a start placement for <prob>. A solution of another shape (array or site size, see
+ * readPlacementShapeFromSol()) is embedded into <prob> by embedPlacement(), so a previous design iteration
+ * warm-starts the current one.
+ * 
+ * @param fileName 
+ * @param prob 
+ * @param pl 
+ * @return true if the file could be read (and embedded).
+ */
+bool MacroPlacer::readStartPlacement(const std::string &fileName, const PlacementProblem &prob, Placement &pl) {
+    PlacementProblem from = prob;
+    Placement fromPl;
+    if (!readPlacementShapeFromSol(fileName, from, fromPl)) {
+        return false;
+    }
+    if (from.arraySizeY == prob.arraySizeY && from.arraySizeX == prob.arraySizeX
+        && from.siteSizeY <= prob.siteSizeY && from.siteSizeX <= prob.siteSizeX) {
+        return readPlacementFromSol(fileName, prob, pl);
+    }
+    // Site rows and columns of the old job only.
+    from.geometry.reset();
+    return embedPlacement(from, fromPl, prob, m_embedMode, pl);
+}
 
-    // Add the NOC and ROC is enabled. 
-    for (i0 = 0; i0 < m_arraySizeY; i0++) {
-        for (j0 = 0; j0 < m_arraySizeX; j0++) {
-            for (i1 = i0; i1 < m_arraySizeY; i1++) {
-                for (j1 = 0; j1 < m_arraySizeX; j1++) {
+/**
+ * @brief Set the start of x/y from a placement. x is empty for the one-column formulations.
+ * 
+ * @param pl 
+ * @param x 
+ * @param y 
+ */
+void MacroPlacer::setStart(const Placement &pl, std::vector<GRBVar> &x, std::vector<GRBVar> &y) {
+    for (int c = 0; c < pl.numCells(); c++) {
+        if (!x.empty()) {
+            x[c].set(GRB_DoubleAttr_Start, pl.x(c));
+        }
+        y[c].set(GRB_DoubleAttr_Start, pl.y(c));
+    }
+}
 
-                    if (i0 == i1 && j0 >= j1) {
-                        continue;
-                    }
+/**
+ * @brief Mapping an m x n array into one column.
+ * 
+ */
+void MacroPlacer::run3() {
+    printf("run3() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    if (m_siteSizeX != 1) {
+        printf("WRN: %s is only used for mapping into one column! Function stops.\n", __func__);
+        return;
+    }
+    
+    EnvPool::Lease lease = envPool().lease(solFileBaseName() + ".log");
+    GRBModel model = GRBModel(lease.env());
 
-                    // Double for-loop: for each cell 0 and cell 1 that cell0.row <= cell1.row, and cell0.col < cell1.col.
+    // Set time limit.
+    if (m_timeLimit > 0) {
+        model.set(GRB_DoubleParam_TimeLimit, m_timeLimit);
+    }
 
-                    s_index = "[" + std::to_string(i0) + "][" + std::to_string(j0) + "]_["
-                        + std::to_string(i1) + "][" + std::to_string(j1) + "]";
-                    
-                    bool enNOC = true; // By default, NOC is enabled.
-                    
-                    // Add ROC if enabled.
+    std::vector<GRBVar> x, y;
+    GRBLinExpr objective;
+    buildModel3(model, y, m_NOCMode, &objective);
+
+    // Native local search injected through the callback.
+    PlacementProblem prob = problem();
+    prob.strictOrderY = m_relativeConstraintY;
+    PlacerCallback cb(prob, x, y);
+    if (m_heurCallback) {
+        cb.enableLocalSearch(m_heurTime, m_heurInterval);
+        model.setCallback(&cb);
+    }
 
-                    if (m_relativeConstraintY) {
+    // Problem-specific user cuts; the boundary objective is the y wirelength only under the ROC.
+    std::unique_ptr<CutSeparator> separator;
+    if (m_userCuts) {
+        separator.reset(new CutSeparator(prob));
+        const double bound = m_relativeConstraintY ? separator->boundY() : 0;
+        printf("User cuts: objective bound %.1f\n", bound);
+        model.set(GRB_IntParam_PreCrush, 1);
+        cb.enableCuts(separator.get(), objective, bound);
+        model.setCallback(&cb);
+    }
 
-                        // Since (y2 >= y1 + 1 and y1 >= y0 + 1) implies (y2 >= y0 + 2),
-                        // we only add ROC for neighbors in the same row or column.
+    if (m_solvePhases.empty()) {
+        model.optimize();
+    }
+    else {
+        optimizeInPhases(model, cb);
+    }
+    if (m_relativeConstraintY) {
+        // The boundary objective is the wirelength over weightY only under the ROC.
+        noteBound(model, m_weightY);
+    }
 
-                        // ROC for neighbors in the same row.
-                        if ((i0 == i1) && (j0 + 1 == j1)) {
-                            s = "ROC_" + s_index;
-                            model.addConstr(y[i0][j0] + 1 <= y[i1][j1], s);
-                        }
+    // DBG("Optimize() done.\n");
+    // DVD();
 
-                        // ROC for neighbors in the same column.
-                        if ((j0 == j1) && (i0 + 1 == i1)) {
-                            s = "ROC_" + s_index;
-                            model.addConstr(y[i0][j0] + 1 <= y[i1][j1], s);
-                        }
+    // DBG("Writing model..\n");
+    std::string fileName = solFileBaseName();
 
-                        // NOC is not needed for the cells in the same row or column (for both neighbors and non-neighbors).
-                        if ((i0 == i1) || (j0 == j1)) {
-                            enNOC = false;
-                        }
-                    }
+    try {
+        model.write(fileName + ".sol");
+        m_lastSolFileName = fileName + ".sol";
+        // DBG("Solution written to %s\n", fileName.c_str());
+    } catch (GRBException e) {
+        // DBG("%s\n", e.getMessage().c_str());
+    }
+    // model.write(fileName + "pl");
+    // model.write(fileName + "sol");
+    // model.write(fileName + "json");
+}
 
-                    // Add NOC if needed.
+/**
+ * @brief Build the one-column formulation used by run3() into <model>.
+ * y is the site of cell (i, j) at index i * m_arraySizeX + j.
+ * 
+ * @param model 
+ * @param y 
+ * @param NOCMode 
+ * @param objective if given, receives the objective (the boundary sum).
+ */
+void MacroPlacer::buildModel3(GRBModel &model, std::vector<GRBVar> &y, int NOCMode, GRBLinExpr *objective) {
+
+    // Add decision variables.
+    
+    // DBG("Adding variables..\n");
+    y.resize(m_arraySizeY * m_arraySizeX);
 
-                    if (enNOC) {
-                        if (NOCMode == 0) {
-                            // dy = y0 - y1;
-                            dy[i0][j0][i1][j1] = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER, "dy" + s_index);
-                            model.addConstr(dy[i0][j0][i1][j1] == y[i0][j0] - y[i1][j1], "constr_dy" + s_index);
+    int i, j;
+    std::string s;
 
-                            // dyAbs = abs(dy);
-                            dyAbs[i0][j0][i1][j1] = model.addVar(0, GRB_INFINITY, 0, GRB_INTEGER, "absDy" + s_index);
-                            model.addGenConstrAbs(dyAbs[i0][j0][i1][j1], dy[i0][j0][i1][j1], "constr_absDy" + s_index);
+    // 0 <= yi <= m_siteSizeY.
 
-                            // dyAbs >= 1;
-                            model.addConstr(dyAbs[i0][j0][i1][j1] >= 1, "no_overlap" + s_index);
-                        }
-                        else if (NOCMode == 1) {
-                            // b0 == true if y0 - y1 >= 1; 
-                            bList[i0][j0][i1][j1][0] = model.addVar(0, 1, 0, GRB_BINARY, s); 
-                            model.addGenConstrIndicator(bList[i0][j0][i1][j1][0], true, y[i0][j0] - y[i1][j1] >= 1);
-                            
-                            // b1 == 1 if y1 - y0 >= 1; 
-                            bList[i0][j0][i1][j1][1] = model.addVar(0, 1, 0, GRB_BINARY, s); 
-                            model.addGenConstrIndicator(bList[i0][j0][i1][j1][1], true, y[i1][j1] - y[i0][j0] >= 1);
-
-                            // b == b0 OR b1;
-                            model.addGenConstrOr(b[i0][j0][i1][j1], bList[i0][j0][i1][j1], 2);
-
-                            // b == True;
-                            model.addConstr(b[i0][j0][i1][j1] == true);
-                        }
-                        else {
-                            printf("ERR: Unexpected NOCMode: %d.\n", NOCMode);
-                            // assert(false);
-                        }
-                    }
+    // With ROC, [(i+1)(j+1)-1, N-(Y-i)(X-j)] from the predecessors and successors of the cell.
+    PlacementProblem prob = problem();
+    prob.strictOrderY = m_relativeConstraintY;
+    RocPresolve presolve(prob);
 
-                }
-            }
+    for (i = 0; i < m_arraySizeY; i++) {
+        for (j = 0; j < m_arraySizeX; j++) {
+            // s = "X_" + std::to_string(i) + "_" + std::to_string(j);
+            // x[i][j] = model.addVar(0, m_siteSizeX - 1, 0, GRB_INTEGER, s);
+            s = "Y_" + std::to_string(i) + "_" + std::to_string(j);
+            y[cellId(i, j)] = model.addVar(presolve.lowerY(cellId(i, j)), presolve.upperY(cellId(i, j)), 0, GRB_INTEGER, s);
         }
-    } 
+    }
+
+    // x0 <= x1, y0 <= y1 to remove mirrored solutions. Mirroring is a symmetry of unit-spaced free sites only.
+    // model.addConstr(x[0][0] <= x[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_x");
+    if (!m_siteGeometry) {
+        model.addConstr(y[cellId(0, 0)] <= y[cellId(m_arraySizeY-1, m_arraySizeX-1)], "no_mirror_y");
+    }
+
+    addOneColumnNOCAndROC(model, y, NOCMode, presolve);
+
+    // Physical row coordinates (y itself for unit-spaced sites) and blocked sites.
+    std::vector<GRBVar> py;
+    addPhysicalCoords(model, y, true, py);
+    addBlockedSiteConstrs(model, std::vector<GRBVar>(), y);
 
     // DBG("Setting Objective..\n");
     GRBLinExpr objTotalWl = 0;
@@ -676,23 +1064,26 @@ void MacroPlacer::run3() {
     for (j = 0; j < m_arraySizeX; j++) {
         
         i = m_arraySizeY - 1;
-        objTotalWl += y[i][j];
+        objTotalWl += py[cellId(i, j)];
 
         i = 0;
-        objTotalWl -= y[i][j];
+        objTotalWl -= py[cellId(i, j)];
     }
 
     // Left and right boundaries.
     for (i = 0; i < m_arraySizeY; i++) {
 
         j = 0;
-        objTotalWl -= y[i][j];
+        objTotalWl -= py[cellId(i, j)];
 
         j = m_arraySizeX - 1;
-        objTotalWl += y[i][j];
+        objTotalWl += py[cellId(i, j)];
     }
 
     // printf("Setting Objective..\n");
+    if (objective) {
+        *objective = objTotalWl;
+    }
     try {
         model.setObjective(objTotalWl, GRB_MINIMIZE);
         // printf("Setting Objective..\n");
@@ -700,275 +1091,1307 @@ void MacroPlacer::run3() {
     } catch (GRBException e) {
         printf("%s\n", e.getMessage().c_str());
     }
-    // printf("Solve model..\n");
-
-    model.optimize();
-
-    // DBG("Optimize() done.\n");
-    // DVD();
-
-    // DBG("Writing model..\n");
-    std::string fileName = "output/macroPl_" + std::to_string(m_arraySizeY) + "_" + std::to_string(m_arraySizeX) 
-                            + "_to_" + std::to_string(m_siteSizeY) + "_" + std::to_string(m_siteSizeX); 
-        
-    // Relative position constraints in X/Y direction.
-    fileName += "_rpXY_" + std::to_string(m_relativeConstraintX) + "_" + std::to_string(m_relativeConstraintY);
-
-    // Weights in X/Y direction.
-    fileName += "_wtXY_" + std::to_string(m_weightX) + "_" + std::to_string(m_weightY);
-
-    try {
-        model.write(fileName + ".sol");
-        // DBG("Solution written to %s\n", fileName.c_str());
-    } catch (GRBException e) {
-        // DBG("%s\n", e.getMessage().c_str());
-    }
-    // model.write(fileName + "pl");
-    // model.write(fileName + "sol");
-    // model.write(fileName + "json");
 }
 
-
 /**
- * @brief Given an m x n array, map it into one column with minimized cost. 
- * Costs are the sume of the coordinates of the cell on the sides specified.
- * There are four sides of the array: TOP, BOT, LEFT, RIGHT.
- * Cost = enableTop * sum(cell_Top.y) - enableBot * sum(cell_Bot.y) + enableRight * sum(cell_Right.y) - enableLeft * sum(cell_Left.y)
+ * @brief Add the no-overlap constraints (NOC) and relative ordering constraints (ROC) of the one-column formulations (run3(), run4()).
+ * 
+ * NOC: For each pair, y0 != y1. 
+ * ROC: If cell 0 and cell 1 are in the same row or column in the array, y0 + 1 <= y1.
+ * If the ROC is applied, we can skip the NOC for every pair the ROC orders by transitivity (cell 0 dominates cell 1),
+ * and for the other pairs whose presolved site bounds do not overlap (see RocPresolve).
  * 
+ * There are two methods to add the NOC: (y0 != y1) => ( abs(y0-y1) >= 1 )
+ * 
+ * 0: 
+ * dy = y1 - y0;
+ * dyAbs = abs(dy);
+ * dyAbs >= 1;
+ * 
+ * 1:
+ * b0 == 1 if y0 - y1 >= 1; 
+ * b1 == 1 if y1 - y0 >= 1; 
+ * b = b0 OR b1;
+ * b == True;
+ * 
+ * @param model 
+ * @param y 
+ * @param NOCMode 
+ * @param presolve 
  */
-void MacroPlacer::run4() {
-    printf("run 4() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
-    bool enTop = 1;
-    bool enBot = 0;
-    bool enRight = 1;
-    bool enLeft = 0;
-    if (m_siteSizeX != 1) {
-        printf("WRN: %s is only used for mapping into one column! Function stops.\n", __func__);
-        return;
+void MacroPlacer::addOneColumnNOCAndROC(GRBModel &model, const std::vector<GRBVar> &y, int NOCMode, const RocPresolve &presolve) {
+    presolve.printStats();
+    if (NOCMode != 0 && NOCMode != 1) {
+        printf("ERR: Unexpected NOCMode: %d.\n", NOCMode);
+        // assert(false);
     }
 
-    // Index temp variables.
-    int i, j, m, n;
-    int i0, j0, i1, j1;
-    std::string s, s_index;
-    
-    GRBEnv env = GRBEnv();
-    GRBModel model = GRBModel(env);
+    // Add the NOC and ROC is enabled. The pairs of each first row i0 are one block, generated in parallel.
+    ModelBuilder builder(model, y, (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency()));
+    builder.build(m_arraySizeY, [&](int i0, ModelBlock &block) {
+        std::string s_index;
+        for (int j0 = 0; j0 < m_arraySizeX; j0++) {
+            for (int i1 = i0; i1 < m_arraySizeY; i1++) {
+                for (int j1 = 0; j1 < m_arraySizeX; j1++) {
 
-    // Set time limit.
-    if (m_timeLimit > 0) {
-        model.set(GRB_DoubleParam_TimeLimit, m_timeLimit);
-    }
+                    if (i0 == i1 && j0 >= j1) {
+                        continue;
+                    }
 
-    // Add decision variables.
+                    // Double for-loop: for each cell 0 and cell 1 that cell0.row <= cell1.row, and cell0.col < cell1.col.
 
-    GRBVar y[m_arraySizeY][m_arraySizeX]; 
+                    const int y0 = ModelBlock::base(cellId(i0, j0));
+                    const int y1 = ModelBlock::base(cellId(i1, j1));
 
-    // 0 <= yi <= m_siteSizeY.
+                    s_index = "[" + std::to_string(i0) + "][" + std::to_string(j0) + "]_["
+                        + std::to_string(i1) + "][" + std::to_string(j1) + "]";
 
-    for (i = 0; i < m_arraySizeY; i++) {
-        for (j = 0; j < m_arraySizeX; j++) {
-            s = "Y_" + std::to_string(i) + "_" + std::to_string(j);
-            y[i][j] = model.addVar(0, m_siteSizeY - 1, 0, GRB_INTEGER, s);
-        }
-    }
+                    bool enNOC = true; // By default, NOC is enabled.
 
-    // Add constraints.
+                    // Add ROC if enabled.
 
-    // Remove mirrored solutions.
-    // model.addConstr(y[0][0] <= y[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_y");
-    model.addConstr(y[0][0] == 0);
-    model.addConstr(y[m_arraySizeY-1][m_arraySizeX-1] == m_arraySizeX * m_arraySizeY - 1);
+                    if (m_relativeConstraintY) {
 
+                        // Since (y2 >= y1 + 1 and y1 >= y0 + 1) implies (y2 >= y0 + 2),
+                        // we only add ROC for neighbors in the same row or column.
 
-    // No-overlap constraint (NOC) and relative ordering constraint (ROC):
-    // NOC: For each pair, y0 != y1. 
-    // ROC: If cell 0 and cell 1 are in the same row or column in the array, y0 + 1 <= y1.
-    // If the ROC is applied, we can skip the NOC as it is implicitly satisfied. 
+                        // ROC y0 + 1 <= y1 for neighbors in the same row or in the same column.
+                        if (((i0 == i1) && (j0 + 1 == j1)) || ((j0 == j1) && (i0 + 1 == i1))) {
+                            block.addRow({{y0, 1}, {y1, -1}}, GRB_LESS_EQUAL, -1, "ROC_" + s_index);
+                        }
 
-    // There are two methods to add the NOC: (y0 != y1) => ( abs(y0-y1) >= 1 )
+                        // NOC is not needed for the cells the ROC orders (for both neighbors and non-neighbors).
+                        enNOC = presolve.needsNoOverlap(i0, j0, i1, j1);
+                    }
 
-    // 0: 
-    // dy = y1 - y0;
-    // dyAbs = abs(dy);
-    // dyAbs >= 1;
+                    // Add NOC if needed.
 
-    // 1:
-    // b0 == 1 if y0 - y1 >= 1; 
-    // b1 == 1 if y1 - y0 >= 1; 
-    // b = b0 OR b1;
-    // b == True;
+                    if (enNOC && NOCMode == 0) {
+                        // dy = y0 - y1;
+                        int dy = block.addVar(-GRB_INFINITY, GRB_INFINITY, GRB_INTEGER, "dy" + s_index);
+                        block.addRow({{dy, 1}, {y0, -1}, {y1, 1}}, GRB_EQUAL, 0, "constr_dy" + s_index);
 
-    // Toggle between these two methods by assigning values to this variable:
-    int NOCMode = 0;
+                        // dyAbs = abs(dy);
+                        int dyAbs = block.addVar(0, GRB_INFINITY, GRB_INTEGER, "absDy" + s_index);
+                        block.addAbs(dyAbs, dy, "constr_absDy" + s_index);
 
-    GRBVar dy[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
-    GRBVar dyAbs[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
+                        // dyAbs >= 1;
+                        block.addRow({{dyAbs, 1}}, GRB_GREATER_EQUAL, 1, "no_overlap" + s_index);
+                    }
+                    else if (enNOC && NOCMode == 1) {
+                        // b0 == true if y0 - y1 >= 1; b1 == 1 if y1 - y0 >= 1;
+                        std::vector<int> bList(2);
+                        bList[0] = block.addVar(0, 1, GRB_BINARY, "b0" + s_index);
+                        block.addIndicator(bList[0], true, {{y0, 1}, {y1, -1}}, GRB_GREATER_EQUAL, 1);
+                        bList[1] = block.addVar(0, 1, GRB_BINARY, "b1" + s_index);
+                        block.addIndicator(bList[1], true, {{y1, 1}, {y0, -1}}, GRB_GREATER_EQUAL, 1);
+
+                        // b == b0 OR b1; b == True;
+                        int b = block.addVar(0, 1, GRB_BINARY, "b" + s_index);
+                        block.addOr(b, bList, "");
+                        block.addRow({{b, 1}}, GRB_EQUAL, 1, "");
+                    }
 
-    GRBVar bList[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX][2];
-    GRBVar b[m_arraySizeY][m_arraySizeX][m_arraySizeY][m_arraySizeX];
+                }
+            }
+        }
+    });
+    builder.printStats("Pair constraints: ");
+}
 
-    // Add the NOC and ROC is enabled. 
-    for (i0 = 0; i0 < m_arraySizeY; i0++) {
-        for (j0 = 0; j0 < m_arraySizeX; j0++) {
-            for (i1 = i0; i1 < m_arraySizeY; i1++) {
-                for (j1 = 0; j1 < m_arraySizeX; j1++) {
+/**
+ * @brief Pair constraints and objective of the run2() model, generated in parallel by <builder>: the NOC of every pair
+ * of free cells that the ROC presolve keeps, and the weighted length of every array edge with a free end.
+ * The pairs of each first row i0 are one block. The base variables of <builder> are x | y | px | py by cell id;
+ * a fixed cell needs them only where an edge reaches a free cell, as variables with lb == ub. An empty <isFree> frees
+ * every cell.
+ * 
+ * @param builder 
+ * @param prob 
+ * @param isFree by cell id.
+ * @param NOCMode 
+ */
+void MacroPlacer::addPairConstrs(ModelBuilder &builder, const PlacementProblem &prob, const std::vector<char> &isFree, int NOCMode) {
+    if (NOCMode != 0 && NOCMode != 1) {
+        printf("ERR: Unexpected NOCMode: %d.\n", NOCMode);
+    }
+    const int n = prob.numCells();
+    const int X = prob.arraySizeX;
+    std::vector<int> freeCells;
+    for (int c = 0; c < n; c++) {
+        if (isFree.empty() || isFree[c]) {
+            freeCells.push_back(c);
+        }
+    }
 
-                    if (i0 == i1 && j0 >= j1) {
-                        continue;
-                    }
+    // Pairs ordered by ROC on an axis get a linear distance on that axis.
+    RocPresolve presolve(prob);
 
-                    // Double for-loop: for each cell 0 and cell 1 that cell0.row <= cell1.row, and cell0.col < cell1.col.
+    auto addPair = [&](ModelBlock &block, int c0, int c1, bool noOverlap) {
+        const int i0 = c0 / X, j0 = c0 % X, i1 = c1 / X, j1 = c1 % X;
+        const int x0 = ModelBlock::base(c0), x1 = ModelBlock::base(c1);
+        const int y0 = ModelBlock::base(n + c0), y1 = ModelBlock::base(n + c1);
 
-                    s_index = "[" + std::to_string(i0) + "][" + std::to_string(j0) + "]_["
-                        + std::to_string(i1) + "][" + std::to_string(j1) + "]";
-                    
-                    bool enNOC = true; // By default, NOC is enabled.
-                    
-                    // Add ROC if enabled.
+        // Top or right neighbor.
+        bool isNeighbor = (i1 == i0 + 1 && j1 == j0) || (i1 == i0 && j1 == j0 + 1);
+        noOverlap = noOverlap && presolve.needsNoOverlap(i0, j0, i1, j1);
+        if (!noOverlap && !isNeighbor) {
+            return;
+        }
 
-                    if (m_relativeConstraintY) {
+        const std::string s_index = "[" + std::to_string(i0) + "][" + std::to_string(j0) + "]_["
+            + std::to_string(i1) + "][" + std::to_string(j1) + "]";
+
+        // An axis ordered by ROC has a known sign: |x0 - x1| == x1 - x0, no variables needed.
+        const bool ordX = presolve.orderedX(i0, j0, i1, j1);
+        const bool ordY = presolve.orderedY(i0, j0, i1, j1);
+
+        if ((NOCMode == 0 && noOverlap) || isNeighbor) {
+            ModelBlock::Terms absDx = {{x1, 1}, {x0, -1}};
+            if (!ordX) {
+                // dx = x0 - x1, absDx = |dx|.
+                int dx = block.addVar(-GRB_INFINITY, GRB_INFINITY, GRB_INTEGER, "dx" + s_index);
+                block.addRow({{dx, 1}, {x0, -1}, {x1, 1}}, GRB_EQUAL, 0, "constr_dx" + s_index);
+                int absDxVar = block.addVar(0, GRB_INFINITY, GRB_INTEGER, "absDx" + s_index);
+                block.addAbs(absDxVar, dx, "constr_absDx" + s_index);
+                absDx = {{absDxVar, 1}};
+            }
 
-                        // Since (y2 >= y1 + 1 and y1 >= y0 + 1) implies (y2 >= y0 + 2),
-                        // we only add ROC for neighbors in the same row or column.
+            ModelBlock::Terms absDy = {{y1, 1}, {y0, -1}};
+            if (!ordY) {
+                // dy = y0 - y1, absDy = |dy|.
+                int dy = block.addVar(-GRB_INFINITY, GRB_INFINITY, GRB_INTEGER, "dy" + s_index);
+                block.addRow({{dy, 1}, {y0, -1}, {y1, 1}}, GRB_EQUAL, 0, "constr_dy" + s_index);
+                int absDyVar = block.addVar(0, GRB_INFINITY, GRB_INTEGER, "absDy" + s_index);
+                block.addAbs(absDyVar, dy, "constr_absDy" + s_index);
+                absDy = {{absDyVar, 1}};
+            }
 
-                        // ROC for neighbors in the same row.
-                        if ((i0 == i1) && (j0 + 1 == j1)) {
-                            s = "ROC_" + s_index;
-                            model.addConstr(y[i0][j0] + 1 <= y[i1][j1], s);
-                        }
+            if (NOCMode == 0 && noOverlap) {
+                ModelBlock::Terms sum(absDx);
+                sum.insert(sum.end(), absDy.begin(), absDy.end());
+                block.addRow(sum, GRB_GREATER_EQUAL, 1, "no_overlap" + s_index);
+            }
+
+            if (isNeighbor) {
+                if (prob.geometry) {
+                    const int px0 = ModelBlock::base(2 * n + c0), px1 = ModelBlock::base(2 * n + c1);
+                    const int py0 = ModelBlock::base(3 * n + c0), py1 = ModelBlock::base(3 * n + c1);
+                    absDx = ordX ? ModelBlock::Terms{{px1, 1}, {px0, -1}} : ModelBlock::Terms{{block.absDiff(px0, px1, "absPx" + s_index), 1}};
+                    absDy = ordY ? ModelBlock::Terms{{py1, 1}, {py0, -1}} : ModelBlock::Terms{{block.absDiff(py0, py1, "absPy" + s_index), 1}};
+                }
+                for (const std::pair<int, double> &t: absDx) {
+                    block.addObj(t.first, prob.weightX * t.second);
+                }
+                for (const std::pair<int, double> &t: absDy) {
+                    block.addObj(t.first, prob.weightY * t.second);
+                }
+            }
+        }
+
+        if (NOCMode == 1 && noOverlap) {
+            // bList[k] == true implies the pair is separated in one of the four directions;
+            // the directions against a ROC order are impossible and left out.
+            std::vector<int> bList;
+            if (!ordX) {
+                bList.push_back(block.addVar(0, 1, GRB_BINARY, "b0" + s_index));
+                block.addIndicator(bList.back(), true, {{x0, 1}, {x1, -1}}, GRB_GREATER_EQUAL, 1);
+            }
+            bList.push_back(block.addVar(0, 1, GRB_BINARY, "b1" + s_index));
+            block.addIndicator(bList.back(), true, {{x1, 1}, {x0, -1}}, GRB_GREATER_EQUAL, 1);
+            if (!ordY) {
+                bList.push_back(block.addVar(0, 1, GRB_BINARY, "b2" + s_index));
+                block.addIndicator(bList.back(), true, {{y0, 1}, {y1, -1}}, GRB_GREATER_EQUAL, 1);
+            }
+            bList.push_back(block.addVar(0, 1, GRB_BINARY, "b3" + s_index));
+            block.addIndicator(bList.back(), true, {{y1, 1}, {y0, -1}}, GRB_GREATER_EQUAL, 1);
+
+            // b == OR(bList), b == True;
+            int b = block.addVar(0, 1, GRB_BINARY, "b" + s_index);
+            block.addOr(b, bList, "constr_or" + s_index);
+            block.addRow({{b, 1}}, GRB_EQUAL, 1, "no_overlap" + s_index);
+        }
+    };
+
+    builder.build(prob.arraySizeY, [&](int i0, ModelBlock &block) {
+        // Free pairs with the first cell in row i0, in cell id order.
+        auto first = std::lower_bound(freeCells.begin(), freeCells.end(), i0 * X);
+        auto last = std::lower_bound(freeCells.begin(), freeCells.end(), (i0 + 1) * X);
+        for (auto it0 = first; it0 != last; ++it0) {
+            for (auto it1 = it0 + 1; it1 != freeCells.end(); ++it1) {
+                addPair(block, *it0, *it1, true);
+            }
+        }
+        // Edges from row i0 with one fixed end: objective only, a free cell never reaches a fixed cell's site.
+        for (int j0 = 0; !isFree.empty() && j0 < X; j0++) {
+            const int c0 = prob.cellId(i0, j0);
+            if (i0 + 1 < prob.arraySizeY && isFree[c0] != isFree[c0 + X]) {
+                addPair(block, c0, c0 + X, false);
+            }
+            if (j0 + 1 < X && isFree[c0] != isFree[c0 + 1]) {
+                addPair(block, c0, c0 + 1, false);
+            }
+        }
+    });
+}
+
+/**
+ * @brief ROC along the array edges with a free end (all edges for an empty <isFree>): x0 <= x1 along a row and
+ * y0 <= y1 along a column, or y0 + 1 <= y1 along both for the one-column ROC (prob.strictOrderY).
+ * 
+ * @param model 
+ * @param prob 
+ * @param x by cell id.
+ * @param y by cell id.
+ * @param isFree by cell id.
+ */
+void MacroPlacer::addRelativeConstrs(GRBModel &model, const PlacementProblem &prob, const std::vector<GRBVar> &x,
+                                     const std::vector<GRBVar> &y, const std::vector<char> &isFree) {
+    auto hasFreeEnd = [&](int c0, int c1) { return isFree.empty() || isFree[c0] || isFree[c1]; };
+    std::string s;
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            const int c0 = prob.cellId(i, j);
+            if (j < prob.arraySizeX - 1 && hasFreeEnd(c0, c0 + 1)) {
+                s = "const_relativeX_" + std::to_string(i) + "_" + std::to_string(j);
+                if (prob.strictOrderY) {
+                    model.addConstr(y[c0] + 1 <= y[c0 + 1], s);
+                }
+                else if (prob.relativeConstraintX) {
+                    model.addConstr(x[c0] <= x[c0 + 1], s);
+                }
+            }
+            if (i < prob.arraySizeY - 1 && hasFreeEnd(c0, c0 + prob.arraySizeX)) {
+                s = "const_relativeY_" + std::to_string(i) + "_" + std::to_string(j);
+                if (prob.strictOrderY) {
+                    model.addConstr(y[c0] + 1 <= y[c0 + prob.arraySizeX], s);
+                }
+                else if (prob.relativeConstraintY) {
+                    model.addConstr(y[c0] <= y[c0 + prob.arraySizeX], s);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Physical coordinates of site index variables <v>: pv[k] == coord(v[k]) as a piecewise-linear constraint through
+ * the site coordinate table, exact at the integer site indices. Without a site geometry pv is v itself.
+ * 
+ * @param model 
+ * @param v site row (isY) or column indices.
+ * @param isY 
+ * @param pv 
+ */
+void MacroPlacer::addPhysicalCoords(GRBModel &model, const std::vector<GRBVar> &v, bool isY, std::vector<GRBVar> &pv) {
+    if (!m_siteGeometry) {
+        pv = v;
+        return;
+    }
+    const std::vector<double> &coord = isY ? m_siteGeometry->coordsY() : m_siteGeometry->coordsX();
+    std::vector<double> index(coord.size());
+    for (size_t k = 0; k < index.size(); k++) {
+        index[k] = k;
+    }
+    pv.resize(v.size());
+    for (size_t k = 0; k < v.size(); k++) {
+        pv[k] = model.addVar(coord.front(), coord.back(), 0, GRB_CONTINUOUS);
+        model.addGenConstrPWL(v[k], pv[k], coord.size(), index.data(), coord.data());
+    }
+}
+
+/**
+ * @brief Keep every cell off the blocked sites of the site geometry: |x - bx| + |y - by| >= 1 per cell and blocked site,
+ * or |y - by| >= 1 for the one-column formulations (x empty).
+ * 
+ * @param model 
+ * @param x 
+ * @param y 
+ * @param win if given, only the blocked sites inside it (the cells are bounded to it).
+ */
+void MacroPlacer::addBlockedSiteConstrs(GRBModel &model, const std::vector<GRBVar> &x, const std::vector<GRBVar> &y, const SiteWindow *win) {
+    if (!m_siteGeometry || m_siteGeometry->numBlocked() == 0) {
+        return;
+    }
+    for (int sy = 0; sy < m_siteSizeY; sy++) {
+        for (int sx = 0; sx < m_siteSizeX; sx++) {
+            if (!m_siteGeometry->blocked(sy, sx) || (win && !win->contains(sy, sx))) {
+                continue;
+            }
+            for (size_t c = 0; c < y.size(); c++) {
+                GRBVar dy = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER);
+                model.addConstr(dy == y[c] - sy);
+                GRBVar absDy = model.addVar(0, GRB_INFINITY, 0, GRB_INTEGER);
+                model.addGenConstrAbs(absDy, dy);
+                if (x.empty()) {
+                    model.addConstr(absDy >= 1);
+                    continue;
+                }
+                GRBVar dx = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER);
+                model.addConstr(dx == x[c] - sx);
+                GRBVar absDx = model.addVar(0, GRB_INFINITY, 0, GRB_INTEGER);
+                model.addGenConstrAbs(absDx, dx);
+                model.addConstr(absDx + absDy >= 1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief A continuous variable equal to |v0 - v1|.
+ * 
+ * @param model 
+ * @param v0 
+ * @param v1 
+ * @param name 
+ * @return GRBVar 
+ */
+GRBVar MacroPlacer::addAbsDiff(GRBModel &model, const GRBVar &v0, const GRBVar &v1, const std::string &name) {
+    GRBVar d = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_CONTINUOUS, "d_" + name);
+    model.addConstr(d == v0 - v1);
+    GRBVar a = model.addVar(0, GRB_INFINITY, 0, GRB_CONTINUOUS, name);
+    model.addGenConstrAbs(a, d);
+    return a;
+}
+
+/**
+ * @brief Record the lower bound and the optimality of the job's solved model for the best-known registry.
+ * Safe to call from concurrent solves.
+ * 
+ * @param model after optimize().
+ * @param scale the wirelength per unit of the model's objective.
+ */
+void MacroPlacer::noteBound(GRBModel &model, double scale) {
+    try {
+        const int status = model.get(GRB_IntAttr_Status);
+        const double bound = scale * model.get(GRB_DoubleAttr_ObjBound);
+        std::lock_guard<std::mutex> lock(m_boundMutex);
+        m_lastBound = std::max(m_lastBound, bound);
+        m_lastOptimal = m_lastOptimal || (status == GRB_OPTIMAL);
+    } catch (GRBException e) {
+        printf("WRN: No bound: %s\n", e.getMessage().c_str());
+    }
+}
+
+/**
+ * @brief Optimize <model> through the job's solve phases (see SolvePhase). Each phase sets its parameters and runs
+ * until <cb> aborts it for stalling; the next phase then re-optimizes, which resumes the search from its current
+ * incumbent and tree. The phases share the job's time limit. A stalled last phase ends the solve early.
+ * 
+ * @param model built, with its start solution.
+ * @param cb the model's callback; installed here.
+ */
+void MacroPlacer::optimizeInPhases(GRBModel &model, PlacerCallback &cb) {
+    StallMonitor monitor(m_phaseTol);
+    cb.setStallMonitor(&monitor);
+    model.setCallback(&cb);
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t k = 0; k < m_solvePhases.size(); k++) {
+        const SolvePhase &phase = m_solvePhases[k];
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double remaining = m_timeLimit - elapsed.count();
+        if (m_timeLimit > 0 && remaining <= 0) {
+            break;
+        }
+        if (m_timeLimit > 0) {
+            model.set(GRB_DoubleParam_TimeLimit, remaining);
+        }
+        // NoRel runs before the root relaxation only, until its time is up or the callback aborts it.
+        model.set(GRB_DoubleParam_NoRelHeurTime, (phase.kind == SolvePhase::NOREL) ? ((m_timeLimit > 0) ? remaining : GRB_INFINITY) : 0);
+        model.set(GRB_IntParam_MIPFocus, phase.mipFocus());
+        printf("Solve phase %zu/%zu <%s>, %.1fs elapsed\n", k + 1, m_solvePhases.size(), solvePhasesString({phase}).c_str(), elapsed.count());
+
+        monitor.startPhase(phase);
+        model.optimize();
+        if (model.get(GRB_IntAttr_Status) != GRB_INTERRUPTED || !monitor.stalled()) {
+            break;
+        }
+        printf("Solve phase <%s> stalled after %.1fs: incumbent %g, bound %g\n", phase.name(), monitor.phaseTime(), monitor.incumbent(), monitor.bound());
+        if (k + 1 == m_solvePhases.size()) {
+            printf("Solve phases: the last phase stalled, stopping early.\n");
+        }
+    }
+    cb.setStallMonitor(nullptr);
+}
+
+
+/**
+ * @brief Given an m x n array, map it into one column with minimized cost. 
+ * Costs are the sume of the coordinates of the cell on the sides specified.
+ * There are four sides of the array: TOP, BOT, LEFT, RIGHT.
+ * Cost = enableTop * sum(cell_Top.y) - enableBot * sum(cell_Bot.y) + enableRight * sum(cell_Right.y) - enableLeft * sum(cell_Left.y)
+ * 
+ */
+void MacroPlacer::run4() {
+    printf("run 4() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    if (m_siteSizeX != 1) {
+        printf("WRN: %s is only used for mapping into one column! Function stops.\n", __func__);
+        return;
+    }
+    
+    EnvPool::Lease lease = envPool().lease(solFileBaseName() + ".log");
+    GRBModel model = GRBModel(lease.env());
+
+    // Set time limit.
+    if (m_timeLimit > 0) {
+        model.set(GRB_DoubleParam_TimeLimit, m_timeLimit);
+    }
+
+    std::vector<GRBVar> x, y;
+    buildModel4(model, y, m_NOCMode);
+
+    // The callback only watches the solve phases: its local search minimizes the wirelength, not the side cost.
+    PlacementProblem prob = problem();
+    prob.strictOrderY = m_relativeConstraintY;
+    PlacerCallback cb(prob, x, y);
+    if (m_heurCallback) {
+        printf("WRN: %s ignores heurCallback: the local search does not minimize the side cost.\n", __func__);
+    }
+
+    if (m_solvePhases.empty()) {
+        model.optimize();
+    }
+    else {
+        optimizeInPhases(model, cb);
+    }
+
+    // DBG("Optimize() done.\n");
+    // DVD();
+
+    // DBG("Writing model..\n");
+    std::string fileName = solFileBaseName();
+
+    try {
+        model.write(fileName + ".sol");
+        m_lastSolFileName = fileName + ".sol";
+        // DBG("Solution written to %s\n", fileName.c_str());
+    } catch (GRBException e) {
+        // DBG("%s\n", e.getMessage().c_str());
+    }
+    // model.write(fileName + "pl");
+    // model.write(fileName + "sol");
+    // model.write(fileName + "json");
+}
+
+/**
+ * @brief Build the one-column formulation with side costs used by run4() into <model>.
+ * 
+ * @param model 
+ * @param y 
+ * @param NOCMode 
+ */
+void MacroPlacer::buildModel4(GRBModel &model, std::vector<GRBVar> &y, int NOCMode) {
+    bool enTop = 1;
+    bool enBot = 0;
+    bool enRight = 1;
+    bool enLeft = 0;
+
+    // Index temp variables.
+    int i, j;
+    std::string s;
+
+    // Add decision variables.
+
+    y.resize(m_arraySizeY * m_arraySizeX);
+
+    // 0 <= yi <= m_siteSizeY.
+
+    // With ROC, [(i+1)(j+1)-1, N-(Y-i)(X-j)] from the predecessors and successors of the cell.
+    PlacementProblem prob = problem();
+    prob.strictOrderY = m_relativeConstraintY;
+    RocPresolve presolve(prob);
+
+    for (i = 0; i < m_arraySizeY; i++) {
+        for (j = 0; j < m_arraySizeX; j++) {
+            s = "Y_" + std::to_string(i) + "_" + std::to_string(j);
+            y[cellId(i, j)] = model.addVar(presolve.lowerY(cellId(i, j)), presolve.upperY(cellId(i, j)), 0, GRB_INTEGER, s);
+        }
+    }
+
+    // Add constraints.
+
+    // Remove mirrored solutions.
+    // model.addConstr(y[0][0] <= y[m_arraySizeY-1][m_arraySizeX-1], "no_mirror_y");
+    model.addConstr(y[cellId(0, 0)] == 0);
+    model.addConstr(y[cellId(m_arraySizeY-1, m_arraySizeX-1)] == m_arraySizeX * m_arraySizeY - 1);
+
+    addOneColumnNOCAndROC(model, y, NOCMode, presolve);
+
+    // Physical row coordinates (y itself for unit-spaced sites) and blocked sites.
+    std::vector<GRBVar> py;
+    addPhysicalCoords(model, y, true, py);
+    addBlockedSiteConstrs(model, std::vector<GRBVar>(), y);
+
+    // DBG("Setting Objective..\n");
+    GRBLinExpr objTotalWl = 0;
+
+    // When relative constraints are satisfied, total WL only depends on the coordinates of the cells on the boundaries of the PE array.
+
+    // Top and bottom boundaries.
+    for (j = 0; j < m_arraySizeX; j++) {
+        
+        if (enTop) {
+            i = m_arraySizeY - 1;
+            objTotalWl += py[cellId(i, j)];
+        }
+
+        if (enBot) {
+            i = 0;
+            objTotalWl -= py[cellId(i, j)];
+        }
+    }
+
+    // Left and right boundaries.
+    for (i = 0; i < m_arraySizeY; i++) {
+
+        if (enRight) {
+            j = m_arraySizeX - 1;
+            objTotalWl += py[cellId(i, j)];
+        }
+
+        if (enLeft) {
+            j = 0;
+            objTotalWl -= py[cellId(i, j)];
+        }
+
+    }
+
+    // Minus the cost if the corner cell counted twice.
+    if (enRight && enTop) {
+        objTotalWl -= py[cellId(m_arraySizeY-1, m_arraySizeX-1)];
+    }
+
+    // Minus the cost if the corner cell counted twice.
+    if (enLeft && enBot) {
+        objTotalWl -= py[cellId(0, 0)];
+    }
+
+    // printf("Setting Objective..\n");
+    try {
+        model.setObjective(objTotalWl, GRB_MINIMIZE);
+        // printf("Setting Objective..\n");
+        // assert(0);
+    } catch (GRBException e) {
+        printf("setObjective: %s\n", e.getMessage().c_str());
+    }
+}
+
+/**
+ * @brief Solve the job with a portfolio of formulations running concurrently.
+ * Members split the thread budget, share incumbents through an IncumbentPool,
+ * and all stop as soon as one proves optimality or the time limit expires.
+ * 
+ * One column with ROC in Y: run3() formulation with NOCMode 0 and 1.
+ * Otherwise: run2() formulation with NOCMode 0 and 1.
+ * Additional members (m_portfolioSize > 2) alternate these with other seeds and MIPFocus=1.
+ * run4() is not a member since its objective differs from the job's wirelength.
+ * 
+ */
+void MacroPlacer::runPortfolio() {
+    printf("runPortfolio() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+
+    bool oneColumn = (m_siteSizeX == 1 && m_relativeConstraintY);
+    PlacementProblem prob = problem();
+    prob.strictOrderY = oneColumn;
+
+    int numMembers = (m_portfolioSize > 0) ? m_portfolioSize : 2;
+    int numThreads = (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+    int threadsPerMember = std::max(1, numThreads / numMembers);
+    printf("Portfolio: %d members, %d threads each, formulation run%d\n", numMembers, threadsPerMember, oneColumn ? 3 : 2);
+
+    IncumbentPool pool(prob, m_timeLimit);
+
+    // The initial solution, if any, is shared with all members through the pool.
+    if (m_initSolFileName != "") {
+        Placement pl;
+        if (readStartPlacement(m_initSolFileName, prob, pl)) {
+            pool.offer(pl, -1);
+        }
+    }
+
+    envPool().reserve(numMembers);
+    std::vector<std::thread> members;
+    for (int k = 0; k < numMembers; k++) {
+        members.emplace_back(&MacroPlacer::runPortfolioMember, this, k, oneColumn, threadsPerMember, std::ref(pool));
+    }
+    for (std::thread &t: members) {
+        t.join();
+    }
+
+    Placement best;
+    double bestObj;
+    if (pool.best(best, bestObj)) {
+        std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_portfolio";
+        printf("Portfolio best: %.1f. Writing to %s.sol\n", bestObj, fileName.c_str());
+        writePlacementToSol(fileName + ".sol", prob, best);
+        m_lastSolFileName = fileName + ".sol";
+    }
+    else {
+        printf("WRN: Portfolio found no solution.\n");
+    }
+}
+
+/**
+ * @brief Build and solve one portfolio member. Runs in its own thread with its own leased environment and log file.
+ * 
+ * @param memberId 
+ * @param oneColumn use the run3() formulation instead of run2().
+ * @param threads 
+ * @param pool 
+ */
+void MacroPlacer::runPortfolioMember(int memberId, bool oneColumn, int threads, IncumbentPool &pool) {
+    int NOCMode = memberId % 2;
+    int seed = memberId / 2;
+    PlacementProblem prob = problem();
+    prob.strictOrderY = oneColumn;
+
+    try {
+        EnvPool::Lease lease = envPool().lease(solFileBaseName() + "_portfolio_" + std::to_string(memberId) + ".log");
+        lease.env().set(GRB_IntParam_LogToConsole, memberId == 0);
+        GRBModel model = GRBModel(lease.env());
+
+        std::vector<GRBVar> x, y;
+        if (oneColumn) {
+            buildModel3(model, y, NOCMode);
+        }
+        else {
+            buildModel2(model, x, y, NOCMode);
+        }
+
+        model.set(GRB_IntParam_Threads, threads);
+        model.set(GRB_IntParam_Seed, seed);
+        if (seed % 2 == 1) {
+            model.set(GRB_IntParam_MIPFocus, 1);
+        }
+        if (m_timeLimit > 0) {
+            model.set(GRB_DoubleParam_TimeLimit, m_timeLimit);
+        }
+
+        Placement pl;
+        double obj;
+        int version = 0;
+        if (pool.fetchIfNewer(version, pl, obj)) {
+            setStart(pl, x, y);
+        }
+
+        PlacerCallback cb(prob, x, y);
+        cb.setIncumbentPool(&pool, memberId);
+        if (m_heurCallback) {
+            cb.enableLocalSearch(m_heurTime, m_heurInterval);
+        }
+        model.setCallback(&cb);
+
+        if (pool.shouldStop()) {
+            return;
+        }
+        model.optimize();
+
+        noteBound(model, oneColumn ? m_weightY : 1);
+        int status = model.get(GRB_IntAttr_Status);
+        printf("Portfolio: member %d (NOCMode %d, seed %d) stopped with status %d\n", memberId, NOCMode, seed, status);
+        if (status == GRB_OPTIMAL) {
+            pool.requestStop();
+        }
+    } catch (GRBException e) {
+        printf("Portfolio member %d: %s\n", memberId, e.getMessage().c_str());
+    }
+}
+
+/**
+ * @brief Two-stage pipeline. Stage 1 solves the ROC-restricted model (relative constraints in X and Y)
+ * with m_pipelineFraction of the time limit; one column uses the run3() formulation, otherwise run2().
+ * Its best placement is a feasible start and a cutoff for stage 2, the run2() model with the job's own
+ * relative constraints, which gets the remaining time. Both stages share one environment.
+ * 
+ */
+void MacroPlacer::runPipeline() {
+    printf("runPipeline() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+    if (m_relativeConstraintX && m_relativeConstraintY) {
+        printf("WRN: %s: the job is already ROC-restricted, stage 1 solves the same problem.\n", __func__);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const bool rocX = m_relativeConstraintX;
+    const bool rocY = m_relativeConstraintY;
+    const bool oneColumn = (m_siteSizeX == 1);
+
+    EnvPool::Lease lease = envPool().lease(solFileBaseName() + "_pipeline.log");
+    GRBEnv &env = lease.env();
+    Placement rocPl;
+    double rocObj = 0;
+
+    // Stage 1: ROC-restricted model.
+    setRelativeConstraintXY(1, 1);
+    try {
+        printf("Pipeline stage 1: ROC-restricted run%d model.\n", oneColumn ? 3 : 2);
+        GRBModel model = GRBModel(env);
+        std::vector<GRBVar> x, y;
+        if (oneColumn) {
+            buildModel3(model, y, m_NOCMode);
+        }
+        else {
+            buildModel2(model, x, y, m_NOCMode);
+        }
+        if (m_timeLimit > 0) {
+            model.set(GRB_DoubleParam_TimeLimit, m_timeLimit * m_pipelineFraction);
+        }
+        if (m_threads > 0) {
+            model.set(GRB_IntParam_Threads, m_threads);
+        }
+        if (m_initSolFileName != "") {
+            setStartFromFile(m_initSolFileName, x, y);
+        }
+
+        PlacementProblem prob = problem();
+        prob.strictOrderY = oneColumn;
+        PlacerCallback cb(prob, x, y);
+        if (m_heurCallback) {
+            cb.enableLocalSearch(m_heurTime, m_heurInterval);
+            model.setCallback(&cb);
+        }
+
+        model.optimize();
+        if (getPlacement(model, x, y, rocPl)) {
+            rocObj = placementWirelength(prob, rocPl);
+            printf("Pipeline stage 1: status %d, wirelength %.1f.\n", model.get(GRB_IntAttr_Status), rocObj);
+        }
+    } catch (GRBException e) {
+        printf("Pipeline stage 1: %s\n", e.getMessage().c_str());
+    }
+    setRelativeConstraintXY(rocX, rocY);
+
+    // Stage 2: the job's own model, warm-started from stage 1.
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_pipeline";
+    try {
+        printf("Pipeline stage 2: run2 model.\n");
+        GRBModel model = GRBModel(env);
+        std::vector<GRBVar> x, y;
+        buildModel2(model, x, y, m_NOCMode);
+
+        if (m_timeLimit > 0) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            double remaining = std::max(1.0, m_timeLimit - elapsed.count());
+            model.set(GRB_DoubleParam_TimeLimit, remaining);
+            model.set(GRB_DoubleParam_NoRelHeurTime, remaining * 0.80);
+        }
+        if (m_threads > 0) {
+            model.set(GRB_IntParam_Threads, m_threads);
+        }
+
+        if (!rocPl.empty()) {
+            setStart(rocPl, x, y);
+            // Solutions worse than the stage 1 optimum are of no interest.
+            model.set(GRB_DoubleParam_Cutoff, rocObj + 1e-6);
+        }
+        else if (m_initSolFileName != "") {
+            setStartFromFile(m_initSolFileName, x, y);
+        }
+
+        PlacerCallback cb(problem(), x, y);
+        if (m_heurCallback) {
+            cb.enableLocalSearch(m_heurTime, m_heurInterval);
+            model.setCallback(&cb);
+        }
+
+        model.optimize();
+        noteBound(model, 1);
+
+        if (model.get(GRB_IntAttr_SolCount) > 0) {
+            printf("Pipeline stage 2: status %d, wirelength %.1f. Writing model to %s.sol\n",
+                model.get(GRB_IntAttr_Status), model.get(GRB_DoubleAttr_ObjVal), fileName.c_str());
+            model.write(fileName + ".sol");
+            m_lastSolFileName = fileName + ".sol";
+            return;
+        }
+    } catch (GRBException e) {
+        printf("Pipeline stage 2: %s\n", e.getMessage().c_str());
+    }
+
+    // Stage 2 found nothing within the cutoff: the stage 1 placement is the result.
+    if (!rocPl.empty()) {
+        printf("Pipeline: keeping stage 1 placement. Writing to %s.sol\n", fileName.c_str());
+        writePlacementToSol(fileName + ".sol", problem(), rocPl);
+        m_lastSolFileName = fileName + ".sol";
+    }
+}
+
+/**
+ * @brief Multilevel V-cycle (see MultilevelPlacer). The coarsest level is solved exactly by solvePlacement().
+ * 
+ */
+void MacroPlacer::runMultilevel() {
+    printf("runMultilevel() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+
+    PlacementProblem prob = problem();
+    prob.strictOrderY = (m_siteSizeX == 1 && m_relativeConstraintY);
+
+    MultilevelPlacer ml(prob, [this](const PlacementProblem &p, double timeLimit, const Placement *start, Placement &result) {
+        return solvePlacement(p, timeLimit, start, result);
+    });
+    ml.setCoarsestCells(m_mlCoarsestCells);
+
+    Placement pl;
+    if (!ml.run(m_timeLimit, pl)) {
+        printf("WRN: Multilevel found no legal placement.\n");
+        return;
+    }
+
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_multilevel";
+    printf("Multilevel wirelength: %.1f. Writing to %s.sol\n", placementWirelength(prob, pl), fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+}
+
+/**
+ * @brief Large-neighbourhood search (see LNSPlacer) from the initial solution file, or from a constructive placement.
+ * Windows are re-optimized by solveWindow().
+ * 
+ */
+void MacroPlacer::runLNS() {
+    printf("runLNS() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+
+    PlacementProblem prob = problem();
+    prob.strictOrderY = (m_siteSizeX == 1 && m_relativeConstraintY);
+
+    Placement pl;
+    if (m_initSolFileName != "" && readStartPlacement(m_initSolFileName, prob, pl) && isPlacementLegal(prob, pl)) {
+        printf("LNS: start from %s\n", m_initSolFileName.c_str());
+    }
+    else if (LocalSearch::initialPlacement(prob, pl)) {
+        printf("LNS: start from a constructive placement.\n");
+        LocalSearch(prob).run(pl, -1);
+    }
+    else {
+        printf("WRN: LNS has no legal start placement.\n");
+        return;
+    }
+
+    LNSPlacer lns(prob, [this](const PlacementProblem &p, const Placement &cur, const SiteWindow &w, double timeLimit, Placement &result) {
+        return solveWindow(p, cur, w, timeLimit, result);
+    });
+    if (m_lnsWindowRows > 0) {
+        lns.setWindowSize(m_lnsWindowRows, (m_lnsWindowCols > 0) ? m_lnsWindowCols : std::min(m_siteSizeX, 4));
+    }
+    lns.setWindowTime(m_lnsWindowTime);
+    int numThreads = (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+    lns.setThreads(numThreads);
+    envPool().reserve(numThreads);
+    double wl = lns.run(pl, m_timeLimit);
+
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_lns";
+    printf("LNS wirelength: %.1f. Writing to %s.sol\n", wl, fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+}
+
+/**
+ * @brief Two-stage decomposition for several site columns (see ColumnPlacer): column assignment, then every column
+ * ordered by solveWindow() on a one-column window, for a few rounds. Starts from the initial solution file if any.
+ * 
+ */
+void MacroPlacer::runColumns() {
+    printf("runColumns() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+    if (m_siteSizeX == 1) {
+        printf("WRN: %s is only used for mapping into several columns! Function stops.\n", __func__);
+        return;
+    }
+
+    PlacementProblem prob = problem();
+    Placement pl;
+    if (m_initSolFileName != "" && readStartPlacement(m_initSolFileName, prob, pl) && isPlacementLegal(prob, pl)) {
+        printf("Columns: start from %s\n", m_initSolFileName.c_str());
+    }
+    else if (LocalSearch::initialPlacement(prob, pl)) {
+        LocalSearch(prob).run(pl, -1);
+    }
+    else {
+        printf("ERR: Columns: no initial placement.\n");
+        return;
+    }
+
+    ColumnPlacer columns(prob, [this](const PlacementProblem &p, const Placement &cur, const SiteWindow &w, double timeLimit, Placement &result) {
+        return solveWindow(p, cur, w, timeLimit, result);
+    });
+    columns.setIterations(m_colIterations);
+    columns.setColumnTime(m_colTime);
+    int numThreads = (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+    columns.setThreads(numThreads);
+    envPool().reserve(numThreads);
+    double wl = columns.run(pl, m_timeLimit);
+
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_columns";
+    printf("Columns wirelength: %.1f. Writing to %s.sol\n", wl, fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+}
+
+/**
+ * @brief Spectral ordering (see SpectralPlacer) for one column, refined by local search within the time limit.
+ * The initial solution file, if any, is kept when it is shorter.
+ * 
+ */
+void MacroPlacer::runSpectral() {
+    printf("runSpectral() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+    if (m_siteSizeX != 1) {
+        printf("WRN: %s is only used for mapping into one column! Function stops.\n", __func__);
+        return;
+    }
+
+    PlacementProblem prob = problem();
+    prob.strictOrderY = m_relativeConstraintY;
+    Placement pl;
+    if (!SpectralPlacer(prob).run(m_timeLimit, pl)) {
+        printf("ERR: Spectral: no legal placement.\n");
+        return;
+    }
+    double wl = placementWirelength(prob, pl);
+    Placement start;
+    if (m_initSolFileName != "" && readStartPlacement(m_initSolFileName, prob, start) && isPlacementLegal(prob, start)
+        && placementWirelength(prob, start) < wl) {
+        printf("Spectral: keeping the shorter start %s\n", m_initSolFileName.c_str());
+        pl = start;
+        wl = placementWirelength(prob, pl);
+    }
+
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_spectral";
+    printf("Spectral wirelength: %.1f. Writing to %s.sol\n", wl, fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+}
+
+/**
+ * @brief Analytical global placement (see AnalyticalPlacer) for several site columns, legalized and refined by local
+ * search within the time limit. The result can seed the MIP methods as their initSolFileName.
+ * The initial solution file, if any, is kept when it is shorter.
+ * 
+ */
+void MacroPlacer::runAnalytical() {
+    printf("runAnalytical() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+    if (m_siteSizeX == 1) {
+        printf("WRN: %s is only used for mapping into several columns (method 10 for one)! Function stops.\n", __func__);
+        return;
+    }
+
+    PlacementProblem prob = problem();
+    Placement pl;
+    if (!AnalyticalPlacer(prob).run(m_timeLimit, pl)) {
+        printf("ERR: Analytical: no legal placement.\n");
+        return;
+    }
+    double wl = placementWirelength(prob, pl);
+    Placement start;
+    if (m_initSolFileName != "" && readStartPlacement(m_initSolFileName, prob, start) && isPlacementLegal(prob, start)
+        && placementWirelength(prob, start) < wl) {
+        printf("Analytical: keeping the shorter start %s\n", m_initSolFileName.c_str());
+        pl = start;
+        wl = placementWirelength(prob, pl);
+    }
 
-                        // ROC for neighbors in the same column.
-                        if ((j0 == j1) && (i0 + 1 == i1)) {
-                            s = "ROC_" + s_index;
-                            model.addConstr(y[i0][j0] + 1 <= y[i1][j1], s);
-                        }
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_analytical";
+    printf("Analytical wirelength: %.1f. Writing to %s.sol\n", wl, fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+}
 
-                        // NOC is not needed for the cells in the same row or column (for both neighbors and non-neighbors).
-                        if ((i0 == i1) || (j0 == j1)) {
-                            enNOC = false;
-                        }
-                    }
+/**
+ * @brief Constraint-programming branch and bound (see CPPlacer) for one column, started from the initial solution file
+ * if any. A completed search writes a .cert file next to the solution with the certified optimum.
+ * 
+ */
+void MacroPlacer::runCP() {
+    printf("runCP() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
+    if (m_siteSizeX != 1) {
+        printf("WRN: %s is only used for mapping into one column! Function stops.\n", __func__);
+        return;
+    }
 
-                    // Add NOC if needed.
+    PlacementProblem prob = problem();
+    prob.strictOrderY = m_relativeConstraintY;
+    CPPlacer cp(prob);
+    cp.setThreads((m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency()));
+    Placement pl;
+    if (m_initSolFileName != "" && readStartPlacement(m_initSolFileName, prob, pl)) {
+        cp.setStart(pl);
+    }
 
-                    if (enNOC) {
-                        if (NOCMode == 0) {
-                            // dy = y0 - y1;
-                            dy[i0][j0][i1][j1] = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER, "dy" + s_index);
-                            model.addConstr(dy[i0][j0][i1][j1] == y[i0][j0] - y[i1][j1], "constr_dy" + s_index);
+    auto start = std::chrono::steady_clock::now();
+    if (!cp.run(m_cpExhaustive ? -1 : m_timeLimit, pl)) {
+        printf("WRN: CP found no placement%s.\n", cp.certified() ? " (infeasible)" : "");
+        return;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_cp";
+    double wl = placementWirelength(prob, pl);
+    printf("CP wirelength: %.1f%s. Writing to %s.sol\n", wl, cp.certified() ? " (optimal)" : "", fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+
+    if (cp.certified()) {
+        m_lastBound = std::max(m_lastBound, wl);
+        m_lastOptimal = true;
+        FILE *fp = fopen((fileName + ".cert").c_str(), "w");
+        if (fp == NULL) {
+            printf("ERR: Open file [%s.cert] failed!\n", fileName.c_str());
+            return;
+        }
+        fprintf(fp, "problem %d %d %d %d %d %d %d %d\n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX,
+            m_weightX, m_weightY, m_relativeConstraintX, m_relativeConstraintY);
+        fprintf(fp, "optimum %.10g\nnodes %lld\nseconds %.3f\n", wl, cp.numNodes(), elapsed.count());
+        fclose(fp);
+    }
+}
 
-                            // dyAbs = abs(dy);
-                            dyAbs[i0][j0][i1][j1] = model.addVar(0, GRB_INFINITY, 0, GRB_INTEGER, "absDy" + s_index);
-                            model.addGenConstrAbs(dyAbs[i0][j0][i1][j1], dy[i0][j0][i1][j1], "constr_absDy" + s_index);
+/**
+ * @brief Periodic tile replication (see TilePlacer): a small tile is solved exactly, by CPPlacer for one column and
+ * by solvePlacement() otherwise, and replicated over the array.
+ * 
+ */
+void MacroPlacer::runTile() {
+    printf("runTile() Problem size: mapping %d x %d => %d x %d \n", m_arraySizeY, m_arraySizeX, m_siteSizeY, m_siteSizeX);
+    dbg_printProblemInfo();
 
-                            // dyAbs >= 1;
-                            model.addConstr(dyAbs[i0][j0][i1][j1] >= 1, "no_overlap" + s_index);
-                        }
-                        else if (NOCMode == 1) {
-                            // b0 == true if y0 - y1 >= 1; 
-                            bList[i0][j0][i1][j1][0] = model.addVar(0, 1, 0, GRB_BINARY, s); 
-                            model.addGenConstrIndicator(bList[i0][j0][i1][j1][0], true, y[i0][j0] - y[i1][j1] >= 1);
-                            
-                            // b1 == 1 if y1 - y0 >= 1; 
-                            bList[i0][j0][i1][j1][1] = model.addVar(0, 1, 0, GRB_BINARY, s); 
-                            model.addGenConstrIndicator(bList[i0][j0][i1][j1][1], true, y[i1][j1] - y[i0][j0] >= 1);
-
-                            // b == b0 OR b1;
-                            model.addGenConstrOr(b[i0][j0][i1][j1], bList[i0][j0][i1][j1], 2);
-
-                            // b == True;
-                            model.addConstr(b[i0][j0][i1][j1] == true);
-                        }
-                        else {
-                            printf("ERR: Unexpected NOCMode: %d.\n", NOCMode);
-                            // assert(false);
-                        }
-                    }
+    PlacementProblem prob = problem();
+    prob.strictOrderY = (m_siteSizeX == 1 && m_relativeConstraintY);
+    const int threads = (m_threads > 0) ? m_threads : std::max(1u, std::thread::hardware_concurrency());
 
-                }
-            }
+    TilePlacer tiler(prob, [this, threads](const PlacementProblem &p, double timeLimit, const Placement *start, Placement &result) {
+        if (p.siteSizeX != 1) {
+            return solvePlacement(p, timeLimit, start, result);
         }
-    } 
+        CPPlacer cp(p);
+        cp.setThreads(threads);
+        if (start) {
+            cp.setStart(*start);
+        }
+        return cp.run(timeLimit, result);
+    });
+    tiler.setTileSize(m_tileRows, m_tileCols);
 
-    // DBG("Setting Objective..\n");
-    GRBLinExpr objTotalWl = 0;
+    Placement pl;
+    if (!tiler.run(m_timeLimit, pl)) {
+        printf("WRN: Tiling found no legal placement.\n");
+        return;
+    }
 
-    // When relative constraints are satisfied, total WL only depends on the coordinates of the cells on the boundaries of the PE array.
+    std::string fileName = solFileBaseName() + "_time_" + std::to_string(m_timeLimit) + "_tile";
+    printf("Tiling wirelength: %.1f. Writing to %s.sol\n", placementWirelength(prob, pl), fileName.c_str());
+    writePlacementToSol(fileName + ".sol", prob, pl);
+    m_lastSolFileName = fileName + ".sol";
+}
 
-    // Top and bottom boundaries.
-    for (j = 0; j < m_arraySizeX; j++) {
-        
-        if (enTop) {
-            i = m_arraySizeY - 1;
-            objTotalWl += y[i][j];
+/**
+ * @brief Re-optimize the cells on the sites of <win> with all other cells of <pl> fixed.
+ * The sub-MIP follows run2() (run3() ROC when prob.strictOrderY is set), restricted to the window:
+ * free cells range over the window's sites, which no fixed cell occupies, and every array edge with
+ * a free end contributes its weighted length; edges to fixed cells use their constant positions.
+ * 
+ * @param prob 
+ * @param pl 
+ * @param win 
+ * @param timeLimit 
+ * @param result <pl> with the window's cells re-placed.
+ * @return true if the sub-MIP found a solution.
+ */
+bool MacroPlacer::solveWindow(const PlacementProblem &prob, const Placement &pl, const SiteWindow &win, double timeLimit, Placement &result) {
+    std::vector<int> freeCells;
+    for (int c = 0; c < prob.numCells(); c++) {
+        if (win.contains(pl.y(c), pl.x(c))) {
+            freeCells.push_back(c);
         }
+    }
+    if (freeCells.size() < 2) {
+        return false;
+    }
 
-        if (enBot) {
-            i = 0;
-            objTotalWl -= y[i][j];
+    try {
+        EnvPool::Lease lease = envPool().lease("", false);
+        GRBModel model = GRBModel(lease.env());
+        model.set(GRB_IntParam_Threads, 1);
+        if (timeLimit > 0) {
+            model.set(GRB_DoubleParam_TimeLimit, timeLimit);
         }
-    }
 
-    // Left and right boundaries.
-    for (i = 0; i < m_arraySizeY; i++) {
+        const int n = freeCells.size();
+        std::vector<GRBVar> x, y;
+        buildWindowModel(model, prob, pl, win, freeCells, x, y);
 
-        if (enRight) {
-            j = m_arraySizeX - 1;
-            objTotalWl += y[i][j];
+        for (int k = 0; k < n; k++) {
+            x[k].set(GRB_DoubleAttr_Start, pl.x(freeCells[k]));
+            y[k].set(GRB_DoubleAttr_Start, pl.y(freeCells[k]));
         }
 
-        if (enLeft) {
-            j = 0;
-            objTotalWl -= y[i][j];
+        model.optimize();
+        if (model.get(GRB_IntAttr_SolCount) == 0) {
+            return false;
         }
-
+        result = pl;
+        for (int k = 0; k < n; k++) {
+            result.x(freeCells[k]) = (int)std::lround(x[k].get(GRB_DoubleAttr_X));
+            result.y(freeCells[k]) = (int)std::lround(y[k].get(GRB_DoubleAttr_X));
+        }
+        return true;
+    } catch (GRBException e) {
+        printf("%s: %s\n", __func__, e.getMessage().c_str());
     }
+    return false;
+}
 
-    // Minus the cost if the corner cell counted twice.
-    if (enRight && enTop) {
-        objTotalWl -= y[m_arraySizeY-1][m_arraySizeX-1];
+/**
+ * @brief Build the window sub-MIP of solveWindow() with the run2() generation (addPairConstrs(), addRelativeConstrs()).
+ * x[k]/y[k] are the coordinates of freeCells[k], the cells on the sites of <win> in cell id order.
+ * 
+ * @param model 
+ * @param prob 
+ * @param pl 
+ * @param win 
+ * @param freeCells 
+ * @param x 
+ * @param y 
+ */
+void MacroPlacer::buildWindowModel(GRBModel &model, const PlacementProblem &prob, const Placement &pl, const SiteWindow &win,
+                                   const std::vector<int> &freeCells, std::vector<GRBVar> &x, std::vector<GRBVar> &y) {
+    const int n = freeCells.size();
+    x.resize(n);
+    y.resize(n);
+    for (int k = 0; k < n; k++) {
+        x[k] = model.addVar(win.x0, win.x1 - 1, 0, GRB_INTEGER);
+        y[k] = model.addVar(win.y0, win.y1 - 1, 0, GRB_INTEGER);
     }
-
-    // Minus the cost if the corner cell counted twice.
-    if (enLeft && enBot) {
-        objTotalWl -= y[0][0];
+    std::vector<GRBVar> px, py;
+    addPhysicalCoords(model, x, false, px);
+    addPhysicalCoords(model, y, true, py);
+    addBlockedSiteConstrs(model, x, y, &win);
+
+    // The run2() pair and ROC generation over all cells of <prob>: free cells by their variables, fixed neighbors of
+    // free cells as constants at their current sites; other fixed cells are never referenced.
+    const int numCells = prob.numCells();
+    const SiteGeometry *geom = prob.geometry.get();
+    std::vector<char> isFree(numCells, 0);
+    std::vector<GRBVar> baseVars(4 * numCells);
+    for (int k = 0; k < n; k++) {
+        const int c = freeCells[k];
+        isFree[c] = 1;
+        baseVars[c] = x[k];
+        baseVars[numCells + c] = y[k];
+        baseVars[2 * numCells + c] = px[k];
+        baseVars[3 * numCells + c] = py[k];
     }
-
-    // printf("Setting Objective..\n");
-    try {
-        model.setObjective(objTotalWl, GRB_MINIMIZE);
-        // printf("Setting Objective..\n");
-        // assert(0);
-    } catch (GRBException e) {
-        printf("setObjective: %s\n", e.getMessage().c_str());
+    std::vector<char> isConst(numCells, 0);
+    for (int c: freeCells) {
+        const int i = c / prob.arraySizeX, j = c % prob.arraySizeX;
+        const int nbrs[4] = {(i > 0) ? c - prob.arraySizeX : -1, (i + 1 < prob.arraySizeY) ? c + prob.arraySizeX : -1,
+                             (j > 0) ? c - 1 : -1, (j + 1 < prob.arraySizeX) ? c + 1 : -1};
+        for (int c1: nbrs) {
+            if (c1 < 0 || isFree[c1] || isConst[c1]) {
+                continue;
+            }
+            isConst[c1] = 1;
+            baseVars[c1] = model.addVar(pl.x(c1), pl.x(c1), 0, GRB_INTEGER);
+            baseVars[numCells + c1] = model.addVar(pl.y(c1), pl.y(c1), 0, GRB_INTEGER);
+            if (geom) {
+                double cx = geom->coordX(pl.x(c1)), cy = geom->coordY(pl.y(c1));
+                baseVars[2 * numCells + c1] = model.addVar(cx, cx, 0, GRB_CONTINUOUS);
+                baseVars[3 * numCells + c1] = model.addVar(cy, cy, 0, GRB_CONTINUOUS);
+            }
+            else {
+                baseVars[2 * numCells + c1] = baseVars[c1];
+                baseVars[3 * numCells + c1] = baseVars[numCells + c1];
+            }
+        }
     }
-    // printf("Solve model..\n");
 
-    model.optimize();
+    ModelBuilder builder(model, baseVars, 1);
+    addPairConstrs(builder, prob, isFree, m_NOCMode);
+    addRelativeConstrs(model, prob, std::vector<GRBVar>(baseVars.begin(), baseVars.begin() + numCells),
+                       std::vector<GRBVar>(baseVars.begin() + numCells, baseVars.begin() + 2 * numCells), isFree);
 
-    // DBG("Optimize() done.\n");
-    // DVD();
-
-    // DBG("Writing model..\n");
-    std::string fileName = "output/macroPl_" + std::to_string(m_arraySizeY) + "_" + std::to_string(m_arraySizeX) 
-                            + "_to_" + std::to_string(m_siteSizeY) + "_" + std::to_string(m_siteSizeX); 
-        
-    // Relative position constraints in X/Y direction.
-    fileName += "_rpXY_" + std::to_string(m_relativeConstraintX) + "_" + std::to_string(m_relativeConstraintY);
+    model.setObjective(builder.objective(), GRB_MINIMIZE);
+}
 
-    // Weights in X/Y direction.
-    fileName += "_wtXY_" + std::to_string(m_weightX) + "_" + std::to_string(m_weightY);
+/**
+ * @brief Solve a (sub-)problem with the Gurobi formulations and the current solver settings:
+ * run3() when prob.strictOrderY is set, run2() otherwise. Used by the engines built on top of the exact solver.
+ * 
+ * @param prob 
+ * @param timeLimit seconds; <= 0 for no limit.
+ * @param start optional start placement.
+ * @param result 
+ * @param quiet suppress the solver log.
+ * @return true if a placement was found.
+ */
+bool MacroPlacer::solvePlacement(const PlacementProblem &prob, double timeLimit, const Placement *start, Placement &result, bool quiet) {
+    MacroPlacer sub;
+    sub.setProblemSize(prob.arraySizeY, prob.arraySizeX, prob.siteSizeY, prob.siteSizeX);
+    sub.setXYWeight((int)prob.weightX, (int)prob.weightY);
+    sub.setRelativeConstraintXY(prob.relativeConstraintX, prob.relativeConstraintY);
+    sub.m_siteGeometry = prob.geometry;
 
     try {
-        model.write(fileName + ".sol");
-        // DBG("Solution written to %s\n", fileName.c_str());
+        EnvPool::Lease lease = envPool().lease("", !quiet);
+        GRBModel model = GRBModel(lease.env());
+
+        std::vector<GRBVar> x, y;
+        if (prob.strictOrderY) {
+            sub.buildModel3(model, y, m_NOCMode);
+        }
+        else {
+            sub.buildModel2(model, x, y, m_NOCMode);
+        }
+        if (timeLimit > 0) {
+            model.set(GRB_DoubleParam_TimeLimit, timeLimit);
+        }
+        if (m_threads > 0) {
+            model.set(GRB_IntParam_Threads, m_threads);
+        }
+        if (start) {
+            sub.setStart(*start, x, y);
+        }
+
+        PlacerCallback cb(prob, x, y);
+        if (m_heurCallback) {
+            cb.enableLocalSearch(m_heurTime, m_heurInterval);
+            model.setCallback(&cb);
+        }
+
+        model.optimize();
+        return sub.getPlacement(model, x, y, result);
     } catch (GRBException e) {
-        // DBG("%s\n", e.getMessage().c_str());
+        printf("%s: %s\n", __func__, e.getMessage().c_str());
     }
-    // model.write(fileName + "pl");
-    // model.write(fileName + "sol");
-    // model.write(fileName + "json");
+    return false;
+}
+
+/**
+ * @brief Read the best solution of a solved model into <pl>. x is empty for the one-column formulations.
+ * 
+ * @param model 
+ * @param x 
+ * @param y 
+ * @param pl 
+ * @return true if the model has a solution.
+ */
+bool MacroPlacer::getPlacement(GRBModel &model, std::vector<GRBVar> &x, std::vector<GRBVar> &y, Placement &pl) {
+    if (model.get(GRB_IntAttr_SolCount) == 0) {
+        return false;
+    }
+    pl.resize(problem());
+    for (int c = 0; c < pl.numCells(); c++) {
+        if (!x.empty()) {
+            pl.x(c) = (int)std::lround(x[c].get(GRB_DoubleAttr_X));
+        }
+        pl.y(c) = (int)std::lround(y[c].get(GRB_DoubleAttr_X));
+    }
+    return true;
 }
 
 /**
@@ -1001,15 +2424,7 @@ void MacroPlacer::runBatchFromFile(const std::string batchFileName) {
         if (strncmp(tokens[0].c_str(), "#", 1) == 0) {
             continue;
         }
-        else if (tokens.size() == 11) {
-            m_jobList.emplace_back(tokens[0],stoi(tokens[1]),stoi(tokens[2]),stoi(tokens[3]),stoi(tokens[4]),stod(tokens[5]),stod(tokens[6]),stoi(tokens[7]),stoi(tokens[8]), stod(tokens[9]), stoi(tokens[10]));
-        }
-        else if (tokens.size() == 12) {
-            // add one more field for initial solution file.
-            m_jobList.emplace_back(tokens[0],stoi(tokens[1]),stoi(tokens[2]),stoi(tokens[3]),stoi(tokens[4]),stod(tokens[5]),stod(tokens[6]),stoi(tokens[7]),stoi(tokens[8]), stod(tokens[9]), stoi(tokens[10]), tokens[11]);
-            printf("Parsed Initial solution file for job[%s]: %s\n", tokens[0].c_str(), tokens[11].c_str());
-        }
-        else {
+        else if (!parseJobTokens(tokens, m_jobList)) {
             printf("ERR: Unexpected input length: %d\n", tokens.size());
         }
     }
@@ -1026,57 +2441,388 @@ void MacroPlacer::runBatchFromFile(const std::string batchFileName) {
     printf("--------------------------------\n");
 }
 
+/**
+ * @brief Parse a "key=value" field of a job line into <job>.
+ * 
+ * Keys:
+ * NOCMode=<0|1>: no-overlap constraint formulation (0: abs; 1: indicator plus OR).
+ * threads=<n>: total solver threads of the job (0: all hardware threads).
+ * portfolioSize=<n>: number of concurrent solvers for method 3.
+ * heurCallback=<0|1>: refine incumbents and node relaxations with native local search in a callback.
+ * heurTime=<sec>: local search time per callback call.
+ * heurInterval=<sec>: minimum time between two node relaxation roundings.
+ * pipelineFraction=<f>: share of the time limit given to the ROC-restricted stage of method 4.
+ * mlCoarsestCells=<n>: coarsening of method 5 stops at this many super-cells.
+ * lnsWindowRows=<n>, lnsWindowCols=<n>: site window size of method 6.
+ * lnsWindowTime=<sec>: time limit of one window sub-MIP of method 6.
+ * envPoolSize=<n>: Gurobi environments kept for all jobs; read from the first job that solves.
+ * priority=<n>: queue priority in server mode, higher first.
+ * siteFile=<file>: site coordinates and blocked sites, see readSiteGeometry().
+ * memBudget=<MB>: memory the planned model may take, else the job is down-selected (0: physical memory).
+ * cpExhaustive=<0|1>: method 7 searches to completion regardless of the time limit.
+ * tileRows=<n>, tileCols=<n>: tile of method 8 (0: chosen automatically).
+ * colIterations=<n>: assignment / ordering rounds of method 9.
+ * colTime=<sec>: time limit of one column sub-MIP of method 9.
+ * embedMode=<0|1>: an initial solution of another shape gets the added / removed rows and columns spread over the array (0) or at its end (1).
+ * cacheDir=<dir>: best-known registry of the job (see ResultCache); empty to run without it.
+ * phases=<kind[:stallSec],...>: staged solve of methods 1 and 2, e.g. norel:600,bound:1800,bb (see SolvePhase).
+ * phaseTol=<f>: relative improvement of the incumbent or bound that resets a phase's stall timer.
+ * userCuts=<0|1>: add wirelength-bound and spread cuts (see CutSeparator) to the models of methods 1 and 2.
+ * weightX=<w>, weightY=<w>: wirelength weights of the site axes, replacing the job's weight fields.
+ * 
+ * @param job 
+ * @param token 
+ * @return true if the key is known.
+ */
+bool MacroPlacer::parseJobOption(JOB &job, const std::string &token) {
+    size_t pos = token.find('=');
+    const std::string key = token.substr(0, pos);
+    const std::string value = token.substr(pos + 1);
+
+    if (key == "NOCMode") {
+        job.NOCMode = stoi(value);
+    }
+    else if (key == "threads") {
+        job.threads = stoi(value);
+    }
+    else if (key == "portfolioSize") {
+        job.portfolioSize = stoi(value);
+    }
+    else if (key == "heurCallback") {
+        job.heurCallback = stoi(value);
+    }
+    else if (key == "heurTime") {
+        job.heurTime = stod(value);
+    }
+    else if (key == "heurInterval") {
+        job.heurInterval = stod(value);
+    }
+    else if (key == "pipelineFraction") {
+        job.pipelineFraction = stod(value);
+    }
+    else if (key == "mlCoarsestCells") {
+        job.mlCoarsestCells = stoi(value);
+    }
+    else if (key == "lnsWindowRows") {
+        job.lnsWindowRows = stoi(value);
+    }
+    else if (key == "lnsWindowCols") {
+        job.lnsWindowCols = stoi(value);
+    }
+    else if (key == "lnsWindowTime") {
+        job.lnsWindowTime = stod(value);
+    }
+    else if (key == "envPoolSize") {
+        job.envPoolSize = stoi(value);
+    }
+    else if (key == "priority") {
+        job.priority = stoi(value);
+    }
+    else if (key == "siteFile") {
+        job.siteFileName = value;
+    }
+    else if (key == "memBudget") {
+        job.memBudget = stod(value);
+    }
+    else if (key == "cpExhaustive") {
+        job.cpExhaustive = stoi(value);
+    }
+    else if (key == "tileRows") {
+        job.tileRows = stoi(value);
+    }
+    else if (key == "tileCols") {
+        job.tileCols = stoi(value);
+    }
+    else if (key == "colIterations") {
+        job.colIterations = stoi(value);
+    }
+    else if (key == "colTime") {
+        job.colTime = stod(value);
+    }
+    else if (key == "embedMode") {
+        job.embedMode = stoi(value);
+    }
+    else if (key == "cacheDir") {
+        job.cacheDir = value;
+    }
+    else if (key == "phases") {
+        parseSolvePhases(value, job.solvePhases);
+    }
+    else if (key == "phaseTol") {
+        job.phaseTol = stod(value);
+    }
+    else if (key == "userCuts") {
+        job.userCuts = stoi(value);
+    }
+    else if (key == "weightX") {
+        job.weightX = stoi(value);
+    }
+    else if (key == "weightY") {
+        job.weightY = stoi(value);
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse one batch line (see README) into a JOB appended to <jobs>.
+ * 
+ * @param tokens 
+ * @param jobs 
+ * @return true if the line has the 11 fixed fields.
+ */
+bool MacroPlacer::parseJobTokens(const std::vector<std::string> &tokens, std::vector<JOB> &jobs) {
+    if (tokens.size() < 11) {
+        return false;
+    }
+    jobs.emplace_back(tokens[0],stoi(tokens[1]),stoi(tokens[2]),stoi(tokens[3]),stoi(tokens[4]),stod(tokens[5]),stod(tokens[6]),stoi(tokens[7]),stoi(tokens[8]), stod(tokens[9]), stoi(tokens[10]));
+    JOB &job = jobs.back();
+
+    // Optional fields: the initial solution file and "key=value" job options.
+    for (size_t k = 11; k < tokens.size(); k++) {
+        if (tokens[k].find('=') != std::string::npos) {
+            if (!parseJobOption(job, tokens[k])) {
+                printf("ERR: Unknown option <%s> for job[%s]\n", tokens[k].c_str(), tokens[0].c_str());
+            }
+        }
+        else {
+            job.initSolFileName = tokens[k];
+            printf("Parsed Initial solution file for job[%s]: %s\n", tokens[0].c_str(), tokens[k].c_str());
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Add a job for the design <netlistFileName>: the PE array is the cell array, the PE layout the site array,
+ * the weights are the usual 15 (x) and 1 (y) unless weightX= / weightY= options are given, and both relative
+ * ordering constraints are on. The job is named after the file.
+ * The average connections between adjacent DSPs are only reported: the models charge the weights per site
+ * distance between every pair of array neighbors, which is not a per-connection flow.
+ * 
+ * @param netlistFileName 
+ * @param fields the rest of a batch line: timeLimit method [initSolFileName] [key=value ...].
+ * @return true if the job was added.
+ */
+bool MacroPlacer::addDesignJob(const std::string &netlistFileName, const std::vector<std::string> &fields) {
+    if (fields.size() < 2) {
+        printf("ERR: A design job needs a time limit and a method.\n");
+        return false;
+    }
+    if (!setNetlistFile(netlistFileName)) {
+        return false;
+    }
+    std::string name = netlistFileName.substr(netlistFileName.find_last_of('/') + 1);
+    name = name.substr(0, name.find('.'));
+    printf("Design %s: %.2f connections per horizontal and %.2f per vertical DSP neighbor pair on average (not weighted in the objective).\n",
+        name.c_str(), m_nl->averageFlow(false), m_nl->averageFlow(true));
+
+    std::vector<std::string> tokens = {name, std::to_string(m_nl->rowsOfPeArray()), std::to_string(m_nl->colsOfPeArray()),
+        std::to_string(m_nl->rowsOfPeLayout()), std::to_string(m_nl->colsOfPeLayout()), "15", "1", "1", "1"};
+    tokens.insert(tokens.end(), fields.begin(), fields.end());
+    for (const std::string &t: tokens) {
+        printf("%s ", t.c_str());
+    }
+    printf("\n");
+    if (m_nl->numDsps() != m_nl->rowsOfPeArray() * m_nl->colsOfPeArray()) {
+        printf("WRN: Netlist <%s> has %d DSPs for a %d x %d array.\n", netlistFileName.c_str(), m_nl->numDsps(), m_nl->rowsOfPeArray(), m_nl->colsOfPeArray());
+    }
+    if (m_nl->numNeighborConnections() < m_nl->numConnections()) {
+        printf("WRN: %lld of %lld DSP connections are not between array neighbors and not in the placement objective.\n",
+            m_nl->numConnections() - m_nl->numNeighborConnections(), m_nl->numConnections());
+    }
+    return parseJobTokens(tokens, m_jobList);
+}
+
+/**
+ * @brief The problem a job solves, to read and check its solution outside the placer.
+ * 
+ * @param job 
+ * @return PlacementProblem 
+ */
+PlacementProblem MacroPlacer::jobProblem(const JOB &job) {
+    PlacementProblem prob;
+    prob.arraySizeY = job.arraySizeY;
+    prob.arraySizeX = job.arraySizeX;
+    prob.siteSizeY = job.siteSizeY;
+    prob.siteSizeX = job.siteSizeX;
+    prob.weightX = job.weightX;
+    prob.weightY = job.weightY;
+    prob.relativeConstraintX = job.relativeConstraintX;
+    prob.relativeConstraintY = job.relativeConstraintY;
+    prob.strictOrderY = (job.siteSizeX == 1 && job.relativeConstraintY);
+    if (job.siteFileName != "") {
+        readSiteGeometry(job.siteFileName, job.siteSizeY, job.siteSizeX, prob.geometry);
+    }
+    return prob;
+}
+
 void MacroPlacer::runJobs() {
     for (const JOB &job: m_jobList) {
-        setProblemSize(job.arraySizeY, job.arraySizeX, job.siteSizeY, job.siteSizeX);
-        setXYWeight(job.weightX, job.weightY);
-        setRelativeConstraintXY(job.relativeConstraintX, job.relativeConstraintY);
-        setTimeLimit(job.timeLimit);
-        setInitSolFileName(job.initSolFileName);
+        runJob(job);
+    }
+}
 
+/**
+ * @brief Apply the settings of <job> and run its method. The written solution, if any, is lastSolFileName() afterwards.
+ * 
+ * @param job 
+ */
+void MacroPlacer::runJob(const JOB &job) {
+    m_lastSolFileName = "";
+    setProblemSize(job.arraySizeY, job.arraySizeX, job.siteSizeY, job.siteSizeX);
+    if (!setSiteFile(job.siteFileName)) {
+        printf("ERR: Skip job[%s]: site file <%s> not usable.\n", job.name.c_str(), job.siteFileName.c_str());
+        return;
+    }
+    setXYWeight(job.weightX, job.weightY);
+    setRelativeConstraintXY(job.relativeConstraintX, job.relativeConstraintY);
+    setTimeLimit(job.timeLimit);
+    setInitSolFileName(job.initSolFileName);
+    setNOCMode(job.NOCMode);
+    setThreads(job.threads);
+    setPortfolioSize(job.portfolioSize);
+    setHeuristicCallback(job.heurCallback, job.heurTime, job.heurInterval);
+    setPipelineFraction(job.pipelineFraction);
+    setMultilevelCoarsestCells(job.mlCoarsestCells);
+    setLNSWindow(job.lnsWindowRows, job.lnsWindowCols, job.lnsWindowTime);
+    setCPExhaustive(job.cpExhaustive);
+    setTileSize(job.tileRows, job.tileCols);
+    setEmbedMode(job.embedMode);
+    setColumnDecomposition(job.colIterations, job.colTime);
+    setSolvePhases(job.solvePhases, job.phaseTol);
+    setUserCuts(job.userCuts);
+    if (job.envPoolSize > 0) {
+        setEnvPoolSize(job.envPoolSize);
+    }
+    setMemoryBudget(job.memBudget);
+
+    printf("--------------------------------\n");
+    printf("Run Job [%s]..\n", job.name.c_str());
+
+    const int method = planJob(job.method);
+    if (method < 0) {
+        printf("ERR: Skip job[%s]: no method fits the memory budget.\n", job.name.c_str());
         printf("--------------------------------\n");
-        printf("Run Job [%s]..\n", job.name.c_str());
+        return;
+    }
 
-        if (job.method == 0) {
-            // Heuristic method.
-            run();
+    // Best-known registry: a proven optimum ends the job, another registered placement is its start.
+    // run4() minimizes side costs, not the wirelength, and stays out of it.
+    std::unique_ptr<ResultCache> cache;
+    PlacementProblem prob = problem();
+    prob.strictOrderY = (job.siteSizeX == 1 && job.relativeConstraintY);
+    if (job.cacheDir != "" && !(method == 1 && job.siteSizeX == 1 && job.name == "job4")) {
+        cache.reset(new ResultCache(job.cacheDir));
+        ResultCache::Entry entry;
+        Placement cached;
+        if (cache->lookup(prob, entry, cached)) {
+            printf("Cache: best known wirelength %.1f, bound %.1f%s (job[%s], method %d)\n", entry.wl, entry.bound,
+                entry.optimal ? ", proven optimal" : "", entry.job.c_str(), entry.method);
+            if (entry.optimal) {
+                printf("Skip job[%s]: cached optimum %s\n", job.name.c_str(), cache->solFileName(prob).c_str());
+                m_lastSolFileName = cache->solFileName(prob);
+                printf("--------------------------------\n");
+                return;
+            }
+            if (job.initSolFileName == "") {
+                setInitSolFileName(cache->solFileName(prob));
+            }
         }
-        else if (job.method == 1) {
-            // Gurobi.
-            if (job.siteSizeX == 1) {
-                if (job.name == "job4") {
-                    run4();
-                }
-                else {
-                    run3();
-                }
+    }
+    m_lastBound = 0;
+    m_lastOptimal = false;
+
+    if (method == 0) {
+        // Heuristic method.
+        run();
+    }
+    else if (method == 1) {
+        // Gurobi.
+        if (job.siteSizeX == 1) {
+            if (job.name == "job4") {
+                run4();
             }
             else {
-                run2();
+                run3();
             }
         }
-        // This is for when relative constraints is removed.
-        else if (job.method == 2) {
+        else {
             run2();
         }
+    }
+    // This is for when relative constraints is removed.
+    else if (method == 2) {
+        run2();
+    }
+    // Concurrent portfolio of formulations.
+    else if (method == 3) {
+        runPortfolio();
+    }
+    // ROC-restricted solve first, then the job's model warm-started from it.
+    else if (method == 4) {
+        runPipeline();
+    }
+    // Multilevel coarsen-solve-refine.
+    else if (method == 5) {
+        runMultilevel();
+    }
+    // Large-neighbourhood search with window sub-MIPs.
+    else if (method == 6) {
+        runLNS();
+    }
+    // Constraint-programming branch and bound.
+    else if (method == 7) {
+        runCP();
+    }
+    // Periodic tile replication.
+    else if (method == 8) {
+        runTile();
+    }
+    // Column assignment plus per-column ordering.
+    else if (method == 9) {
+        runColumns();
+    }
+    // Spectral ordering for one column.
+    else if (method == 10) {
+        runSpectral();
+    }
+    // Analytical global placement for several columns.
+    else if (method == 11) {
+        runAnalytical();
+    }
 
+    if (cache) {
+        // Every method gets the combinatorial bound of CutSeparator; the MIP methods may have noted a better one.
+        m_lastBound = std::max(m_lastBound, CutSeparator(prob).wirelengthBound());
+        Placement pl;
+        const bool solved = m_lastSolFileName != "" && readPlacementFromSol(m_lastSolFileName, prob, pl) && isPlacementLegal(prob, pl);
+        ResultCache::Entry entry;
+        if (cache->update(prob, solved ? &pl : NULL, m_lastBound, m_lastOptimal, job.name, method, entry)) {
+            printf("Cache: updated, best known wirelength %.1f, bound %.1f%s\n", entry.wl, entry.bound, entry.optimal ? ", proven optimal" : "");
+        }
+    }
 
 
-        printf("--------------------------------\n");
 
-    }
+    printf("--------------------------------\n");
 }
 
 
 /**
- * @brief cost of flow (connection) between cell[i] and cell[j] 
+ * @brief cost of flow (connection) between cell[i] and cell[j], from the netlist; 0 without one.
  * 
  * @param i 
  * @param j 
  * @return int 
  */
 int MacroPlacer::flow(int i, int j) {
-    return 0;
+    if (!m_nl || m_nl->rowsOfPeArray() != m_arraySizeY || m_nl->colsOfPeArray() != m_arraySizeX) {
+        return 0;
+    }
+    return m_nl->flow(i, j);
 }
 
 /**
@@ -1138,8 +2884,11 @@ void MacroPlacer::placeAndFixDSP() {
  */
 void MacroPlacer::setProblemSizeFromNetlist() {
     // DBG("%s...\n", __func__);
-    // Assert()
-    // setProblemSize(m_nl.m_rowsOfPeArray, m_nl.m_colsOfPeArray, m_nl.m_rowsOfPeLayout, m_nl.m_colsOfPeLayout);
+    if (!m_nl) {
+        printf("ERR: No netlist read.\n");
+        return;
+    }
+    setProblemSize(m_nl->rowsOfPeArray(), m_nl->colsOfPeArray(), m_nl->rowsOfPeLayout(), m_nl->colsOfPeLayout());
 }
 
 
@@ -1149,21 +2898,12 @@ void MacroPlacer::setProblemSizeFromNetlist() {
  */
 void MacroPlacer::fillDspIdArray() {
     // DBG("%s...\n", __func__);
-
-    // m_dspIdArray.resize(m_arraySizeX, m_arraySizeY, INDEX_TYPE_MAX);
-
-    // for (Node &nd: m_nl.nodeArray()) {
-    //     if (isDSP(nd.nodeType())) {
-    //         IndexType rowIdx = nd.rowIdxNl();
-    //         IndexType colIdx = nd.colIdxNl();
-
-    //         #ifdef DEBUG
-    //         Assert(m_dspIdArray.at(colIdx, rowIdx) == INDEX_TYPE_MAX);
-    //         #endif
-
-    //         m_dspIdArray.at(colIdx, rowIdx) = nd.id();
-    //     }
-    // }
+    m_dspIdArray.assign(m_arraySizeY * m_arraySizeX, -1);
+    if (!m_nl || m_nl->rowsOfPeArray() != m_arraySizeY || m_nl->colsOfPeArray() != m_arraySizeX) {
+        printf("ERR: No netlist of the %d x %d array read.\n", m_arraySizeY, m_arraySizeX);
+        return;
+    }
+    m_dspIdArray = m_nl->dspIdArray();
 }
 
 /**
@@ -1219,27 +2959,32 @@ void MacroPlacer::placeDspInterleaved() {
  */
 void MacroPlacer::dbg_printDSPInNetlist() {
     // DBG("%s...\n", __func__);
-    // for (Node &nd: m_nl.nodeArray()) {
-    //     if (isDSP(nd.nodeType())) {
-    //         DBG("node<%s>: col: %d, row: %d.\n", nd.name().c_str(), nd.colIdxNl(), nd.rowIdxNl());
-    //     }
-    // }
+    if (!m_nl) {
+        return;
+    }
+    for (int i = 0; i < m_nl->rowsOfPeArray(); i++) {
+        for (int j = 0; j < m_nl->colsOfPeArray(); j++) {
+            int id = m_nl->dspId(i, j);
+            if (id >= 0) {
+                printf("node<%s>: col: %d, row: %d.\n", m_nl->dspName(id).c_str(), j, i);
+            }
+        }
+    }
 }
 
 void MacroPlacer::dbg_printDspIdArray() {
     // DBG("%s...\n", __func__);
-    // for (int x = 0; x < m_dspIdArray.xSize(); x++) {
-    //     for (int y = 0; y < m_dspIdArray.ySize(); y++) {
-    //         IndexType id = m_dspIdArray.at(x, y);
-    //         if (id == INDEX_TYPE_MAX) {
-    //             WRN("m_dspIdArray[%2d][%2d]: id == %d!. \n", x, y, id);
-    //         }
-    //         else {
-    //             const Node &nd = m_nl.node(id);
-    //             DBG("m_dspIdArray[%2d][%2d]: <%s>. \n", x, y, nd.name().c_str());
-    //         }
-    //     }
-    // }
+    for (int i = 0; i < m_arraySizeY; i++) {
+        for (int j = 0; j < m_arraySizeX && cellId(i, j) < (int)m_dspIdArray.size(); j++) {
+            int id = m_dspIdArray[cellId(i, j)];
+            if (id < 0) {
+                printf("WRN: m_dspIdArray[%2d][%2d]: id == %d!. \n", i, j, id);
+            }
+            else {
+                printf("m_dspIdArray[%2d][%2d]: <%s>. \n", i, j, m_nl->dspName(id).c_str());
+            }
+        }
+    }
 }
 
 
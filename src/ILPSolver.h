@@ -2,7 +2,21 @@
 #define __ILPSOLVER_H__
 
 #include "gurobi_c++.h"
+#include "Placement.h"
+#include "Netlist.h"
+#include "SolvePhase.h"
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+class IncumbentPool;
+class PlacerCallback;
+class EnvPool;
+class RocPresolve;
+class ModelBuilder;
+struct ModelSize;
+struct SiteWindow;
 
 
 class ILPSolver
@@ -43,9 +57,36 @@ public:
         double          timeLimit = -1;
 
 
-        int             method = -1; // -1: invalid; 0: Heuristic method; 1: Gurobi; 2: Gurobi w/o relativeConst;
+        int             method = -1; // -1: invalid; 0: Heuristic method; 1: Gurobi; 2: Gurobi w/o relativeConst; 3: Gurobi portfolio; 4: ROC-then-unconstrained pipeline; 5: multilevel; 6: LNS; 7: CP branch and bound (one column); 8: periodic tile replication; 9: column assignment plus column ordering; 10: spectral ordering (one column); 11: analytical placement (several columns);
         std::string         initSolFileName = "";
 
+        // Optional "key=value" fields of the job line.
+        int             NOCMode = 0; // 0: abs; 1: indicator plus OR.
+        int             threads = 0; // 0: all hardware threads.
+        int             portfolioSize = 0; // 0: default.
+        bool            heurCallback = false;
+        double          heurTime = 1; // seconds of local search per callback call.
+        double          heurInterval = 10; // seconds between node relaxation roundings.
+        double          pipelineFraction = 0.2; // share of timeLimit for the ROC stage of method 4.
+        int             mlCoarsestCells = 64; // coarsening of method 5 stops at this many super-cells.
+        int             lnsWindowRows = 0; // site window of method 6 (0: default).
+        int             lnsWindowCols = 0;
+        double          lnsWindowTime = 5; // seconds per window sub-MIP.
+        int             envPoolSize = 0; // 0: keep the current pool size.
+        int             priority = 0; // server mode: higher runs first.
+        std::string     siteFileName = ""; // site coordinates and blocked sites; "": unit-spaced.
+        double          memBudget = 0; // MB for the model plan; 0: physical memory.
+        bool            cpExhaustive = false; // method 7: search to completion regardless of timeLimit.
+        int             tileRows = 0; // tile of method 8 (0: chosen automatically).
+        int             tileCols = 0;
+        int             colIterations = 3; // assignment / ordering rounds of method 9.
+        double          colTime = 5; // seconds per column sub-MIP of method 9.
+        int             embedMode = 0; // initial solution of another shape: 0: rows / columns spread; 1: at the end.
+        std::string     cacheDir = "output/cache"; // best-known registry (see ResultCache); "": none.
+        std::vector<SolvePhase> solvePhases; // staged solve of methods 1 and 2 (see SolvePhase); empty: one optimize().
+        double          phaseTol = 1e-4; // relative improvement that counts as progress of a phase.
+        bool            userCuts = false; // methods 1 and 2: separate CutSeparator cuts at the nodes.
+
     };
 
     // For trials using ILP.
@@ -56,23 +97,87 @@ public:
     void    setRelativeConstraintXY(bool bx, bool by);
     void    setTimeLimit(double timeLimit);
     void    setInitSolFileName(const std::string initSolFileName);
+    void    setNOCMode(int NOCMode);
+    void    setThreads(int threads);
+    void    setPortfolioSize(int portfolioSize);
+    void    setHeuristicCallback(bool enable, double timeBudget, double relaxInterval);
+    void    setPipelineFraction(double fraction);
+    void    setMultilevelCoarsestCells(int numCells);
+    void    setLNSWindow(int rows, int cols, double timeLimit);
+    void    setCPExhaustive(bool b);
+    void    setTileSize(int rows, int cols);
+    void    setEmbedMode(int mode);
+    void    setColumnDecomposition(int iterations, double columnTime);
+    void    setSolvePhases(const std::vector<SolvePhase> &phases, double tol);
+    void    setUserCuts(bool enable);
+    void    setEnvPoolSize(int size);
+    bool    setSiteFile(const std::string &siteFileName);
+    bool    setNetlistFile(const std::string &netlistFileName);
+    bool    addDesignJob(const std::string &netlistFileName, const std::vector<std::string> &fields);
+    void    setMemoryBudget(double megabytes);
     void    run();
     void    run2();
     void    run3();
     void    run4();
+    void    runPortfolio();
+    void    runPipeline();
+    void    runMultilevel();
+    void    runLNS();
+    void    runCP();
+    void    runTile();
+    void    runColumns();
+    void    runSpectral();
+    void    runAnalytical();
     void    runBatch();
     void    runBatchFromFile(const std::string batchFileName);
     void    runJobs();
+    void    runJob(const JOB &job);
+    const std::string & lastSolFileName() const { return m_lastSolFileName; }
+
+    static bool parseJobTokens(const std::vector<std::string> &tokens, std::vector<JOB> &jobs);
+    static PlacementProblem jobProblem(const JOB &job);
 
     // DSP placement prior to global placement.
     void    placeAndFixDSP();
 
     void    dbg_printProblemInfo();
+    void    dbg_printModelPlan(int method, const ModelSize &size);
 
 
 
 private:
 
+    int     cellId(int i, int j) const { return i * m_arraySizeX + j; }
+    PlacementProblem problem() const;
+    EnvPool & envPool();
+    std::string solFileBaseName() const;
+    ModelSize estimateMethod(int method);
+    int     planJob(int method);
+
+    void    buildModel2(GRBModel &model, std::vector<GRBVar> &x, std::vector<GRBVar> &y, int NOCMode, GRBLinExpr *objective = nullptr);
+    void    buildModel3(GRBModel &model, std::vector<GRBVar> &y, int NOCMode, GRBLinExpr *objective = nullptr);
+    void    buildModel4(GRBModel &model, std::vector<GRBVar> &y, int NOCMode);
+    void    addOneColumnNOCAndROC(GRBModel &model, const std::vector<GRBVar> &y, int NOCMode, const RocPresolve &presolve);
+    void    addPhysicalCoords(GRBModel &model, const std::vector<GRBVar> &v, bool isY, std::vector<GRBVar> &pv);
+    void    addBlockedSiteConstrs(GRBModel &model, const std::vector<GRBVar> &x, const std::vector<GRBVar> &y, const SiteWindow *win = nullptr);
+    void    addPairConstrs(ModelBuilder &builder, const PlacementProblem &prob, const std::vector<char> &isFree, int NOCMode);
+    void    addRelativeConstrs(GRBModel &model, const PlacementProblem &prob, const std::vector<GRBVar> &x,
+                               const std::vector<GRBVar> &y, const std::vector<char> &isFree);
+    GRBVar  addAbsDiff(GRBModel &model, const GRBVar &v0, const GRBVar &v1, const std::string &name);
+    void    noteBound(GRBModel &model, double scale);
+    void    optimizeInPhases(GRBModel &model, PlacerCallback &cb);
+    bool    solvePlacement(const PlacementProblem &prob, double timeLimit, const Placement *start, Placement &result, bool quiet = false);
+    bool    solveWindow(const PlacementProblem &prob, const Placement &pl, const SiteWindow &win, double timeLimit, Placement &result);
+    void    buildWindowModel(GRBModel &model, const PlacementProblem &prob, const Placement &pl, const SiteWindow &win,
+                             const std::vector<int> &freeCells, std::vector<GRBVar> &x, std::vector<GRBVar> &y);
+    bool    getPlacement(GRBModel &model, std::vector<GRBVar> &x, std::vector<GRBVar> &y, Placement &pl);
+    void    setStart(const Placement &pl, std::vector<GRBVar> &x, std::vector<GRBVar> &y);
+    bool    setStartFromFile(const std::string &fileName, std::vector<GRBVar> &x, std::vector<GRBVar> &y);
+    bool    readStartPlacement(const std::string &fileName, const PlacementProblem &prob, Placement &pl);
+    void    runPortfolioMember(int memberId, bool oneColumn, int threads, IncumbentPool &pool);
+
+    static bool parseJobOption(JOB &job, const std::string &token);
+
     int     flow(int i, int j);
     bool    isConnected(int row0, int col0, int row1, int col1);
     int     manhDist(int x0, int y0, int x1, int y1);
@@ -88,7 +193,10 @@ private:
 
 private:
     // Database & m_db;
-    // Netlist & m_nl;
+
+    // Netlist of the design (design.rglr), null if none was read.
+    std::string m_netlistFileName = "";
+    std::shared_ptr<const Netlist> m_nl;
 
 
     int m_arraySizeX = 0;
@@ -106,7 +214,58 @@ private:
 
     std::string m_initSolFileName = "";
 
-    // Vector2D<IndexType> m_dspIdArray;
+    int m_NOCMode = 0;
+    int m_threads = 0;
+    int m_portfolioSize = 0;
+
+    bool m_heurCallback = false;
+    double m_heurTime = 1;
+    double m_heurInterval = 10;
+
+    double m_pipelineFraction = 0.2;
+    int m_mlCoarsestCells = 64;
+
+    int m_lnsWindowRows = 0;
+    int m_lnsWindowCols = 0;
+    double m_lnsWindowTime = 5;
+
+    bool m_cpExhaustive = false;
+
+    int m_tileRows = 0;
+    int m_tileCols = 0;
+
+    int m_embedMode = 0;
+
+    int m_colIterations = 3;
+    double m_colTime = 5;
+
+    // Staged solve of the run2()/run3()/run4() models; empty: a single optimize().
+    std::vector<SolvePhase> m_solvePhases;
+    double m_phaseTol = 1e-4;
+
+    bool m_userCuts = false;
+
+    // Gurobi environments shared by all jobs (and concurrent solves) of this placer.
+    int m_envPoolSize = 0;
+    std::shared_ptr<EnvPool> m_envPool;
+    std::mutex m_envPoolMutex;
+
+    // Physical site geometry of the current job; null for unit-spaced sites.
+    std::string m_siteFileName = "";
+    std::shared_ptr<const SiteGeometry> m_siteGeometry;
+
+    // Memory budget of the model plan in MB; 0: physical memory.
+    double m_memBudget = 0;
+
+    // Solution file written by the last runJob(), empty if none.
+    std::string m_lastSolFileName = "";
+    // Lower bound on the wirelength and proven optimality from the last runJob()'s solves, for the registry.
+    double m_lastBound = 0;
+    bool m_lastOptimal = false;
+    std::mutex m_boundMutex;
+
+    // Netlist DSP id at every array cell (cellId()), -1 if none.
+    std::vector<int> m_dspIdArray;
     std::vector<JOB> m_jobList;
 };
 
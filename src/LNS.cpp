@@ -0,0 +1,164 @@
+#include "LNS.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+
+LNSPlacer::LNSPlacer(const PlacementProblem &prob, WindowSolver solver)
+    : m_prob(prob), m_solver(solver)
+{
+    m_windowRows = (prob.siteSizeX == 1) ? 24 : 6;
+    m_windowCols = std::min(prob.siteSizeX, 4);
+}
+
+/**
+ * @brief Improve a legal placement in place until the time limit, or until a full sweep brings nothing if there is no limit.
+ *
+ * @param pl
+ * @param timeLimit seconds; <= 0 for no limit.
+ * @return double the wirelength of the resulting placement.
+ */
+double LNSPlacer::run(Placement &pl, double timeLimit) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+    auto timeout = [&]() { return timeLimit > 0 && elapsed() >= timeLimit; };
+
+    const int strideY = std::max(1, m_windowRows / 2);
+    const int strideX = std::max(1, m_windowCols / 2);
+    const int threads = std::max(1, m_threads);
+    std::mt19937 rng(m_prob.numCells());
+
+    printf("LNS: windows of %d x %d sites, %d in parallel, start wirelength %.1f\n", m_windowRows, m_windowCols, threads, placementWirelength(m_prob, pl));
+
+    bool stalled = false;
+    for (int sweep = 0; !timeout(); sweep++) {
+        int accepted = 0;
+        if (!stalled) {
+            // Slide the tiling by half a window, so every boundary is inside some window once per sweep.
+            for (int oy = 0; oy < m_windowRows && !timeout(); oy += strideY) {
+                for (int ox = 0; ox < m_windowCols && !timeout(); ox += strideX) {
+                    std::vector<SiteWindow> windows = slidingWindows(oy, ox);
+                    for (size_t k = 0; k < windows.size() && !timeout(); k += threads) {
+                        std::vector<SiteWindow> batch(windows.begin() + k, windows.begin() + std::min(windows.size(), k + threads));
+                        accepted += solveBatch(pl, batch);
+                    }
+                }
+            }
+            stalled = (accepted == 0);
+            if (stalled && timeLimit <= 0) {
+                break;
+            }
+        }
+        else {
+            // Random windows, greedily kept non-overlapping.
+            std::vector<SiteWindow> batch;
+            for (int tries = 0; tries < 4 * threads && (int)batch.size() < threads; tries++) {
+                SiteWindow w = randomWindow(pl, rng);
+                bool free = true;
+                for (const SiteWindow &b: batch) {
+                    free &= !b.overlaps(w);
+                }
+                if (free) {
+                    batch.push_back(w);
+                }
+            }
+            accepted = solveBatch(pl, batch);
+            stalled = (accepted == 0);
+        }
+        printf("LNS: sweep %d%s, %d windows improved, wirelength %.1f (%.1fs)\n",
+            sweep, stalled ? " (random)" : "", accepted, placementWirelength(m_prob, pl), elapsed());
+    }
+
+    return placementWirelength(m_prob, pl);
+}
+
+/**
+ * @brief Tile the site grid with windows, the first row/column of tiles starting at (offsetY, offsetX) - window size.
+ *
+ * @param offsetY
+ * @param offsetX
+ * @return std::vector<SiteWindow> pairwise non-overlapping windows.
+ */
+std::vector<SiteWindow> LNSPlacer::slidingWindows(int offsetY, int offsetX) const {
+    std::vector<SiteWindow> windows;
+    int startY = (offsetY > 0) ? offsetY - m_windowRows : 0;
+    int startX = (offsetX > 0) ? offsetX - m_windowCols : 0;
+    for (int y = startY; y < m_prob.siteSizeY; y += m_windowRows) {
+        for (int x = startX; x < m_prob.siteSizeX; x += m_windowCols) {
+            SiteWindow w;
+            w.y0 = std::max(0, y);
+            w.y1 = std::min(m_prob.siteSizeY, y + m_windowRows);
+            w.x0 = std::max(0, x);
+            w.x1 = std::min(m_prob.siteSizeX, x + m_windowCols);
+            windows.push_back(w);
+        }
+    }
+    return windows;
+}
+
+/**
+ * @brief A window centered on the site of a random cell.
+ *
+ * @param pl
+ * @param rng
+ * @return SiteWindow
+ */
+SiteWindow LNSPlacer::randomWindow(const Placement &pl, std::mt19937 &rng) const {
+    int c = std::uniform_int_distribution<int>(0, m_prob.numCells() - 1)(rng);
+    SiteWindow w;
+    w.y0 = std::max(0, std::min(m_prob.siteSizeY - m_windowRows, pl.y(c) - m_windowRows / 2));
+    w.x0 = std::max(0, std::min(m_prob.siteSizeX - m_windowCols, pl.x(c) - m_windowCols / 2));
+    w.y1 = std::min(m_prob.siteSizeY, w.y0 + m_windowRows);
+    w.x1 = std::min(m_prob.siteSizeX, w.x0 + m_windowCols);
+    return w;
+}
+
+/**
+ * @brief Solve non-overlapping windows in parallel against the same snapshot, then apply their results one by one.
+ * A result is kept only if the whole placement stays legal and its wirelength improves, since windows may share array edges.
+ *
+ * @param pl
+ * @param windows
+ * @return int the number of windows whose result was kept.
+ */
+int LNSPlacer::solveBatch(Placement &pl, const std::vector<SiteWindow> &windows) {
+    const Placement snapshot = pl;
+    std::vector<Placement> results(windows.size());
+    std::vector<char> solved(windows.size(), 0);
+
+    std::vector<std::thread> workers;
+    for (size_t k = 0; k < windows.size(); k++) {
+        workers.emplace_back([&, k]() {
+            solved[k] = m_solver(m_prob, snapshot, windows[k], m_windowTime, results[k]);
+        });
+    }
+    for (std::thread &t: workers) {
+        t.join();
+    }
+
+    int accepted = 0;
+    double wl = placementWirelength(m_prob, pl);
+    for (size_t k = 0; k < windows.size(); k++) {
+        if (!solved[k]) {
+            continue;
+        }
+        Placement cand = pl;
+        for (int c = 0; c < m_prob.numCells(); c++) {
+            if (windows[k].contains(snapshot.y(c), snapshot.x(c))) {
+                cand.y(c) = results[k].y(c);
+                cand.x(c) = results[k].x(c);
+            }
+        }
+        double candWl = placementWirelength(m_prob, cand);
+        if (candWl < wl - 1e-6 && isPlacementLegal(m_prob, cand)) {
+            pl = cand;
+            wl = candWl;
+            accepted++;
+        }
+    }
+    return accepted;
+}
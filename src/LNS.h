@@ -0,0 +1,62 @@
+#ifndef __LNS_H__
+#define __LNS_H__
+
+#include "Placement.h"
+#include <functional>
+#include <random>
+#include <vector>
+
+
+/**
+ * @brief A rectangle of sites [y0, y1) x [x0, x1). The cells on it are re-optimized, all others stay fixed.
+ *
+ */
+struct SiteWindow {
+    int     y0 = 0;
+    int     y1 = 0;
+    int     x0 = 0;
+    int     x1 = 0;
+
+    bool    contains(int sy, int sx) const { return sy >= y0 && sy < y1 && sx >= x0 && sx < x1; }
+    bool    overlaps(const SiteWindow &w) const { return y0 < w.y1 && w.y0 < y1 && x0 < w.x1 && w.x0 < x1; }
+};
+
+
+/**
+ * @brief Large-neighbourhood search: repeatedly re-optimizes the cells of a site window with a small exact solve.
+ * Windows slide over the site grid in bands; when a full sweep brings nothing, windows are centered on random cells.
+ * Non-overlapping windows are solved in parallel; results are applied one by one and kept only if the whole placement
+ * stays legal and improves.
+ *
+ */
+class LNSPlacer
+{
+public:
+    // Window solver: (problem, current placement, window, time limit, result) -> success.
+    typedef std::function<bool(const PlacementProblem &, const Placement &, const SiteWindow &, double, Placement &)> WindowSolver;
+
+    LNSPlacer(const PlacementProblem &prob, WindowSolver solver);
+
+    void    setWindowSize(int rows, int cols) { m_windowRows = rows; m_windowCols = cols; }
+    void    setWindowTime(double seconds) { m_windowTime = seconds; }
+    void    setThreads(int threads) { m_threads = threads; }
+    int     windowRows() const { return m_windowRows; }
+    int     windowCols() const { return m_windowCols; }
+
+    double  run(Placement &pl, double timeLimit);
+
+private:
+    std::vector<SiteWindow> slidingWindows(int offsetY, int offsetX) const;
+    SiteWindow              randomWindow(const Placement &pl, std::mt19937 &rng) const;
+    int                     solveBatch(Placement &pl, const std::vector<SiteWindow> &windows);
+
+    PlacementProblem    m_prob;
+    WindowSolver        m_solver;
+    int                 m_windowRows = 0;
+    int                 m_windowCols = 0;
+    double              m_windowTime = 5;
+    int                 m_threads = 1;
+};
+
+
+#endif
@@ -0,0 +1,335 @@
+#include "LocalSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+
+
+LocalSearch::LocalSearch(const PlacementProblem &prob)
+    : m_prob(prob)
+    , m_kernel(makeCostKernel(prob))
+{}
+
+/**
+ * @brief Improve a legal placement in place until no move helps or <timeLimit> seconds pass.
+ *
+ * @param pl
+ * @param timeLimit
+ * @return double the wirelength of the resulting placement.
+ */
+double LocalSearch::run(Placement &pl, double timeLimit) {
+    const int numCells = m_prob.numCells();
+    auto start = std::chrono::steady_clock::now();
+
+    m_siteCell.assign(m_prob.numSites(), -1);
+    for (int c = 0; c < numCells; c++) {
+        m_siteCell[m_prob.siteId(pl.y(c), pl.x(c))] = c;
+    }
+    if (m_fixed.size() != (size_t)numCells) {
+        m_fixed.assign(numCells, 0);
+    }
+
+    std::vector<int> order(numCells);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(numCells);
+
+    bool improved = true;
+    bool timeout = false;
+    while (improved && !timeout) {
+        improved = false;
+        std::shuffle(order.begin(), order.end(), rng);
+
+        for (int k = 0; k < numCells && !timeout; k++) {
+            int c = order[k];
+            if (m_fixed[c]) {
+                continue;
+            }
+
+            int my, mx;
+            neighborMedian(pl, c, my, mx);
+            int y0 = std::max(0, my - m_windowY), y1 = std::min(m_prob.siteSizeY - 1, my + m_windowY);
+            int x0 = std::max(0, mx - m_windowX), x1 = std::min(m_prob.siteSizeX - 1, mx + m_windowX);
+
+            bool moved = false;
+            for (int sy = y0; sy <= y1 && !moved; sy++) {
+                for (int sx = x0; sx <= x1 && !moved; sx++) {
+                    moved = tryMove(pl, c, sy, sx);
+                }
+            }
+            improved |= moved;
+
+            if (timeLimit > 0 && (k & 63) == 0) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                timeout = (elapsed.count() >= timeLimit);
+            }
+        }
+    }
+
+    return m_kernel->wirelength(pl.xs().data(), pl.ys().data());
+}
+
+/**
+ * @brief Check the relative ordering constraints between cell <c> and its array neighbors.
+ *
+ * @param pl
+ * @param c
+ * @return true
+ * @return false
+ */
+bool LocalSearch::isCellOrderLegal(const Placement &pl, int c) const {
+    int i = c / m_prob.arraySizeX;
+    int j = c % m_prob.arraySizeX;
+    int left = c - 1, right = c + 1, down = c - m_prob.arraySizeX, up = c + m_prob.arraySizeX;
+
+    if (m_prob.relativeConstraintX) {
+        if (j > 0 && pl.x(left) > pl.x(c)) return false;
+        if (j + 1 < m_prob.arraySizeX && pl.x(c) > pl.x(right)) return false;
+    }
+    if (m_prob.relativeConstraintY) {
+        if (i > 0 && pl.y(down) > pl.y(c)) return false;
+        if (i + 1 < m_prob.arraySizeY && pl.y(c) > pl.y(up)) return false;
+    }
+    if (m_prob.strictOrderY) {
+        if (j > 0 && pl.y(left) >= pl.y(c)) return false;
+        if (j + 1 < m_prob.arraySizeX && pl.y(c) >= pl.y(right)) return false;
+        if (i > 0 && pl.y(down) >= pl.y(c)) return false;
+        if (i + 1 < m_prob.arraySizeY && pl.y(c) >= pl.y(up)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Move cell <c> to site (sy, sx), swapping with the cell there if any. The move is kept only if it reduces the wirelength and stays legal.
+ *
+ * @param pl
+ * @param c
+ * @param sy
+ * @param sx
+ * @return true if the move was kept.
+ */
+bool LocalSearch::tryMove(Placement &pl, int c, int sy, int sx) {
+    int site = m_prob.siteId(sy, sx);
+    int c2 = m_siteCell[site];
+    if (c2 == c || (c2 >= 0 && m_fixed[c2]) || m_prob.isSiteBlocked(sy, sx)) {
+        return false;
+    }
+
+    if (m_kernel->moveDelta(pl.xs().data(), pl.ys().data(), c, c2, sy, sx) >= -1e-9) {
+        return false;
+    }
+
+    int oy = pl.y(c), ox = pl.x(c);
+    pl.y(c) = sy;
+    pl.x(c) = sx;
+    if (c2 >= 0) {
+        pl.y(c2) = oy;
+        pl.x(c2) = ox;
+    }
+
+    if (isCellOrderLegal(pl, c) && (c2 < 0 || isCellOrderLegal(pl, c2))) {
+        m_siteCell[site] = c;
+        m_siteCell[m_prob.siteId(oy, ox)] = c2;
+        return true;
+    }
+
+    // Revert.
+    pl.y(c) = oy;
+    pl.x(c) = ox;
+    if (c2 >= 0) {
+        pl.y(c2) = sy;
+        pl.x(c2) = sx;
+    }
+    return false;
+}
+
+/**
+ * @brief Median site of the array neighbors of cell <c>, where its incident wirelength is minimal.
+ *
+ * @param pl
+ * @param c
+ * @param sy
+ * @param sx
+ */
+void LocalSearch::neighborMedian(const Placement &pl, int c, int &sy, int &sx) const {
+    int i = c / m_prob.arraySizeX;
+    int j = c % m_prob.arraySizeX;
+    int ys[4], xs[4], n = 0;
+    auto add = [&](int nb) { ys[n] = pl.y(nb); xs[n] = pl.x(nb); n++; };
+    if (i > 0) add(c - m_prob.arraySizeX);
+    if (i + 1 < m_prob.arraySizeY) add(c + m_prob.arraySizeX);
+    if (j > 0) add(c - 1);
+    if (j + 1 < m_prob.arraySizeX) add(c + 1);
+
+    if (n == 0) {
+        sy = pl.y(c);
+        sx = pl.x(c);
+        return;
+    }
+    std::sort(ys, ys + n);
+    std::sort(xs, xs + n);
+    sy = ys[(n - 1) / 2];
+    sx = xs[(n - 1) / 2];
+}
+
+/**
+ * @brief Turn fractional cell positions (e.g. a node relaxation) into a legal placement.
+ * One column: cells keep the order of their relaxed y and are packed onto distinct unblocked sites.
+ * Otherwise: cells take the free site nearest to their rounded position, in order of relaxed (y, x).
+ *
+ * @param prob
+ * @param relX empty for one column.
+ * @param relY
+ * @param pl
+ * @return true if the result is a legal placement.
+ */
+bool LocalSearch::roundAndRepair(const PlacementProblem &prob, const std::vector<double> &relX, const std::vector<double> &relY, Placement &pl) {
+    const int n = prob.numCells();
+    if (n > prob.numFreeSites()) {
+        return false;
+    }
+    pl.resize(prob);
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    auto relXOf = [&](int c) { return relX.empty() ? 0.0 : relX[c]; };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        if (relY[a] != relY[b]) return relY[a] < relY[b];
+        // Ties follow the array order, which keeps the ROC.
+        int ra = a / prob.arraySizeX + a % prob.arraySizeX, rb = b / prob.arraySizeX + b % prob.arraySizeX;
+        if (ra != rb) return ra < rb;
+        return relXOf(a) < relXOf(b);
+    });
+
+    if (prob.siteSizeX == 1) {
+        // Pack in the index space of the unblocked rows.
+        std::vector<int> rows;
+        for (int sy = 0; sy < prob.siteSizeY; sy++) {
+            if (!prob.isSiteBlocked(sy, 0)) {
+                rows.push_back(sy);
+            }
+        }
+        const int numRows = rows.size();
+        std::vector<int> pos(n);
+        for (int k = 0; k < n; k++) {
+            pos[k] = std::lower_bound(rows.begin(), rows.end(), (int)std::lround(relY[order[k]])) - rows.begin();
+            if (k > 0) pos[k] = std::max(pos[k], pos[k - 1] + 1);
+        }
+        for (int k = n - 1; k >= 0; k--) {
+            int ub = numRows - (n - k);
+            if (k + 1 < n) ub = std::min(ub, pos[k + 1] - 1);
+            pos[k] = std::min(pos[k], ub);
+        }
+        for (int k = 0; k < n; k++) {
+            pl.y(order[k]) = rows[pos[k]];
+            pl.x(order[k]) = 0;
+        }
+        return isPlacementLegal(prob, pl);
+    }
+
+    std::vector<char> used(prob.numSites(), 0);
+    int maxRadius = std::max(prob.siteSizeY, prob.siteSizeX);
+    for (int c: order) {
+        int ty = std::min(prob.siteSizeY - 1, std::max(0, (int)std::lround(relY[c])));
+        int tx = std::min(prob.siteSizeX - 1, std::max(0, (int)std::lround(relXOf(c))));
+        int bestSite = -1;
+        double bestDist = 0;
+        for (int r = 0; r <= maxRadius && bestSite < 0; r++) {
+            for (int sy = std::max(0, ty - r); sy <= std::min(prob.siteSizeY - 1, ty + r); sy++) {
+                for (int sx = std::max(0, tx - r); sx <= std::min(prob.siteSizeX - 1, tx + r); sx++) {
+                    int s = prob.siteId(sy, sx);
+                    if (used[s] || prob.isSiteBlocked(sy, sx)) continue;
+                    double d = prob.weightY * prob.distY(sy, ty) + prob.weightX * prob.distX(sx, tx);
+                    if (bestSite < 0 || d < bestDist) {
+                        bestSite = s;
+                        bestDist = d;
+                    }
+                }
+            }
+        }
+        used[bestSite] = 1;
+        pl.y(c) = bestSite / prob.siteSizeX;
+        pl.x(c) = bestSite % prob.siteSizeX;
+    }
+    return isPlacementLegal(prob, pl);
+}
+
+/**
+ * @brief Fix violated relative ordering constraints by swapping the sites of violating neighbor pairs.
+ * Overlap-freedom is kept; each pass swaps every pair found out of order.
+ *
+ * @param prob
+ * @param pl
+ * @param maxPasses
+ * @return true if the result is a legal placement.
+ */
+bool LocalSearch::repairRelativeOrder(const PlacementProblem &prob, Placement &pl, int maxPasses) {
+    auto swapCells = [&](int a, int b) {
+        std::swap(pl.x(a), pl.x(b));
+        std::swap(pl.y(a), pl.y(b));
+    };
+
+    for (int pass = 0; pass < maxPasses; pass++) {
+        bool swapped = false;
+        for (int i = 0; i < prob.arraySizeY; i++) {
+            for (int j = 0; j < prob.arraySizeX; j++) {
+                int c0 = prob.cellId(i, j);
+                if (j + 1 < prob.arraySizeX) {
+                    int c1 = prob.cellId(i, j + 1);
+                    if ((prob.relativeConstraintX && pl.x(c0) > pl.x(c1)) || (prob.strictOrderY && pl.y(c0) > pl.y(c1))) {
+                        swapCells(c0, c1);
+                        swapped = true;
+                    }
+                }
+                if (i + 1 < prob.arraySizeY) {
+                    int c1 = prob.cellId(i + 1, j);
+                    if ((prob.relativeConstraintY || prob.strictOrderY) && pl.y(c0) > pl.y(c1)) {
+                        swapCells(c0, c1);
+                        swapped = true;
+                    }
+                }
+            }
+        }
+        if (!swapped) {
+            break;
+        }
+    }
+    return isPlacementLegal(prob, pl);
+}
+
+/**
+ * @brief Constructive placement without a solver.
+ * One column: cells in anti-diagonal order (i + j, then i), which satisfies every ROC, packed onto the sites.
+ * Otherwise: the array is scaled onto the site grid, legalized to the nearest free sites, and the ROC repaired.
+ *
+ * @param prob
+ * @param pl
+ * @return true if the result is a legal placement.
+ */
+bool LocalSearch::initialPlacement(const PlacementProblem &prob, Placement &pl) {
+    const int n = prob.numCells();
+    std::vector<double> relX, relY(n);
+
+    if (prob.siteSizeX == 1) {
+        // roundAndRepair() breaks ties by (i + j), then by cell index; all-zero targets pack the cells in that order.
+        return roundAndRepair(prob, relX, relY, pl);
+    }
+
+    relX.resize(n);
+    double scaleY = (double)prob.siteSizeY / prob.arraySizeY;
+    double scaleX = (double)prob.siteSizeX / prob.arraySizeX;
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            relY[prob.cellId(i, j)] = (i + 0.5) * scaleY - 0.5;
+            relX[prob.cellId(i, j)] = (j + 0.5) * scaleX - 0.5;
+        }
+    }
+    if (roundAndRepair(prob, relX, relY, pl)) {
+        return true;
+    }
+    if (pl.numCells() != n) {
+        return false;
+    }
+    return repairRelativeOrder(prob, pl);
+}
@@ -0,0 +1,45 @@
+#ifndef __LOCALSEARCH_H__
+#define __LOCALSEARCH_H__
+
+#include "CostKernel.h"
+#include "Placement.h"
+#include <memory>
+#include <vector>
+
+
+/**
+ * @brief Swap/shift refinement of a legal placement under the weighted Manhattan wirelength.
+ * A cell is moved to a site near the median of its array neighbors, swapping with the cell there if occupied.
+ * Moves that break overlap-freedom, the relative ordering constraints or fixed cells are rejected.
+ *
+ */
+class LocalSearch
+{
+public:
+    explicit LocalSearch(const PlacementProblem &prob);
+
+    void    setFixedCells(const std::vector<char> &fixed) { m_fixed = fixed; }
+    void    setWindow(int windowY, int windowX) { m_windowY = windowY; m_windowX = windowX; }
+    void    setKernel(const std::shared_ptr<const CostKernel> &kernel) { m_kernel = kernel; }
+
+    double  run(Placement &pl, double timeLimit);
+
+    static bool roundAndRepair(const PlacementProblem &prob, const std::vector<double> &relX, const std::vector<double> &relY, Placement &pl);
+    static bool repairRelativeOrder(const PlacementProblem &prob, Placement &pl, int maxPasses = 1000);
+    static bool initialPlacement(const PlacementProblem &prob, Placement &pl);
+
+private:
+    bool    isCellOrderLegal(const Placement &pl, int c) const;
+    bool    tryMove(Placement &pl, int c, int sy, int sx);
+    void    neighborMedian(const Placement &pl, int c, int &sy, int &sx) const;
+
+    PlacementProblem    m_prob;
+    std::shared_ptr<const CostKernel>   m_kernel;
+    std::vector<int>    m_siteCell; // Cell on each site, -1 if empty.
+    std::vector<char>   m_fixed;
+    int                 m_windowY = 4;
+    int                 m_windowX = 2;
+};
+
+
+#endif
@@ -0,0 +1,249 @@
+#include "ModelBuild.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+
+void ModelBlock::Csr::add(const Terms &terms, char s, double r) {
+    for (const std::pair<int, double> &t: terms) {
+        ind.push_back(t.first);
+        val.push_back(t.second);
+    }
+    beg.push_back(ind.size());
+    sense.push_back(s);
+    rhs.push_back(r);
+}
+
+int ModelBlock::addVar(double lb, double ub, char type, const std::string &name) {
+    m_lb.push_back(lb);
+    m_ub.push_back(ub);
+    m_type.push_back(type);
+    m_varNames.push_back(name);
+    return m_lb.size() - 1;
+}
+
+void ModelBlock::addRow(const Terms &terms, char sense, double rhs, const std::string &name) {
+    m_rows.add(terms, sense, rhs);
+    m_rowNames.push_back(name);
+}
+
+void ModelBlock::addAbs(int res, int arg, const std::string &name) {
+    m_gens.emplace_back('A', m_absRes.size());
+    m_absRes.push_back(res);
+    m_absArg.push_back(arg);
+    m_absNames.push_back(name);
+}
+
+void ModelBlock::addIndicator(int bin, int binVal, const Terms &terms, char sense, double rhs) {
+    m_gens.emplace_back('I', m_indBin.size());
+    m_indBin.push_back(bin);
+    m_indVal.push_back(binVal);
+    m_indRows.add(terms, sense, rhs);
+}
+
+void ModelBlock::addOr(int res, const std::vector<int> &args, const std::string &name) {
+    m_gens.emplace_back('O', m_orRes.size());
+    m_orRes.push_back(res);
+    m_orArgs.insert(m_orArgs.end(), args.begin(), args.end());
+    m_orBeg.push_back(m_orArgs.size());
+    m_orNames.push_back(name);
+}
+
+void ModelBlock::addObj(int ref, double coef) {
+    m_objRef.push_back(ref);
+    m_objCoef.push_back(coef);
+}
+
+int ModelBlock::absDiff(int v0, int v1, const std::string &name) {
+    int d = addVar(-GRB_INFINITY, GRB_INFINITY, GRB_CONTINUOUS, "d_" + name);
+    addRow({{d, 1}, {v0, -1}, {v1, 1}}, GRB_EQUAL, 0, "");
+    int a = addVar(0, GRB_INFINITY, GRB_CONTINUOUS, name);
+    addAbs(a, d, "");
+    return a;
+}
+
+
+ModelBuilder::ModelBuilder(GRBModel &model, const std::vector<GRBVar> &baseVars, int threads)
+    : m_model(model), m_base(baseVars), m_threads(std::max(1, threads))
+{}
+
+/**
+ * @brief Generate blocks [0, numBlocks) with <gen> on the worker threads and insert them into the model in block order.
+ * Blocks are processed in waves of a few blocks per thread, so only one wave of buffers is held at a time.
+ *
+ * @param numBlocks
+ * @param gen fills block <id>; called concurrently for different blocks.
+ */
+void ModelBuilder::build(int numBlocks, const Generator &gen) {
+    const int waveSize = 4 * m_threads;
+    for (int first = 0; first < numBlocks; first += waveSize) {
+        const int n = std::min(waveSize, numBlocks - first);
+        std::vector<ModelBlock> blocks(n);
+        std::vector<std::vector<GRBVar>> blockVars(n);
+        std::vector<std::vector<GRBLinExpr>> rows(n);
+
+        // Runs work(k) for k in [0, n) on the worker threads.
+        auto parallel = [&](const std::function<void(int)> &work) {
+            std::atomic<int> next(0);
+            auto worker = [&]() {
+                for (int k = next++; k < n; k = next++) {
+                    work(k);
+                }
+            };
+            std::vector<std::thread> workers;
+            for (int t = 1; t < std::min(m_threads, n); t++) {
+                workers.emplace_back(worker);
+            }
+            worker();
+            for (std::thread &t: workers) {
+                t.join();
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        parallel([&](int k) { gen(first + k, blocks[k]); });
+        auto generated = std::chrono::steady_clock::now();
+
+        // Variables first (the expressions need them), then the rows of all blocks in parallel, then insertion.
+        for (int k = 0; k < n; k++) {
+            const ModelBlock &b = blocks[k];
+            const int numVars = b.m_lb.size();
+            if (numVars > 0) {
+                GRBVar *v = m_model.addVars(b.m_lb.data(), b.m_ub.data(), NULL, b.m_type.data(), b.m_varNames.data(), numVars);
+                blockVars[k].assign(v, v + numVars);
+                delete[] v;
+            }
+        }
+        parallel([&](int k) {
+            rows[k].resize(blocks[k].m_rows.size());
+            for (int r = 0; r < blocks[k].m_rows.size(); r++) {
+                rows[k][r] = expr(blocks[k].m_rows, r, blockVars[k]);
+            }
+        });
+        for (int k = 0; k < n; k++) {
+            insert(blocks[k], blockVars[k], rows[k]);
+        }
+
+        std::chrono::duration<double> genTime = generated - start;
+        std::chrono::duration<double> insertTime = std::chrono::steady_clock::now() - generated;
+        m_genSeconds += genTime.count();
+        m_insertSeconds += insertTime.count();
+    }
+}
+
+GRBLinExpr ModelBuilder::expr(const ModelBlock::Csr &csr, int k, const std::vector<GRBVar> &blockVars) const {
+    const int b = csr.beg[k], e = csr.beg[k + 1];
+    std::vector<GRBVar> vars(e - b);
+    for (int t = b; t < e; t++) {
+        vars[t - b] = var(blockVars, csr.ind[t]);
+    }
+    GRBLinExpr le;
+    le.addTerms(csr.val.data() + b, vars.data(), e - b);
+    return le;
+}
+
+/**
+ * @brief Add the rows, general constraints and objective terms of one block, and fold them into the fingerprint.
+ *
+ * @param block
+ * @param blockVars
+ * @param rows the linear rows of <block> as expressions.
+ */
+void ModelBuilder::insert(const ModelBlock &block, std::vector<GRBVar> &blockVars, std::vector<GRBLinExpr> &rows) {
+    const long long varOffset = m_numVars;
+    // Global variable index of a reference: base variables stay negative.
+    auto global = [&](int ref) { return (ref >= 0) ? varOffset + ref : (long long)ref; };
+
+    for (size_t v = 0; v < block.m_lb.size(); v++) {
+        hash(&block.m_lb[v], sizeof(double));
+        hash(&block.m_ub[v], sizeof(double));
+        hash(&block.m_type[v], 1);
+        hash(block.m_varNames[v].data(), block.m_varNames[v].size());
+    }
+    m_numVars += block.m_lb.size();
+
+    const ModelBlock::Csr &csr = block.m_rows;
+    if (csr.size() > 0) {
+        delete[] m_model.addConstrs(rows.data(), csr.sense.data(), csr.rhs.data(), block.m_rowNames.data(), csr.size());
+    }
+    for (int r = 0; r < csr.size(); r++) {
+        for (int t = csr.beg[r]; t < csr.beg[r + 1]; t++) {
+            long long g = global(csr.ind[t]);
+            hash(&g, sizeof(g));
+            hash(&csr.val[t], sizeof(double));
+        }
+        hash(&csr.sense[r], 1);
+        hash(&csr.rhs[r], sizeof(double));
+        hash(block.m_rowNames[r].data(), block.m_rowNames[r].size());
+    }
+    m_numConstrs += csr.size();
+    m_numNonzeros += csr.ind.size();
+
+    for (const std::pair<char, int> &g: block.m_gens) {
+        const int k = g.second;
+        long long ids[2] = {0, 0};
+        if (g.first == 'A') {
+            m_model.addGenConstrAbs(var(blockVars, block.m_absRes[k]), var(blockVars, block.m_absArg[k]), block.m_absNames[k]);
+            ids[0] = global(block.m_absRes[k]);
+            ids[1] = global(block.m_absArg[k]);
+        }
+        else if (g.first == 'I') {
+            const ModelBlock::Csr &ind = block.m_indRows;
+            GRBLinExpr le = expr(ind, k, blockVars);
+            GRBVar bin = var(blockVars, block.m_indBin[k]);
+            if (ind.sense[k] == GRB_GREATER_EQUAL) {
+                m_model.addGenConstrIndicator(bin, block.m_indVal[k], le >= ind.rhs[k]);
+            }
+            else if (ind.sense[k] == GRB_LESS_EQUAL) {
+                m_model.addGenConstrIndicator(bin, block.m_indVal[k], le <= ind.rhs[k]);
+            }
+            else {
+                m_model.addGenConstrIndicator(bin, block.m_indVal[k], le == ind.rhs[k]);
+            }
+            ids[0] = global(block.m_indBin[k]);
+            ids[1] = block.m_indVal[k];
+            for (int t = ind.beg[k]; t < ind.beg[k + 1]; t++) {
+                long long gt = global(ind.ind[t]);
+                hash(&gt, sizeof(gt));
+                hash(&ind.val[t], sizeof(double));
+            }
+            hash(&ind.sense[k], 1);
+            hash(&ind.rhs[k], sizeof(double));
+        }
+        else {
+            std::vector<GRBVar> args;
+            for (int t = block.m_orBeg[k]; t < block.m_orBeg[k + 1]; t++) {
+                args.push_back(var(blockVars, block.m_orArgs[t]));
+                long long gt = global(block.m_orArgs[t]);
+                hash(&gt, sizeof(gt));
+            }
+            m_model.addGenConstrOr(var(blockVars, block.m_orRes[k]), args.data(), args.size(), block.m_orNames[k]);
+            ids[0] = global(block.m_orRes[k]);
+        }
+        hash(&g.first, 1);
+        hash(ids, sizeof(ids));
+    }
+    m_numGenConstrs += block.m_gens.size();
+
+    for (size_t t = 0; t < block.m_objRef.size(); t++) {
+        m_obj += block.m_objCoef[t] * var(blockVars, block.m_objRef[t]);
+        long long g = global(block.m_objRef[t]);
+        hash(&g, sizeof(g));
+        hash(&block.m_objCoef[t], sizeof(double));
+    }
+}
+
+void ModelBuilder::hash(const void *data, size_t bytes) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t k = 0; k < bytes; k++) {
+        m_fingerprint = (m_fingerprint ^ p[k]) * 1099511628211ull;
+    }
+}
+
+void ModelBuilder::printStats(const char *prefix) const {
+    printf("%s%lld vars, %lld constrs (%lld nonzeros), %lld general; generated in %.2fs, inserted in %.2fs on %d threads, fingerprint %016llx\n",
+        prefix, m_numVars, m_numConstrs, m_numNonzeros, m_numGenConstrs, m_genSeconds, m_insertSeconds, m_threads,
+        (unsigned long long)m_fingerprint);
+}
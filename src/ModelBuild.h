@@ -0,0 +1,111 @@
+#ifndef __MODELBUILD_H__
+#define __MODELBUILD_H__
+
+#include "gurobi_c++.h"
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Model elements generated off the model by one worker, for bulk insertion by ModelBuilder.
+ * Variables are referenced by int: r >= 0 is the block's own variable r, base(k) (< 0) is base variable k of the
+ * builder (the cell coordinates). Linear rows are CSR: row k has the terms [beg[k], beg[k + 1]) of (ind, val).
+ * Indicator constraints keep their linear part in a second CSR table.
+ *
+ */
+class ModelBlock
+{
+public:
+    typedef std::vector<std::pair<int, double>> Terms; // (variable reference, coefficient)
+
+    static int  base(int k) { return ~k; }
+
+    int     addVar(double lb, double ub, char type, const std::string &name);
+    void    addRow(const Terms &terms, char sense, double rhs, const std::string &name);
+    void    addAbs(int res, int arg, const std::string &name);
+    void    addIndicator(int bin, int binVal, const Terms &terms, char sense, double rhs);
+    void    addOr(int res, const std::vector<int> &args, const std::string &name);
+    void    addObj(int ref, double coef);
+    int     absDiff(int v0, int v1, const std::string &name); // Continuous |v0 - v1|, as addAbsDiff().
+
+private:
+    friend class ModelBuilder;
+
+    struct Csr {
+        std::vector<int>    beg = std::vector<int>(1, 0);
+        std::vector<int>    ind;
+        std::vector<double> val;
+        std::vector<char>   sense;
+        std::vector<double> rhs;
+
+        void    add(const Terms &terms, char s, double r);
+        int     size() const { return sense.size(); }
+    };
+
+    // Variables.
+    std::vector<double>         m_lb;
+    std::vector<double>         m_ub;
+    std::vector<char>           m_type;
+    std::vector<std::string>    m_varNames;
+    // Linear rows.
+    Csr                         m_rows;
+    std::vector<std::string>    m_rowNames;
+    // General constraints, in generation order: kind 'A' (abs), 'I' (indicator) or 'O' (or), and its index.
+    std::vector<std::pair<char, int>>   m_gens;
+    std::vector<int>            m_absRes, m_absArg;
+    std::vector<std::string>    m_absNames;
+    std::vector<int>            m_indBin, m_indVal;
+    Csr                         m_indRows;
+    std::vector<int>            m_orRes, m_orBeg = std::vector<int>(1, 0), m_orArgs;
+    std::vector<std::string>    m_orNames;
+    // Objective terms.
+    std::vector<int>            m_objRef;
+    std::vector<double>         m_objCoef;
+};
+
+
+/**
+ * @brief Builds a model from blocks generated in parallel. Workers fill ModelBlock buffers for disjoint ranges of
+ * the model (e.g. the pairs of one first cell row); the blocks are then inserted in block order: their variables
+ * with one addVars() call per block, their linear rows converted to expressions in parallel and added with one
+ * addConstrs() call per block, their general constraints one by one (the API has no bulk call for those).
+ * The model is the same for any number of threads.
+ *
+ */
+class ModelBuilder
+{
+public:
+    typedef std::function<void(int, ModelBlock &)> Generator;
+
+    ModelBuilder(GRBModel &model, const std::vector<GRBVar> &baseVars, int threads);
+
+    void    build(int numBlocks, const Generator &gen);
+
+    const GRBLinExpr & objective() const { return m_obj; }
+    void    printStats(const char *prefix) const;
+
+private:
+    GRBVar  var(const std::vector<GRBVar> &blockVars, int ref) const { return (ref >= 0) ? blockVars[ref] : m_base[~ref]; }
+    GRBLinExpr expr(const ModelBlock::Csr &csr, int k, const std::vector<GRBVar> &blockVars) const;
+    void    insert(const ModelBlock &block, std::vector<GRBVar> &blockVars, std::vector<GRBLinExpr> &rows);
+    void    hash(const void *data, size_t bytes);
+
+    GRBModel &          m_model;
+    std::vector<GRBVar> m_base;
+    int                 m_threads = 1;
+    GRBLinExpr          m_obj;
+
+    long long           m_numVars = 0;
+    long long           m_numConstrs = 0;
+    long long           m_numGenConstrs = 0;
+    long long           m_numNonzeros = 0;
+    double              m_genSeconds = 0;
+    double              m_insertSeconds = 0;
+    uint64_t            m_fingerprint = 1469598103934665603ull; // FNV-1a over the inserted elements.
+};
+
+
+#endif
@@ -0,0 +1,200 @@
+#include "ModelPlan.h"
+#include "Presolve.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+
+namespace {
+
+// Bytes per model element, names included, and the growth through presolve and the search tree.
+const double kBytesPerVar = 160;
+const double kBytesPerConstr = 140;
+const double kBytesPerGenConstr = 300;
+const double kBytesPerNonzero = 24;
+const double kSolveFactor = 2.5;
+// Seconds per element added through the C++ API.
+const double kSecondsPerElement = 1.5e-6;
+
+/**
+ * @brief Abs terms: v = a - b, |v| as a general constraint.
+ *
+ */
+void addAbs(ModelSize &m, double count) {
+    m.vars += 2 * count;
+    m.constrs += count;
+    m.genConstrs += count;
+    m.nonzeros += 5 * count;
+}
+
+/**
+ * @brief OR of <numDirs> indicator directions, forced true.
+ *
+ */
+void addIndicatorOr(ModelSize &m, double count, double numDirs) {
+    m.vars += (numDirs + 1) * count;
+    m.genConstrs += (numDirs + 1) * count;
+    m.constrs += count;
+    m.nonzeros += (4 * numDirs + 2) * count;
+}
+
+/**
+ * @brief Site coordinate PWL constraints and the blocked-site constraints of a site geometry.
+ *
+ */
+void addGeometry(ModelSize &m, const PlacementProblem &prob, bool oneColumn) {
+    if (!prob.geometry) {
+        return;
+    }
+    const double n = prob.numCells();
+    const int axes = oneColumn ? 1 : 2;
+    m.vars += axes * n;
+    m.genConstrs += axes * n;
+    m.nonzeros += n * (prob.siteSizeY + (oneColumn ? 0 : prob.siteSizeX));
+    const double blockedPairs = n * prob.geometry->numBlocked();
+    addAbs(m, axes * blockedPairs);
+    m.constrs += blockedPairs;
+    m.nonzeros += axes * blockedPairs;
+}
+
+double mega(double v) { return v / 1e6; }
+
+} // namespace
+
+
+void ModelSize::finish() {
+    double bytes = vars * kBytesPerVar + constrs * kBytesPerConstr + genConstrs * kBytesPerGenConstr + nonzeros * kBytesPerNonzero;
+    memoryMB = copies * kSolveFactor * bytes / (1 << 20);
+    buildSeconds = (vars + constrs + genConstrs) * kSecondsPerElement;
+}
+
+void ModelSize::print(const char *prefix) const {
+    printf("%s%s: %.2fM vars, %.2fM constrs, %.2fM general, %.2fM nonzeros", prefix, name.c_str(),
+        mega(vars), mega(constrs), mega(genConstrs), mega(nonzeros));
+    if (copies > 1) {
+        printf(", %d copies", copies);
+    }
+    printf(", ~%.0f MB, ~%.1fs build\n", memoryMB, buildSeconds);
+}
+
+/**
+ * @brief Size of the run2() model (buildModel2()), after the ROC presolve.
+ *
+ * @param prob
+ * @param NOCMode
+ * @return ModelSize
+ */
+ModelSize estimateGeneralModel(const PlacementProblem &prob, int NOCMode) {
+    ModelSize m;
+    m.name = "run2 NOCMode " + std::to_string(NOCMode);
+    const double Y = prob.arraySizeY, X = prob.arraySizeX;
+    const double n = Y * X;
+    const double pairs = n * (n - 1) / 2;
+    const double edges = Y * (X - 1) + X * (Y - 1);
+    // Pairs and array edges on a ROC-ordered axis have linear distances.
+    const double ordX = prob.relativeConstraintX ? Y * X * (X - 1) / 2 : 0;
+    const double ordY = prob.relativeConstraintY ? X * Y * (Y - 1) / 2 : 0;
+    const double ordEdgesX = prob.relativeConstraintX ? Y * (X - 1) : 0;
+    const double ordEdgesY = prob.relativeConstraintY ? X * (Y - 1) : 0;
+
+    m.vars = 2 * n;
+    if (NOCMode == 0) {
+        addAbs(m, 2 * pairs - ordX - ordY);
+        m.constrs += pairs;
+        m.nonzeros += 2 * pairs + ordX + ordY;
+    }
+    else {
+        addAbs(m, 2 * edges - ordEdgesX - ordEdgesY);
+        addIndicatorOr(m, pairs, 4);
+        m.vars -= ordX + ordY;
+        m.genConstrs -= ordX + ordY;
+        m.nonzeros -= 4 * (ordX + ordY);
+    }
+    m.constrs += ordEdgesX + ordEdgesY;
+    m.nonzeros += 2 * (ordEdgesX + ordEdgesY) + 2 * edges;
+    addGeometry(m, prob, false);
+    m.finish();
+    return m;
+}
+
+/**
+ * @brief Size of the one-column run3()/run4() model (buildModel3()), with the pairs the ROC presolve keeps.
+ *
+ * @param prob with strictOrderY set for the ROC.
+ * @param NOCMode
+ * @return ModelSize
+ */
+ModelSize estimateOneColumnModel(const PlacementProblem &prob, int NOCMode) {
+    ModelSize m;
+    m.name = "run3 NOCMode " + std::to_string(NOCMode);
+    const double Y = prob.arraySizeY, X = prob.arraySizeX;
+    const double n = Y * X;
+    const double pairs = prob.strictOrderY ? RocPresolve(prob).numNoOverlapPairs() : n * (n - 1) / 2;
+    const double rocs = prob.strictOrderY ? Y * (X - 1) + X * (Y - 1) : 0;
+
+    m.vars = n;
+    if (NOCMode == 0) {
+        addAbs(m, pairs);
+        m.constrs += pairs;
+        m.nonzeros += pairs;
+    }
+    else {
+        addIndicatorOr(m, pairs, 2);
+    }
+    m.constrs += rocs + 1;
+    m.nonzeros += 2 * rocs + 2 + 2 * (X + Y);
+    addGeometry(m, prob, true);
+    m.finish();
+    return m;
+}
+
+/**
+ * @brief Size of one LNS window sub-MIP (buildWindowModel()), with the cells of the window at the average density.
+ *
+ * @param prob
+ * @param windowRows
+ * @param windowCols
+ * @param NOCMode
+ * @return ModelSize
+ */
+ModelSize estimateWindowModel(const PlacementProblem &prob, int windowRows, int windowCols, int NOCMode) {
+    ModelSize m;
+    m.name = "LNS window " + std::to_string(windowRows) + " x " + std::to_string(windowCols);
+    const double density = (double)prob.numCells() / std::max(1, prob.numFreeSites());
+    const double n = std::min((double)prob.numCells(), std::ceil(density * windowRows * windowCols));
+    const double pairs = n * (n - 1) / 2;
+    // The run2() generation: both axes even in a one-column window, where x is fixed by its bounds.
+    const int axes = 2;
+
+    // Free coordinates, and the constant coordinates of the fixed neighbors (fewer than the free cells).
+    m.vars = 2 * n + 4 * n;
+    if (NOCMode == 1) {
+        addIndicatorOr(m, pairs, 2 * axes);
+    }
+    else {
+        addAbs(m, axes * pairs);
+        m.constrs += pairs;
+        m.nonzeros += axes * pairs;
+    }
+    // Array edges with a free end: at most two per free cell, plus the ROC along them.
+    addAbs(m, axes * 2 * n);
+    m.constrs += 2 * n;
+    m.nonzeros += 4 * n;
+    m.finish();
+    return m;
+}
+
+/**
+ * @brief Physical memory of the machine, the default memory budget of a job.
+ *
+ * @return double MB, 0 if unknown.
+ */
+double physicalMemoryMB() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0) {
+        return 0;
+    }
+    return (double)pages * pageSize / (1 << 20);
+}
@@ -0,0 +1,36 @@
+#ifndef __MODELPLAN_H__
+#define __MODELPLAN_H__
+
+#include "Placement.h"
+#include <string>
+
+
+/**
+ * @brief Predicted size of a Gurobi model, counted from the formulation code without building it.
+ * Memory and build time come from per-element costs measured on the names and attributes the builders set;
+ * memoryMB includes presolve and the search tree (a constant factor over the model itself) and every concurrent copy.
+ *
+ */
+struct ModelSize {
+    std::string     name;
+    double          vars = 0;
+    double          constrs = 0; // Linear constraints.
+    double          genConstrs = 0; // Abs, indicator, OR and PWL general constraints.
+    double          nonzeros = 0;
+    int             copies = 1; // Models alive at the same time (portfolio members, parallel LNS windows).
+    double          memoryMB = 0;
+    double          buildSeconds = 0;
+
+    void    finish();
+    bool    fits(double budgetMB) const { return budgetMB <= 0 || memoryMB <= budgetMB; }
+    void    print(const char *prefix) const;
+};
+
+
+ModelSize   estimateGeneralModel(const PlacementProblem &prob, int NOCMode);
+ModelSize   estimateOneColumnModel(const PlacementProblem &prob, int NOCMode);
+ModelSize   estimateWindowModel(const PlacementProblem &prob, int windowRows, int windowCols, int NOCMode);
+double      physicalMemoryMB();
+
+
+#endif
@@ -0,0 +1,222 @@
+#include "Multilevel.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+
+MultilevelPlacer::MultilevelPlacer(const PlacementProblem &prob, ExactSolver solver)
+    : m_prob(prob), m_solver(solver)
+{}
+
+/**
+ * @brief Run the V-cycle: coarsen, solve the coarsest level exactly, then project and refine back to the original problem.
+ *
+ * @param timeLimit seconds in total; <= 0 for no limit.
+ * @param pl the resulting placement of the original problem.
+ * @return true if a legal placement was found.
+ */
+bool MultilevelPlacer::run(double timeLimit, Placement &pl) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+
+    buildLevels();
+    const int numLevels = m_levels.size();
+    for (int l = 0; l < numLevels; l++) {
+        const PlacementProblem &p = m_levels[l].prob;
+        printf("Multilevel: level %d: %d x %d => %d x %d, weight x = %g, weight y = %g\n",
+            l, p.arraySizeY, p.arraySizeX, p.siteSizeY, p.siteSizeX, p.weightX, p.weightY);
+    }
+
+    // Coarsest level: constructive start, refined, then solved exactly.
+    const PlacementProblem &coarsest = m_levels.back().prob;
+    Placement cur;
+    if (!LocalSearch::initialPlacement(coarsest, cur)) {
+        printf("ERR: Multilevel: no initial placement for the coarsest level.\n");
+        return false;
+    }
+    LocalSearch(coarsest).run(cur, -1);
+
+    double coarsestTime = (timeLimit > 0) ? timeLimit * m_coarsestTimeFraction : -1;
+    Placement exact;
+    if (m_solver && m_solver(coarsest, coarsestTime, &cur, exact) && isPlacementLegal(coarsest, exact)
+        && placementWirelength(coarsest, exact) <= placementWirelength(coarsest, cur)) {
+        cur = exact;
+    }
+    printf("Multilevel: level %d solved, wirelength %.1f (%.2fs)\n", numLevels - 1, placementWirelength(coarsest, cur), elapsed());
+
+    // Uncoarsen: project one level down, repair, refine.
+    for (int l = numLevels - 2; l >= 0; l--) {
+        const PlacementProblem &fine = m_levels[l].prob;
+        Placement finePl;
+        project(m_levels[l], m_levels[l + 1].prob, cur, finePl);
+        if (!isPlacementLegal(fine, finePl) && !LocalSearch::repairRelativeOrder(fine, finePl)) {
+            printf("ERR: Multilevel: projection to level %d is not legal.\n", l);
+            return false;
+        }
+
+        double refineTime = -1;
+        if (timeLimit > 0) {
+            refineTime = std::max(0.0, (timeLimit - elapsed()) / (l + 1));
+        }
+        double wl = LocalSearch(fine).run(finePl, refineTime);
+        printf("Multilevel: level %d refined, wirelength %.1f (%.2fs)\n", l, wl, elapsed());
+        cur = finePl;
+    }
+
+    pl = cur;
+    return isPlacementLegal(m_prob, pl);
+}
+
+/**
+ * @brief The problem the exact solver gets at the coarsest level, without solving anything.
+ *
+ * @return PlacementProblem
+ */
+PlacementProblem MultilevelPlacer::coarsestProblem() {
+    buildLevels();
+    return m_levels.back().prob;
+}
+
+void MultilevelPlacer::buildLevels() {
+    m_levels.clear();
+    Level top;
+    top.prob = m_prob;
+    m_levels.push_back(top);
+
+    while (m_levels.back().prob.numCells() > m_coarsestCells) {
+        Level next;
+        if (!coarsen(m_levels.back().prob, m_levels.back(), next.prob)) {
+            break;
+        }
+        m_levels.push_back(next);
+    }
+}
+
+/**
+ * @brief Coarsen <fine> by one level. The cluster and site block shapes are stored in <level>.
+ * Cluster shape: 2 along every even array dimension. Site block: the cluster shape if the coarse sites suffice,
+ * otherwise the block shape losing the fewest sites. Weights scale with the block, so a coarse unit distance
+ * costs what it costs on the fine sites. A site geometry is coarsened along.
+ *
+ * @param fine
+ * @param level
+ * @param coarse
+ * @return true if the problem could be coarsened.
+ */
+bool MultilevelPlacer::coarsen(const PlacementProblem &fine, Level &level, PlacementProblem &coarse) const {
+    int fy = (fine.arraySizeY % 2 == 0) ? 2 : 1;
+    int fx = (fine.arraySizeX % 2 == 0) ? 2 : 1;
+    int k = fy * fx;
+    if (k == 1) {
+        return false;
+    }
+    int coarseCells = (fine.arraySizeY / fy) * (fine.arraySizeX / fx);
+
+    int bestBy = 0, bestBx = 0, bestSites = -1;
+    for (int bx = 1; bx <= k; bx++) {
+        if (k % bx != 0) {
+            continue;
+        }
+        int by = k / bx;
+        int sites = (fine.siteSizeY / by) * (fine.siteSizeX / bx);
+        if (sites < coarseCells) {
+            continue;
+        }
+        if (by == fy && bx == fx) {
+            bestBy = by;
+            bestBx = bx;
+            bestSites = sites;
+            break;
+        }
+        if (sites > bestSites) {
+            bestBy = by;
+            bestBx = bx;
+            bestSites = sites;
+        }
+    }
+    if (bestSites < 0) {
+        return false;
+    }
+
+    level.fy = fy;
+    level.fx = fx;
+    level.by = bestBy;
+    level.bx = bestBx;
+
+    coarse = fine;
+    coarse.arraySizeY = fine.arraySizeY / fy;
+    coarse.arraySizeX = fine.arraySizeX / fx;
+    coarse.siteSizeY = fine.siteSizeY / bestBy;
+    coarse.siteSizeX = fine.siteSizeX / bestBx;
+    coarse.weightY = fine.weightY * bestBy;
+    coarse.weightX = fine.weightX * bestBx;
+
+    if (fine.geometry) {
+        // A super-site sits at the first site of its block, its coordinates scaled down by the block like the weights
+        // are scaled up. It is blocked if any site of its block is, so projections never land on a blocked site.
+        const SiteGeometry &g = *fine.geometry;
+        std::vector<double> coordY(coarse.siteSizeY), coordX(coarse.siteSizeX);
+        for (int sy = 0; sy < coarse.siteSizeY; sy++) {
+            coordY[sy] = g.coordY(sy * bestBy) / bestBy;
+        }
+        for (int sx = 0; sx < coarse.siteSizeX; sx++) {
+            coordX[sx] = g.coordX(sx * bestBx) / bestBx;
+        }
+        std::vector<char> blocked(coarse.numSites(), 0);
+        for (int sy = 0; sy < coarse.siteSizeY * bestBy; sy++) {
+            for (int sx = 0; sx < coarse.siteSizeX * bestBx; sx++) {
+                if (g.blocked(sy, sx)) {
+                    blocked[coarse.siteId(sy / bestBy, sx / bestBx)] = 1;
+                }
+            }
+        }
+        coarse.geometry = std::make_shared<SiteGeometry>(coordY, coordX, blocked);
+        if (coarse.numFreeSites() < coarseCells) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Expand every super-cell of <coarsePl> into its cluster on the super-site's block.
+ * With matching shapes cluster cell (a, b) takes block site (a, b); otherwise the cluster fills the block row-major,
+ * which keeps the one-column ROC since (0,0) < (0,1) < (1,0) < (1,1).
+ *
+ * @param level
+ * @param coarse
+ * @param coarsePl
+ * @param finePl
+ */
+void MultilevelPlacer::project(const Level &level, const PlacementProblem &coarse, const Placement &coarsePl, Placement &finePl) const {
+    const PlacementProblem &fine = level.prob;
+    finePl.resize(fine);
+    bool shapeMatch = (level.by == level.fy && level.bx == level.fx);
+
+    for (int I = 0; I < coarse.arraySizeY; I++) {
+        for (int J = 0; J < coarse.arraySizeX; J++) {
+            int C = coarse.cellId(I, J);
+            for (int a = 0; a < level.fy; a++) {
+                for (int b = 0; b < level.fx; b++) {
+                    int r, q;
+                    if (shapeMatch) {
+                        r = a;
+                        q = b;
+                    }
+                    else {
+                        int t = a * level.fx + b;
+                        r = t / level.bx;
+                        q = t % level.bx;
+                    }
+                    int c = fine.cellId(I * level.fy + a, J * level.fx + b);
+                    finePl.y(c) = coarsePl.y(C) * level.by + r;
+                    finePl.x(c) = coarsePl.x(C) * level.bx + q;
+                }
+            }
+        }
+    }
+}
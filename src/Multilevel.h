@@ -0,0 +1,50 @@
+#ifndef __MULTILEVEL_H__
+#define __MULTILEVEL_H__
+
+#include "Placement.h"
+#include <functional>
+#include <vector>
+
+
+/**
+ * @brief Multilevel coarsen-solve-refine V-cycle.
+ * Each level merges fy x fx clusters of cells (2x2, or 2x1/1x2 when one array dimension is odd) into super-cells,
+ * placed on a site grid coarsened by blocks of by x bx sites (by * bx == fy * fx).
+ * Since the coarse array is again a grid, the coarsest level is solved by the existing exact formulations.
+ * The result is projected back level by level and refined with LocalSearch.
+ *
+ */
+class MultilevelPlacer
+{
+public:
+    // Exact solver of one level: (problem, time limit, start or nullptr, result) -> success.
+    typedef std::function<bool(const PlacementProblem &, double, const Placement *, Placement &)> ExactSolver;
+
+    MultilevelPlacer(const PlacementProblem &prob, ExactSolver solver);
+
+    void    setCoarsestCells(int numCells) { m_coarsestCells = numCells; }
+    void    setCoarsestTimeFraction(double fraction) { m_coarsestTimeFraction = fraction; }
+
+    bool    run(double timeLimit, Placement &pl);
+    PlacementProblem coarsestProblem();
+
+private:
+    struct Level {
+        PlacementProblem    prob;
+        int                 fy = 1, fx = 1; // Cluster shape merged into one super-cell of the next level.
+        int                 by = 1, bx = 1; // Site block of one super-site of the next level.
+    };
+
+    void    buildLevels();
+    bool    coarsen(const PlacementProblem &fine, Level &level, PlacementProblem &coarse) const;
+    void    project(const Level &level, const PlacementProblem &coarse, const Placement &coarsePl, Placement &finePl) const;
+
+    PlacementProblem    m_prob;
+    ExactSolver         m_solver;
+    std::vector<Level>  m_levels; // m_levels[0] is the original problem.
+    int                 m_coarsestCells = 64;
+    double              m_coarsestTimeFraction = 0.5;
+};
+
+
+#endif
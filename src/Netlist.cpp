@@ -0,0 +1,270 @@
+#include "Netlist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+// A token of the mapped file.
+struct Token {
+    const char *p;
+    int len;
+
+    bool is(const char *s) const { return (int)strlen(s) == len && memcmp(p, s, len) == 0; }
+    bool startsWith(const char *s) const { int n = strlen(s); return n <= len && memcmp(p, s, n) == 0; }
+};
+
+struct TokenHash {
+    size_t operator()(const Token &t) const {
+        size_t h = 1469598103934665603ull;
+        for (int k = 0; k < t.len; k++) {
+            h = (h ^ (unsigned char)t.p[k]) * 1099511628211ull;
+        }
+        return h;
+    }
+};
+
+struct TokenEqual {
+    bool operator()(const Token &a, const Token &b) const { return a.len == b.len && memcmp(a.p, b.p, a.len) == 0; }
+};
+
+/**
+ * @brief Non-negative integer value of <t>, -1 if it is not one.
+ *
+ */
+int toInt(const Token &t) {
+    if (t.len == 0 || t.len > 9) {
+        return -1;
+    }
+    int v = 0;
+    for (int k = 0; k < t.len; k++) {
+        if (t.p[k] < '0' || t.p[k] > '9') {
+            return -1;
+        }
+        v = 10 * v + (t.p[k] - '0');
+    }
+    return v;
+}
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+} // namespace
+
+
+/**
+ * @brief Read the netlist <fileName> (see the class comment for the format).
+ *
+ * @param fileName
+ * @return true if the file was read and has a PE array and layout size.
+ */
+bool Netlist::read(const std::string &fileName) {
+    auto start = std::chrono::steady_clock::now();
+    m_fileName = fileName;
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("ERR: Read file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("ERR: Read file [%s] failed!\n", fileName.c_str());
+        close(fd);
+        return false;
+    }
+    bool ok = true;
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            printf("ERR: Mapping file [%s] failed!\n", fileName.c_str());
+            close(fd);
+            return false;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        const char *begin = (const char *)data;
+        ok = parse(begin, begin + st.st_size);
+        munmap(data, st.st_size);
+    }
+    close(fd);
+    ok = ok && finish();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("Netlist <%s>: %lld lines, %d x %d PE array on %d x %d layout, %d DSPs, %lld nets, %lld DSP connections (%lld between array neighbors), read in %.3fs\n",
+        fileName.c_str(), m_numLines, m_rowsOfPeArray, m_colsOfPeArray, m_rowsOfPeLayout, m_colsOfPeLayout, numDsps(), m_numNets,
+        m_numConnections, m_numNeighborConnections, elapsed.count());
+    return ok;
+}
+
+/**
+ * @brief One pass over the file contents [begin, end): sizes, DSP nodes and the DSP edges of the nets.
+ *
+ * @param begin
+ * @param end
+ * @return true if no line was malformed.
+ */
+bool Netlist::parse(const char *begin, const char *end) {
+    std::unordered_map<Token, int, TokenHash, TokenEqual> dspIds; // Keys point into the mapped file.
+    std::vector<Token> tokens;
+    std::vector<int> pins;
+    bool ok = true;
+
+    const char *p = begin;
+    while (p < end) {
+        m_numLines++;
+        tokens.clear();
+        while (p < end && *p != '\n') {
+            while (p < end && isBlank(*p)) {
+                p++;
+            }
+            if (p == end || *p == '\n' || *p == '#') {
+                break;
+            }
+            const char *b = p;
+            while (p < end && !isBlank(*p) && *p != '\n') {
+                p++;
+            }
+            tokens.push_back(Token{b, (int)(p - b)});
+        }
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        p = eol ? eol + 1 : end;
+
+        if (tokens.empty()) {
+            continue;
+        }
+        const Token &key = tokens[0];
+        if (key.is("array") || key.is("layout")) {
+            int rows = (tokens.size() >= 3) ? toInt(tokens[1]) : -1;
+            int cols = (tokens.size() >= 3) ? toInt(tokens[2]) : -1;
+            if (rows <= 0 || cols <= 0) {
+                printf("ERR: Netlist <%s> line %lld: bad %.*s size.\n", m_fileName.c_str(), m_numLines, key.len, key.p);
+                ok = false;
+            }
+            else if (key.is("array")) {
+                m_rowsOfPeArray = rows;
+                m_colsOfPeArray = cols;
+            }
+            else {
+                m_rowsOfPeLayout = rows;
+                m_colsOfPeLayout = cols;
+            }
+        }
+        else if (key.is("node")) {
+            if (tokens.size() < 3 || !tokens[2].startsWith("DSP")) {
+                continue;
+            }
+            int row = (tokens.size() >= 5) ? toInt(tokens[3]) : -1;
+            int col = (tokens.size() >= 5) ? toInt(tokens[4]) : -1;
+            if (row < 0 || col < 0) {
+                printf("ERR: Netlist <%s> line %lld: DSP <%.*s> has no array position.\n", m_fileName.c_str(), m_numLines, tokens[1].len, tokens[1].p);
+                ok = false;
+                continue;
+            }
+            if (!dspIds.emplace(tokens[1], (int)m_dspNames.size()).second) {
+                printf("ERR: Netlist <%s> line %lld: DSP <%.*s> defined twice.\n", m_fileName.c_str(), m_numLines, tokens[1].len, tokens[1].p);
+                ok = false;
+                continue;
+            }
+            m_dspNames.emplace_back(tokens[1].p, tokens[1].len);
+            m_dspRow.push_back(row);
+            m_dspCol.push_back(col);
+        }
+        else if (key.is("net")) {
+            m_numNets++;
+            pins.clear();
+            for (size_t k = 2; k < tokens.size(); k++) {
+                auto it = dspIds.find(tokens[k]);
+                if (it != dspIds.end()) {
+                    pins.push_back(it->second);
+                }
+            }
+            for (size_t k = 1; k < pins.size(); k++) {
+                m_edges.emplace_back(pins[0], pins[k]);
+            }
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Place the DSPs into the array and count the connections per cell pair.
+ *
+ * @return true if the sizes are known and every DSP is inside the array, on its own position.
+ */
+bool Netlist::finish() {
+    if (m_rowsOfPeArray <= 0 || m_rowsOfPeLayout <= 0) {
+        printf("ERR: Netlist <%s> has no array or layout size.\n", m_fileName.c_str());
+        return false;
+    }
+    bool ok = true;
+    m_dspIdArray.assign(m_rowsOfPeArray * m_colsOfPeArray, -1);
+    for (int id = 0; id < numDsps(); id++) {
+        if (m_dspRow[id] >= m_rowsOfPeArray || m_dspCol[id] >= m_colsOfPeArray) {
+            printf("ERR: Netlist <%s>: DSP <%s> at (%d, %d) is outside the %d x %d array.\n", m_fileName.c_str(),
+                m_dspNames[id].c_str(), m_dspRow[id], m_dspCol[id], m_rowsOfPeArray, m_colsOfPeArray);
+            ok = false;
+            continue;
+        }
+        int &cell = m_dspIdArray[m_dspRow[id] * m_colsOfPeArray + m_dspCol[id]];
+        if (cell >= 0) {
+            printf("ERR: Netlist <%s>: DSPs <%s> and <%s> share array position (%d, %d).\n", m_fileName.c_str(),
+                m_dspNames[cell].c_str(), m_dspNames[id].c_str(), m_dspRow[id], m_dspCol[id]);
+            ok = false;
+            continue;
+        }
+        cell = id;
+    }
+
+    m_flow.clear();
+    m_numConnections = m_numNeighborConnections = 0;
+    for (const std::pair<int, int> &e: m_edges) {
+        const int r0 = m_dspRow[e.first], c0 = m_dspCol[e.first], r1 = m_dspRow[e.second], c1 = m_dspCol[e.second];
+        if (e.first == e.second || r0 >= m_rowsOfPeArray || c0 >= m_colsOfPeArray || r1 >= m_rowsOfPeArray || c1 >= m_colsOfPeArray) {
+            continue;
+        }
+        m_flow[pairKey(r0 * m_colsOfPeArray + c0, r1 * m_colsOfPeArray + c1)]++;
+        m_numConnections++;
+        m_numNeighborConnections += (std::abs(r0 - r1) + std::abs(c0 - c1) == 1);
+    }
+    return ok;
+}
+
+unsigned long long Netlist::pairKey(int c0, int c1) {
+    if (c0 > c1) {
+        std::swap(c0, c1);
+    }
+    return ((unsigned long long)c0 << 32) | (unsigned)c1;
+}
+
+int Netlist::flow(int c0, int c1) const {
+    auto it = m_flow.find(pairKey(c0, c1));
+    return (it == m_flow.end()) ? 0 : it->second;
+}
+
+/**
+ * @brief Average connections between vertically (or horizontally) adjacent array cells.
+ *
+ * @param vertical
+ * @return double
+ */
+double Netlist::averageFlow(bool vertical) const {
+    long long sum = 0, pairs = 0;
+    for (int i = 0; i < m_rowsOfPeArray; i++) {
+        for (int j = 0; j < m_colsOfPeArray; j++) {
+            const int i1 = vertical ? i + 1 : i, j1 = vertical ? j : j + 1;
+            if (i1 < m_rowsOfPeArray && j1 < m_colsOfPeArray) {
+                sum += flow(i * m_colsOfPeArray + j, i1 * m_colsOfPeArray + j1);
+                pairs++;
+            }
+        }
+    }
+    return (pairs > 0) ? (double)sum / pairs : 0;
+}
@@ -0,0 +1,68 @@
+#ifndef __NETLIST_H__
+#define __NETLIST_H__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief The part of a design.rglr netlist the placer needs: the PE array and layout sizes, the DSP at every array
+ * position and the connections between DSPs. Lines are whitespace-separated, '#' starts a comment, other keywords
+ * are skipped:
+ *   array  <rowsOfPeArray> <colsOfPeArray>
+ *   layout <rowsOfPeLayout> <colsOfPeLayout>
+ *   node   <name> <type> [<rowIdx> <colIdx>]     a DSP (type DSP*) has its array position
+ *   net    <name> <node> <node> ...              the first node drives the others
+ * Nodes come before the nets that use them; net pins that are not DSPs are ignored. The file is mapped and tokenized
+ * in one pass without per-token allocation; only DSP names are stored.
+ *
+ */
+class Netlist
+{
+public:
+    bool    read(const std::string &fileName);
+
+    int     rowsOfPeArray() const { return m_rowsOfPeArray; }
+    int     colsOfPeArray() const { return m_colsOfPeArray; }
+    int     rowsOfPeLayout() const { return m_rowsOfPeLayout; }
+    int     colsOfPeLayout() const { return m_colsOfPeLayout; }
+
+    int     numDsps() const { return m_dspNames.size(); }
+    const std::string & dspName(int id) const { return m_dspNames[id]; }
+    // DSP id at array position (row, col), -1 if none.
+    int     dspId(int row, int col) const { return m_dspIdArray[row * m_colsOfPeArray + col]; }
+    const std::vector<int> & dspIdArray() const { return m_dspIdArray; }
+
+    // Connections between the DSPs at array cells c0 and c1 (cell id row * colsOfPeArray + col).
+    int     flow(int c0, int c1) const;
+    long long numConnections() const { return m_numConnections; }
+    long long numNeighborConnections() const { return m_numNeighborConnections; }
+    double  averageFlow(bool vertical) const;
+
+private:
+    bool    parse(const char *begin, const char *end);
+    bool    finish();
+
+    static unsigned long long pairKey(int c0, int c1);
+
+    std::string         m_fileName;
+    int                 m_rowsOfPeArray = 0;
+    int                 m_colsOfPeArray = 0;
+    int                 m_rowsOfPeLayout = 0;
+    int                 m_colsOfPeLayout = 0;
+
+    std::vector<std::string>    m_dspNames;
+    std::vector<int>            m_dspRow, m_dspCol;
+    std::vector<int>            m_dspIdArray;
+    // Driver / sink DSP ids of every DSP connection, as read.
+    std::vector<std::pair<int, int>>                m_edges;
+    std::unordered_map<unsigned long long, int>     m_flow; // Cell pair -> connections.
+    long long           m_numConnections = 0;
+    long long           m_numNeighborConnections = 0;
+    long long           m_numLines = 0;
+    long long           m_numNets = 0;
+};
+
+
+#endif
@@ -0,0 +1,343 @@
+#include "Placement.h"
+#include "util.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+
+SiteGeometry::SiteGeometry(const std::vector<double> &coordY, const std::vector<double> &coordX, const std::vector<char> &blocked)
+    : m_coordY(coordY), m_coordX(coordX), m_blocked(blocked)
+{
+    const int ny = sizeY(), nx = sizeX();
+    m_distY.resize(ny * ny);
+    for (int a = 0; a < ny; a++) {
+        for (int b = 0; b < ny; b++) {
+            m_distY[a * ny + b] = std::fabs(m_coordY[a] - m_coordY[b]);
+        }
+    }
+    m_distX.resize(nx * nx);
+    for (int a = 0; a < nx; a++) {
+        for (int b = 0; b < nx; b++) {
+            m_distX[a * nx + b] = std::fabs(m_coordX[a] - m_coordX[b]);
+        }
+    }
+    m_blocked.resize(ny * nx, 0);
+    for (char b: m_blocked) {
+        m_numBlocked += (b != 0);
+    }
+}
+
+void Placement::resize(const PlacementProblem &prob) {
+    m_x.assign(prob.numCells(), 0);
+    m_y.assign(prob.numCells(), 0);
+}
+
+/**
+ * @brief Weighted Manhattan wirelength over all array-neighbor pairs, i.e. the objective of run2().
+ *
+ * @param prob
+ * @param pl
+ * @return double
+ */
+double placementWirelength(const PlacementProblem &prob, const Placement &pl) {
+    double wl = 0;
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c0 = prob.cellId(i, j);
+            // top neighbor.
+            if (i + 1 < prob.arraySizeY) {
+                int c1 = prob.cellId(i + 1, j);
+                wl += prob.weightX * prob.distX(pl.x(c0), pl.x(c1)) + prob.weightY * prob.distY(pl.y(c0), pl.y(c1));
+            }
+            // right neighbor.
+            if (j + 1 < prob.arraySizeX) {
+                int c1 = prob.cellId(i, j + 1);
+                wl += prob.weightX * prob.distX(pl.x(c0), pl.x(c1)) + prob.weightY * prob.distY(pl.y(c0), pl.y(c1));
+            }
+        }
+    }
+    return wl;
+}
+
+/**
+ * @brief Check that every cell is on a site that is not blocked, no two cells overlap, and (optionally) the relative ordering constraints hold.
+ *
+ * @param prob
+ * @param pl
+ * @param checkRelativeConstraint
+ * @return true
+ * @return false
+ */
+bool isPlacementLegal(const PlacementProblem &prob, const Placement &pl, bool checkRelativeConstraint) {
+    if (pl.numCells() != prob.numCells()) {
+        return false;
+    }
+
+    std::vector<char> used(prob.numSites(), 0);
+    for (int c = 0; c < prob.numCells(); c++) {
+        if (pl.x(c) < 0 || pl.x(c) >= prob.siteSizeX || pl.y(c) < 0 || pl.y(c) >= prob.siteSizeY) {
+            return false;
+        }
+        int s = prob.siteId(pl.y(c), pl.x(c));
+        if (used[s] || prob.isSiteBlocked(pl.y(c), pl.x(c))) {
+            return false;
+        }
+        used[s] = 1;
+    }
+
+    if (!checkRelativeConstraint) {
+        return true;
+    }
+
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c0 = prob.cellId(i, j);
+            if (j + 1 < prob.arraySizeX) {
+                int c1 = prob.cellId(i, j + 1);
+                if (prob.relativeConstraintX && pl.x(c0) > pl.x(c1)) {
+                    return false;
+                }
+                if (prob.strictOrderY && pl.y(c0) >= pl.y(c1)) {
+                    return false;
+                }
+            }
+            if (i + 1 < prob.arraySizeY) {
+                int c1 = prob.cellId(i + 1, j);
+                if (prob.relativeConstraintY && pl.y(c0) > pl.y(c1)) {
+                    return false;
+                }
+                if (prob.strictOrderY && pl.y(c0) >= pl.y(c1)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Parse one line of a .sol file, either "X i j value" or "X_i_j value" (same for Y).
+ *
+ * @return true if the line is a coordinate; comments and other variables return false.
+ */
+static bool parseSolLine(const std::vector<std::string> &tokens, char &axis, int &i, int &j, int &value) {
+    if (tokens[0][0] == '#') {
+        return false;
+    }
+    double v = 0;
+    if (tokens.size() == 4 && (tokens[0] == "X" || tokens[0] == "Y")) {
+        axis = tokens[0][0];
+        i = std::stoi(tokens[1]);
+        j = std::stoi(tokens[2]);
+        v = std::stod(tokens[3]);
+    }
+    else if (tokens.size() == 2 && sscanf(tokens[0].c_str(), "X_%d_%d", &i, &j) == 2) {
+        axis = 'X';
+        v = std::stod(tokens[1]);
+    }
+    else if (tokens.size() == 2 && sscanf(tokens[0].c_str(), "Y_%d_%d", &i, &j) == 2) {
+        axis = 'Y';
+        v = std::stod(tokens[1]);
+    }
+    else {
+        return false;
+    }
+    value = (int)std::lround(v);
+    return true;
+}
+
+/**
+ * @brief Read a placement from a solution file. Both the initial solution format ("X i j value")
+ * and the Gurobi .sol format ("X_i_j value") are accepted; other variables are ignored.
+ * Cells missing in the file keep coordinate 0, which is what one-column solutions (without X) need.
+ *
+ * @param fileName
+ * @param prob
+ * @param pl
+ * @return true if the file could be read.
+ */
+bool readPlacementFromSol(const std::string &fileName, const PlacementProblem &prob, Placement &pl) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) {
+        printf("ERR: Read file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+
+    pl.resize(prob);
+    std::vector<std::string> tokens;
+    while (read_line_as_tokens(file, tokens)) {
+        char axis;
+        int i, j, value;
+        if (!parseSolLine(tokens, axis, i, j, value)) {
+            continue;
+        }
+        if (i < 0 || i >= prob.arraySizeY || j < 0 || j >= prob.arraySizeX) {
+            continue;
+        }
+        if (axis == 'X') {
+            pl.x(prob.cellId(i, j)) = value;
+        }
+        else {
+            pl.y(prob.cellId(i, j)) = value;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Read a .sol file without knowing the problem: the array size is taken from the largest cell indices and
+ * the site size from the largest coordinates, or from the file name when it has the "macroPl_<arraySizeY>_<arraySizeX>
+ * _to_<siteSizeY>_<siteSizeX>" form of MacroPlacer and agrees with the data (sites may be left empty at the far end).
+ * Weights and relative constraints of <prob> are left unchanged.
+ *
+ * @param fileName
+ * @param prob array and site sizes are set from the data.
+ * @param pl
+ * @return true if the file could be read and holds at least one cell.
+ */
+bool readPlacementShapeFromSol(const std::string &fileName, PlacementProblem &prob, Placement &pl) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) {
+        printf("ERR: Read file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+
+    struct Entry { char axis; int i, j, value; };
+    std::vector<Entry> entries;
+    int maxI = -1, maxJ = -1, maxX = 0, maxY = 0;
+    std::vector<std::string> tokens;
+    while (read_line_as_tokens(file, tokens)) {
+        Entry e;
+        if (!parseSolLine(tokens, e.axis, e.i, e.j, e.value) || e.i < 0 || e.j < 0) {
+            continue;
+        }
+        entries.push_back(e);
+        maxI = std::max(maxI, e.i);
+        maxJ = std::max(maxJ, e.j);
+        if (e.axis == 'X') {
+            maxX = std::max(maxX, e.value);
+        }
+        else {
+            maxY = std::max(maxY, e.value);
+        }
+    }
+    if (maxI < 0) {
+        printf("ERR: No placement in file [%s].\n", fileName.c_str());
+        return false;
+    }
+
+    prob.arraySizeY = maxI + 1;
+    prob.arraySizeX = maxJ + 1;
+    prob.siteSizeY = maxY + 1;
+    prob.siteSizeX = maxX + 1;
+    int nameY, nameX, nameSiteY, nameSiteX;
+    size_t pos = fileName.find("macroPl_");
+    if (pos != std::string::npos
+        && sscanf(fileName.c_str() + pos, "macroPl_%d_%d_to_%d_%d", &nameY, &nameX, &nameSiteY, &nameSiteX) == 4
+        && nameY == prob.arraySizeY && nameX == prob.arraySizeX && nameSiteY >= prob.siteSizeY && nameSiteX >= prob.siteSizeX) {
+        prob.siteSizeY = nameSiteY;
+        prob.siteSizeX = nameSiteX;
+    }
+    pl.resize(prob);
+    for (const Entry &e: entries) {
+        if (e.axis == 'X') {
+            pl.x(prob.cellId(e.i, e.j)) = e.value;
+        }
+        else {
+            pl.y(prob.cellId(e.i, e.j)) = e.value;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Read a site geometry file:
+ *   rows <coordinate of site row 0> ... <row siteSizeY-1>
+ *   cols <coordinate of site column 0> ... <column siteSizeX-1>
+ *   blocked <sy> <sx>      (any number of lines)
+ * Missing rows/cols lines mean unit spacing on that axis. Coordinates must increase strictly.
+ *
+ * @param fileName
+ * @param siteSizeY
+ * @param siteSizeX
+ * @param geometry
+ * @return true if the file could be read and matches the site size.
+ */
+bool readSiteGeometry(const std::string &fileName, int siteSizeY, int siteSizeX, std::shared_ptr<const SiteGeometry> &geometry) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) {
+        printf("ERR: Read file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+
+    std::vector<double> coordY(siteSizeY), coordX(siteSizeX);
+    for (int k = 0; k < siteSizeY; k++) {
+        coordY[k] = k;
+    }
+    for (int k = 0; k < siteSizeX; k++) {
+        coordX[k] = k;
+    }
+    std::vector<char> blocked(siteSizeY * siteSizeX, 0);
+
+    std::vector<std::string> tokens;
+    while (read_line_as_tokens(file, tokens)) {
+        if (tokens[0][0] == '#') {
+            continue;
+        }
+        if (tokens[0] == "rows" || tokens[0] == "cols") {
+            std::vector<double> &coord = (tokens[0] == "rows") ? coordY : coordX;
+            if (tokens.size() != coord.size() + 1) {
+                printf("ERR: %s: %d %s coordinates for %d sites.\n", fileName.c_str(), (int)tokens.size() - 1, tokens[0].c_str(), (int)coord.size());
+                return false;
+            }
+            for (size_t k = 0; k < coord.size(); k++) {
+                coord[k] = std::stod(tokens[k + 1]);
+                if (k > 0 && coord[k] <= coord[k - 1]) {
+                    printf("ERR: %s: %s coordinates must increase.\n", fileName.c_str(), tokens[0].c_str());
+                    return false;
+                }
+            }
+        }
+        else if (tokens[0] == "blocked" && tokens.size() == 3) {
+            int sy = std::stoi(tokens[1]), sx = std::stoi(tokens[2]);
+            if (sy < 0 || sy >= siteSizeY || sx < 0 || sx >= siteSizeX) {
+                printf("ERR: %s: blocked site (%d, %d) out of range.\n", fileName.c_str(), sy, sx);
+                return false;
+            }
+            blocked[sy * siteSizeX + sx] = 1;
+        }
+        else {
+            printf("ERR: %s: unexpected line <%s>.\n", fileName.c_str(), tokens[0].c_str());
+            return false;
+        }
+    }
+
+    geometry = std::make_shared<SiteGeometry>(coordY, coordX, blocked);
+    return true;
+}
+
+/**
+ * @brief Write a placement in the same layout as the Gurobi .sol files, so output/plotFromSol.py can read it.
+ *
+ * @param fileName
+ * @param prob
+ * @param pl
+ * @return true if the file could be written.
+ */
+bool writePlacementToSol(const std::string &fileName, const PlacementProblem &prob, const Placement &pl) {
+    FILE *fp = fopen(fileName.c_str(), "w");
+    if (!fp) {
+        printf("ERR: Write file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+    fprintf(fp, "# Objective value = %.10g\n", placementWirelength(prob, pl));
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c = prob.cellId(i, j);
+            fprintf(fp, "X_%d_%d %d\n", i, j, pl.x(c));
+            fprintf(fp, "Y_%d_%d %d\n", i, j, pl.y(c));
+        }
+    }
+    fclose(fp);
+    return true;
+}
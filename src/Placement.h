@@ -0,0 +1,108 @@
+#ifndef __PLACEMENT_H__
+#define __PLACEMENT_H__
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Physical site geometry: the coordinate of every site row and column (non-uniform spacing allowed) and
+ * blocked sites. Distances are precomputed per axis, so a distance costs one table lookup like a unit-spaced one.
+ *
+ */
+class SiteGeometry
+{
+public:
+    SiteGeometry(const std::vector<double> &coordY, const std::vector<double> &coordX, const std::vector<char> &blocked);
+
+    int     sizeY() const { return m_coordY.size(); }
+    int     sizeX() const { return m_coordX.size(); }
+    double  coordY(int sy) const { return m_coordY[sy]; }
+    double  coordX(int sx) const { return m_coordX[sx]; }
+    double  distY(int sy0, int sy1) const { return m_distY[sy0 * sizeY() + sy1]; }
+    double  distX(int sx0, int sx1) const { return m_distX[sx0 * sizeX() + sx1]; }
+    bool    blocked(int sy, int sx) const { return m_blocked[sy * sizeX() + sx]; }
+    int     numBlocked() const { return m_numBlocked; }
+
+    const std::vector<double> & coordsY() const { return m_coordY; }
+    const std::vector<double> & coordsX() const { return m_coordX; }
+
+private:
+    std::vector<double> m_coordY;
+    std::vector<double> m_coordX;
+    std::vector<double> m_distY; // |coordY[a] - coordY[b]| at a * sizeY() + b.
+    std::vector<double> m_distX;
+    std::vector<char>   m_blocked; // By site id.
+    int                 m_numBlocked = 0;
+};
+
+
+/**
+ * @brief Parameters of one placement problem: an arraySizeY x arraySizeX PE array mapped onto
+ * siteSizeY x siteSizeX sites, with weighted Manhattan wirelength between array neighbors.
+ *
+ */
+struct PlacementProblem {
+    int             arraySizeY = 0;
+    int             arraySizeX = 0;
+    int             siteSizeY = 0;
+    int             siteSizeX = 0;
+    double          weightX = 1;
+    double          weightY = 1;
+    bool            relativeConstraintX = false;
+    bool            relativeConstraintY = false;
+    // ROC as formulated by run3()/run4() for one column: y strictly increases along rows and columns.
+    bool            strictOrderY = false;
+    // Physical site geometry; null: unit-spaced sites, none blocked. Shared, since the distance tables can be large.
+    std::shared_ptr<const SiteGeometry> geometry;
+
+    int     numCells() const { return arraySizeY * arraySizeX; }
+    int     numSites() const { return siteSizeY * siteSizeX; }
+    int     cellId(int i, int j) const { return i * arraySizeX + j; }
+    int     siteId(int sy, int sx) const { return sy * siteSizeX + sx; }
+    double  distY(int sy0, int sy1) const { return geometry ? geometry->distY(sy0, sy1) : abs(sy0 - sy1); }
+    double  distX(int sx0, int sx1) const { return geometry ? geometry->distX(sx0, sx1) : abs(sx0 - sx1); }
+    bool    isSiteBlocked(int sy, int sx) const { return geometry && geometry->blocked(sy, sx); }
+    int     numFreeSites() const { return numSites() - (geometry ? geometry->numBlocked() : 0); }
+};
+
+
+/**
+ * @brief Site assignment of every cell in the PE array. Cell (i, j) is stored at index i * arraySizeX + j.
+ *
+ */
+class Placement
+{
+public:
+    Placement() {}
+    explicit Placement(const PlacementProblem &prob) { resize(prob); }
+
+    void    resize(const PlacementProblem &prob);
+    bool    empty() const { return m_x.empty(); }
+    int     numCells() const { return m_x.size(); }
+
+    int &   x(int cell) { return m_x[cell]; }
+    int &   y(int cell) { return m_y[cell]; }
+    int     x(int cell) const { return m_x[cell]; }
+    int     y(int cell) const { return m_y[cell]; }
+
+    const std::vector<int> & xs() const { return m_x; }
+    const std::vector<int> & ys() const { return m_y; }
+
+private:
+    std::vector<int> m_x;
+    std::vector<int> m_y;
+};
+
+
+double  placementWirelength(const PlacementProblem &prob, const Placement &pl);
+bool    isPlacementLegal(const PlacementProblem &prob, const Placement &pl, bool checkRelativeConstraint = true);
+bool    readPlacementFromSol(const std::string &fileName, const PlacementProblem &prob, Placement &pl);
+bool    readPlacementShapeFromSol(const std::string &fileName, PlacementProblem &prob, Placement &pl);
+bool    readSiteGeometry(const std::string &fileName, int siteSizeY, int siteSizeX, std::shared_ptr<const SiteGeometry> &geometry);
+bool    writePlacementToSol(const std::string &fileName, const PlacementProblem &prob, const Placement &pl);
+
+
+#endif
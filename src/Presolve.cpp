@@ -0,0 +1,90 @@
+#include "Presolve.h"
+#include <cstdio>
+
+
+RocPresolve::RocPresolve(const PlacementProblem &prob)
+    : m_prob(prob)
+{
+    const int numCells = prob.numCells();
+    m_lowerY.assign(numCells, 0);
+    m_upperY.assign(numCells, prob.siteSizeY - 1);
+
+    const bool strict = prob.strictOrderY && prob.siteSizeX == 1;
+    if (strict) {
+        std::vector<int> freeRows;
+        for (int sy = 0; sy < prob.siteSizeY; sy++) {
+            if (!prob.isSiteBlocked(sy, 0)) {
+                freeRows.push_back(sy);
+            }
+        }
+        const int numFree = freeRows.size();
+        for (int i = 0; i < prob.arraySizeY; i++) {
+            for (int j = 0; j < prob.arraySizeX; j++) {
+                int numPred = (i + 1) * (j + 1) - 1;
+                int numSucc = (prob.arraySizeY - i) * (prob.arraySizeX - j) - 1;
+                int c = prob.cellId(i, j);
+                if (numPred >= numFree || numSucc >= numFree || numPred > numFree - 1 - numSucc) {
+                    m_feasible = false;
+                    continue;
+                }
+                m_lowerY[c] = freeRows[numPred];
+                m_upperY[c] = freeRows[numFree - 1 - numSucc];
+            }
+        }
+    }
+
+    // Same pair enumeration as the formulations: cell 1 in a later row, or later in the same row.
+    for (int i0 = 0; i0 < prob.arraySizeY; i0++) {
+        for (int j0 = 0; j0 < prob.arraySizeX; j0++) {
+            for (int i1 = i0; i1 < prob.arraySizeY; i1++) {
+                for (int j1 = (i1 == i0) ? j0 + 1 : 0; j1 < prob.arraySizeX; j1++) {
+                    m_numPairs++;
+                    m_numNoOverlapPairs += needsNoOverlap(i0, j0, i1, j1);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Whether the pair still needs a no-overlap constraint (cell 0 before cell 1 in the formulations' pair order).
+ *
+ */
+bool RocPresolve::needsNoOverlap(int i0, int j0, int i1, int j1) const {
+    if (!m_prob.strictOrderY || m_prob.siteSizeX != 1) {
+        return true;
+    }
+    if ((i0 <= i1 && j0 <= j1) || (i1 <= i0 && j1 <= j0)) {
+        return false;
+    }
+    int c0 = m_prob.cellId(i0, j0), c1 = m_prob.cellId(i1, j1);
+    return m_upperY[c0] >= m_lowerY[c1] && m_upperY[c1] >= m_lowerY[c0];
+}
+
+/**
+ * @brief Whether x0 <= x1 is implied by ROC in X (same row, cell 0 left of cell 1).
+ *
+ */
+bool RocPresolve::orderedX(int i0, int j0, int i1, int j1) const {
+    return m_prob.relativeConstraintX && i0 == i1 && j0 < j1;
+}
+
+/**
+ * @brief Whether y0 <= y1 is implied by ROC in Y (same column, cell 0 below cell 1).
+ *
+ */
+bool RocPresolve::orderedY(int i0, int j0, int i1, int j1) const {
+    return m_prob.relativeConstraintY && j0 == j1 && i0 < i1;
+}
+
+void RocPresolve::printStats() const {
+    printf("Presolve: %d of %d no-overlap pairs kept", m_numNoOverlapPairs, m_numPairs);
+    if (m_prob.strictOrderY && m_prob.siteSizeX == 1) {
+        long long range = 0;
+        for (size_t c = 0; c < m_lowerY.size(); c++) {
+            range += m_upperY[c] - m_lowerY[c] + 1;
+        }
+        printf(", site range per cell %.1f of %d", m_lowerY.empty() ? 0.0 : (double)range / m_lowerY.size(), m_prob.siteSizeY);
+    }
+    printf("%s\n", m_feasible ? "" : " (WRN: fewer free sites than the ROC needs, the model is infeasible)");
+}
@@ -0,0 +1,47 @@
+#ifndef __PRESOLVE_H__
+#define __PRESOLVE_H__
+
+#include "Placement.h"
+#include <vector>
+
+
+/**
+ * @brief ROC-aware presolve of the pairwise no-overlap constraints (NOC).
+ *
+ * One column with strict ROC (PlacementProblem::strictOrderY): y strictly increases along rows and columns, so by
+ * transitivity y0 < y1 whenever cell (i0, j0) dominates cell (i1, j1) (i0 <= i1 and j0 <= j1). Only the incomparable
+ * pairs need a NOC. A cell has (i+1)(j+1)-1 predecessors and (Y-i)(X-j)-1 successors in the grid poset, which bounds
+ * its site to [(i+1)(j+1)-1, N-(Y-i)(X-j)] for N free sites (counted over the free rows if some are blocked).
+ * Incomparable pairs with disjoint bounds need no NOC either.
+ *
+ * Two dimensions: ROC in X orders x along a row and ROC in Y orders y along a column, both non-strictly, so the NOC
+ * stays, but the sign of the difference on the ordered axis is known and its absolute value is linear.
+ *
+ */
+class RocPresolve
+{
+public:
+    explicit RocPresolve(const PlacementProblem &prob);
+
+    bool    needsNoOverlap(int i0, int j0, int i1, int j1) const;
+    bool    orderedX(int i0, int j0, int i1, int j1) const;
+    bool    orderedY(int i0, int j0, int i1, int j1) const;
+    int     lowerY(int cell) const { return m_lowerY[cell]; }
+    int     upperY(int cell) const { return m_upperY[cell]; }
+    bool    feasible() const { return m_feasible; }
+
+    int     numPairs() const { return m_numPairs; }
+    int     numNoOverlapPairs() const { return m_numNoOverlapPairs; }
+    void    printStats() const;
+
+private:
+    PlacementProblem    m_prob;
+    std::vector<int>    m_lowerY; // Site row bounds by cell id.
+    std::vector<int>    m_upperY;
+    bool                m_feasible = true;
+    int                 m_numPairs = 0;
+    int                 m_numNoOverlapPairs = 0;
+};
+
+
+#endif
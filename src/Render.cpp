@@ -0,0 +1,282 @@
+#include "Render.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+
+namespace {
+
+struct Rgb {
+    unsigned char r, g, b;
+};
+
+// Cell fill colors by array column, as in output/plotFromSol.py.
+const Rgb kColumnColors[] = {{230, 40, 40}, {250, 150, 20}, {40, 160, 60}, {40, 90, 220}, {140, 60, 180}};
+
+/**
+ * @brief Wire color from green (shortest) over yellow to red (longest).
+ *
+ * @param t wire length relative to the longest wire, in [0, 1].
+ */
+Rgb wireColor(double t) {
+    t = std::max(0.0, std::min(1.0, t));
+    if (t < 0.5) {
+        return {(unsigned char)(510 * t), 170, 0};
+    }
+    return {255, (unsigned char)(170 * (2 - 2 * t)), 0};
+}
+
+/**
+ * @brief Pixel pitch of a site. Narrow site grids (few columns) are stretched in x up to a 1:4 aspect ratio.
+ *
+ */
+void sitePitch(const PlacementProblem &prob, int maxPixels, int &pitchX, int &pitchY) {
+    pitchY = std::max(1, std::min(32, maxPixels / std::max(prob.siteSizeY, prob.siteSizeX)));
+    pitchX = pitchY;
+    int height = prob.siteSizeY * pitchY;
+    if (prob.siteSizeX * pitchX < height / 4) {
+        pitchX = std::max(pitchY, std::min(maxPixels / prob.siteSizeX, height / (4 * prob.siteSizeX)));
+    }
+}
+
+/**
+ * @brief Weighted length of every array edge (top and right neighbors) and the longest one.
+ *
+ */
+void edgeLengths(const PlacementProblem &prob, const Placement &pl, std::vector<int> &c0, std::vector<int> &c1,
+                 std::vector<double> &len, double &maxLen) {
+    maxLen = 0;
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            for (int dir = 0; dir < 2; dir++) {
+                int i1 = i + (dir == 0), j1 = j + (dir == 1);
+                if (i1 >= prob.arraySizeY || j1 >= prob.arraySizeX) {
+                    continue;
+                }
+                int a = prob.cellId(i, j), b = prob.cellId(i1, j1);
+                double l = prob.weightX * prob.distX(pl.x(a), pl.x(b)) + prob.weightY * prob.distY(pl.y(a), pl.y(b));
+                c0.push_back(a);
+                c1.push_back(b);
+                len.push_back(l);
+                maxLen = std::max(maxLen, l);
+            }
+        }
+    }
+}
+
+std::string replaceExtension(const std::string &fileName, const std::string &ext) {
+    size_t dot = fileName.rfind('.');
+    size_t slash = fileName.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return fileName + "." + ext;
+    }
+    return fileName.substr(0, dot + 1) + ext;
+}
+
+} // namespace
+
+
+/**
+ * @brief Draw a placement as SVG: sites y grows upwards, wires colored by weighted length, cells colored by array column.
+ * Hovering a cell shows its array index.
+ *
+ * @param fileName
+ * @param prob
+ * @param pl
+ * @return true if the file could be written.
+ */
+bool renderPlacementSvg(const std::string &fileName, const PlacementProblem &prob, const Placement &pl) {
+    FILE *fp = fopen(fileName.c_str(), "w");
+    if (fp == NULL) {
+        printf("ERR: Open file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+
+    int pitchX, pitchY;
+    sitePitch(prob, 2048, pitchX, pitchY);
+    const int margin = 2 * pitchY + 16;
+    const int width = prob.siteSizeX * pitchX + 2 * margin;
+    const int height = prob.siteSizeY * pitchY + 2 * margin;
+    auto px = [&](int c) { return margin + (pl.x(c) + 0.5) * pitchX; };
+    auto py = [&](int c) { return margin + (prob.siteSizeY - pl.y(c) - 0.5) * pitchY; };
+
+    std::vector<int> c0, c1;
+    std::vector<double> len;
+    double maxLen;
+    edgeLengths(prob, pl, c0, c1, len, maxLen);
+
+    fprintf(fp, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n", width, height, width, height);
+    fprintf(fp, "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n");
+    fprintf(fp, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"#eeeeee\"/>\n",
+        margin, margin, prob.siteSizeX * pitchX, prob.siteSizeY * pitchY);
+    fprintf(fp, "<text x=\"4\" y=\"14\" font-family=\"monospace\" font-size=\"12\">Array %d x %d, sites %d x %d, WL %.1f (weight x %g, y %g)</text>\n",
+        prob.arraySizeY, prob.arraySizeX, prob.siteSizeY, prob.siteSizeX, placementWirelength(prob, pl), prob.weightX, prob.weightY);
+
+    const double stroke = std::max(0.5, 0.15 * std::min(pitchX, pitchY));
+    fprintf(fp, "<g stroke-width=\"%.2f\" stroke-linecap=\"round\">\n", stroke);
+    for (size_t e = 0; e < len.size(); e++) {
+        Rgb col = wireColor((maxLen > 0) ? len[e] / maxLen : 0);
+        fprintf(fp, "<line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#%02x%02x%02x\"/>\n",
+            px(c0[e]), py(c0[e]), px(c1[e]), py(c1[e]), col.r, col.g, col.b);
+    }
+    fprintf(fp, "</g>\n");
+
+    const double boxX = 0.6 * pitchX, boxY = 0.6 * pitchY;
+    fprintf(fp, "<g stroke=\"black\" stroke-width=\"%.2f\">\n", 0.5 * stroke);
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c = prob.cellId(i, j);
+            Rgb col = kColumnColors[j % 5];
+            fprintf(fp, "<rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\" fill=\"#%02x%02x%02x\"><title>(%d,%d) at (%d,%d)</title></rect>\n",
+                px(c) - 0.5 * boxX, py(c) - 0.5 * boxY, boxX, boxY, col.r, col.g, col.b, i, j, pl.y(c), pl.x(c));
+        }
+    }
+    fprintf(fp, "</g>\n</svg>\n");
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief Draw a placement as a binary PPM (P6) image, same layout as renderPlacementSvg() without text.
+ *
+ * @param fileName
+ * @param prob
+ * @param pl
+ * @param maxPixels longest image side.
+ * @return true if the file could be written.
+ */
+bool renderPlacementPpm(const std::string &fileName, const PlacementProblem &prob, const Placement &pl, int maxPixels) {
+    int pitchX, pitchY;
+    sitePitch(prob, maxPixels, pitchX, pitchY);
+    const int margin = pitchY;
+    const int width = prob.siteSizeX * pitchX + 2 * margin;
+    const int height = prob.siteSizeY * pitchY + 2 * margin;
+    std::vector<Rgb> img((size_t)width * height, Rgb{255, 255, 255});
+
+    auto plot = [&](int x, int y, Rgb col) {
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            img[(size_t)y * width + x] = col;
+        }
+    };
+    auto px = [&](int c) { return margin + pl.x(c) * pitchX + pitchX / 2; };
+    auto py = [&](int c) { return margin + (prob.siteSizeY - 1 - pl.y(c)) * pitchY + pitchY / 2; };
+
+    for (int y = margin; y < height - margin; y++) {
+        for (int x = margin; x < width - margin; x++) {
+            plot(x, y, Rgb{238, 238, 238});
+        }
+    }
+
+    std::vector<int> c0, c1;
+    std::vector<double> len;
+    double maxLen;
+    edgeLengths(prob, pl, c0, c1, len, maxLen);
+    // Long wires last, so they do not hide under a bundle of short ones.
+    std::vector<int> order(len.size());
+    for (size_t e = 0; e < order.size(); e++) {
+        order[e] = e;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return len[a] < len[b]; });
+    for (int e: order) {
+        Rgb col = wireColor((maxLen > 0) ? len[e] / maxLen : 0);
+        // Bresenham.
+        int x0 = px(c0[e]), y0 = py(c0[e]), x1 = px(c1[e]), y1 = py(c1[e]);
+        int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+        int sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+        int err = dx + dy;
+        while (true) {
+            plot(x0, y0, col);
+            if (x0 == x1 && y0 == y1) {
+                break;
+            }
+            int e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+
+    const int boxX = std::max(1, 3 * pitchX / 5), boxY = std::max(1, 3 * pitchY / 5);
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c = prob.cellId(i, j);
+            Rgb col = kColumnColors[j % 5];
+            int x0 = px(c) - boxX / 2, y0 = py(c) - boxY / 2;
+            for (int y = y0; y < y0 + boxY; y++) {
+                for (int x = x0; x < x0 + boxX; x++) {
+                    bool border = (boxX > 2 && boxY > 2) && (y == y0 || y == y0 + boxY - 1 || x == x0 || x == x0 + boxX - 1);
+                    plot(x, y, border ? Rgb{0, 0, 0} : col);
+                }
+            }
+        }
+    }
+
+    FILE *fp = fopen(fileName.c_str(), "wb");
+    if (fp == NULL) {
+        printf("ERR: Open file [%s] failed!\n", fileName.c_str());
+        return false;
+    }
+    fprintf(fp, "P6\n%d %d\n255\n", width, height);
+    fwrite(img.data(), sizeof(Rgb), img.size(), fp);
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief Render every .sol file next to itself (same name, .svg or .ppm), in parallel.
+ * The array and site sizes come from the file contents, not from the file name.
+ *
+ * @param solFileNames
+ * @param opt
+ * @return int the number of images written.
+ */
+int renderSolFiles(const std::vector<std::string> &solFileNames, const RenderOptions &opt) {
+    int threads = (opt.threads > 0) ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, (int)solFileNames.size()));
+
+    std::atomic<int> next(0), written(0);
+    auto worker = [&]() {
+        for (int k = next++; k < (int)solFileNames.size(); k = next++) {
+            const std::string &solFileName = solFileNames[k];
+            PlacementProblem prob;
+            prob.weightX = opt.weightX;
+            prob.weightY = opt.weightY;
+            Placement pl;
+            if (!readPlacementShapeFromSol(solFileName, prob, pl)) {
+                continue;
+            }
+            bool ok;
+            std::string imgFileName;
+            if (opt.format == "ppm") {
+                imgFileName = replaceExtension(solFileName, "ppm");
+                ok = renderPlacementPpm(imgFileName, prob, pl, opt.maxPixels);
+            }
+            else {
+                imgFileName = replaceExtension(solFileName, "svg");
+                ok = renderPlacementSvg(imgFileName, prob, pl);
+            }
+            if (ok) {
+                written++;
+                printf("Render <%s> (%d x %d => %d x %d) to <%s>\n", solFileName.c_str(),
+                    prob.arraySizeY, prob.arraySizeX, prob.siteSizeY, prob.siteSizeX, imgFileName.c_str());
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread &t: workers) {
+        t.join();
+    }
+    return written;
+}
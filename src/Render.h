@@ -0,0 +1,27 @@
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+#include "Placement.h"
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Options of the placement renderer.
+ *
+ */
+struct RenderOptions {
+    std::string     format = "svg"; // "svg" or "ppm".
+    int             threads = 0; // 0: hardware concurrency.
+    double          weightX = 1; // Wire color scale: weightX * |dx| + weightY * |dy|.
+    double          weightY = 1;
+    int             maxPixels = 2048; // PPM: longest image side.
+};
+
+
+bool    renderPlacementSvg(const std::string &fileName, const PlacementProblem &prob, const Placement &pl);
+bool    renderPlacementPpm(const std::string &fileName, const PlacementProblem &prob, const Placement &pl, int maxPixels);
+int     renderSolFiles(const std::vector<std::string> &solFileNames, const RenderOptions &opt);
+
+
+#endif
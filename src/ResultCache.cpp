@@ -0,0 +1,224 @@
+#include "ResultCache.h"
+#include "util.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+
+namespace {
+
+uint64_t fnv1a(const void *data, size_t bytes, uint64_t h = 1469598103934665603ull) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t k = 0; k < bytes; k++) {
+        h = (h ^ p[k]) * 1099511628211ull;
+    }
+    return h;
+}
+
+std::string hex(uint64_t h) {
+    char buf[20];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+} // namespace
+
+
+/**
+ * @brief Use the registry in directory <dir>, created (with its parents) if missing.
+ *
+ * @param dir
+ */
+ResultCache::ResultCache(const std::string &dir)
+    : m_dir(dir)
+{
+    for (size_t pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1)) {
+        const std::string sub = dir.substr(0, pos);
+        if (mkdir(sub.c_str(), 0775) != 0 && errno != EEXIST) {
+            printf("ERR: ResultCache: cannot create <%s>: %s\n", sub.c_str(), strerror(errno));
+        }
+        if (pos == std::string::npos) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Normalized parameters of <prob>: what determines its feasible placements and their wirelength.
+ * Constraints and weights that cannot matter are dropped (an axis with one site or one array line has neither
+ * distances nor ordering), the site geometry enters by its contents rather than its file name, and the connectivity
+ * is the array mesh every formulation optimizes.
+ *
+ * @param prob
+ * @return std::string
+ */
+std::string ResultCache::problemKey(const PlacementProblem &prob) {
+    const bool rocX = prob.relativeConstraintX && prob.siteSizeX > 1 && prob.arraySizeX > 1;
+    const bool rocY = prob.relativeConstraintY && prob.siteSizeY > 1 && prob.arraySizeY > 1;
+    const double weightX = (prob.siteSizeX > 1) ? prob.weightX : 0;
+    const double weightY = (prob.siteSizeY > 1) ? prob.weightY : 0;
+    std::string geometry = "none";
+    if (prob.geometry) {
+        const SiteGeometry &g = *prob.geometry;
+        uint64_t h = fnv1a(g.coordsY().data(), g.coordsY().size() * sizeof(double));
+        h = fnv1a(g.coordsX().data(), g.coordsX().size() * sizeof(double), h);
+        for (int sy = 0; sy < g.sizeY(); sy++) {
+            for (int sx = 0; sx < g.sizeX(); sx++) {
+                char b = g.blocked(sy, sx);
+                h = fnv1a(&b, 1, h);
+            }
+        }
+        geometry = hex(h);
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf), "v1 array=%dx%d sites=%dx%d weight=%.17g,%.17g roc=%d,%d strictY=%d edges=mesh4 geometry=%s",
+        prob.arraySizeY, prob.arraySizeX, prob.siteSizeY, prob.siteSizeX, weightX, weightY, rocX, rocY,
+        (int)(prob.strictOrderY && rocY), geometry.c_str());
+    return buf;
+}
+
+std::string ResultCache::path(const PlacementProblem &prob, const std::string &ext) const {
+    const std::string key = problemKey(prob);
+    return m_dir + "/" + hex(fnv1a(key.data(), key.size())) + ext;
+}
+
+std::string ResultCache::tmpName(const std::string &fileName) const {
+    char buf[64];
+    snprintf(buf, sizeof(buf), ".tmp.%d.%zu", (int)getpid(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return fileName + buf;
+}
+
+/**
+ * @brief The best known placement of <prob>.
+ *
+ * @param prob
+ * @param entry its record; wl is recomputed from the placement.
+ * @param pl
+ * @return true if a legal placement of <prob> is registered.
+ */
+bool ResultCache::lookup(const PlacementProblem &prob, Entry &entry, Placement &pl) const {
+    entry = Entry();
+    if (!readEntry(path(prob, ".entry"), entry) || entry.key != problemKey(prob)) {
+        return false;
+    }
+    if (!readPlacementFromSol(solFileName(prob), prob, pl) || !isPlacementLegal(prob, pl)) {
+        printf("WRN: ResultCache: the placement of <%s> is missing or illegal.\n", entry.key.c_str());
+        return false;
+    }
+    const double wl = placementWirelength(prob, pl);
+    // The .sol and .entry files are renamed separately: an entry for another placement proves nothing about this one.
+    if (std::fabs(wl - entry.wl) > 1e-6) {
+        entry.optimal = false;
+    }
+    entry.wl = wl;
+    entry.optimal = entry.optimal || entry.bound >= wl - 1e-6;
+    return true;
+}
+
+/**
+ * @brief Merge a job's result into the registry: the placement replaces the registered one if shorter, the bound
+ * raises the registered bound, and the registered wirelength is proven optimal once the bound reaches it.
+ *
+ * @param prob
+ * @param pl the job's placement (legal); null if it found none.
+ * @param bound lower bound on the wirelength found by the job; 0 if none.
+ * @param optimal the job proved <pl> optimal.
+ * @param job
+ * @param method
+ * @param entry the registered record afterwards.
+ * @return true if the registry changed.
+ */
+bool ResultCache::update(const PlacementProblem &prob, const Placement *pl, double bound, bool optimal,
+                         const std::string &job, int method, Entry &entry) {
+    Placement cached;
+    const bool haveCached = lookup(prob, entry, cached);
+    if (!haveCached) {
+        entry = Entry();
+        entry.key = problemKey(prob);
+    }
+
+    bool changed = false;
+    if (pl) {
+        const double wl = placementWirelength(prob, *pl);
+        if (!haveCached || wl < entry.wl - 1e-6) {
+            const std::string solFile = solFileName(prob), tmp = tmpName(solFile);
+            if (!writePlacementToSol(tmp, prob, *pl) || rename(tmp.c_str(), solFile.c_str()) != 0) {
+                printf("ERR: ResultCache: writing <%s> failed.\n", solFile.c_str());
+                return false;
+            }
+            entry.optimal = optimal;
+            entry.wl = wl;
+            entry.job = job;
+            entry.method = method;
+            changed = true;
+        }
+        else if (optimal && wl <= entry.wl + 1e-6) {
+            changed |= !entry.optimal;
+            entry.optimal = true;
+        }
+    }
+    if (bound > entry.bound + 1e-6) {
+        entry.bound = bound;
+        changed = true;
+    }
+    if (!entry.optimal && (haveCached || pl) && entry.bound >= entry.wl - 1e-6) {
+        entry.optimal = true;
+        changed = true;
+    }
+    if (changed && (haveCached || pl) && !writeEntry(path(prob, ".entry"), entry)) {
+        printf("ERR: ResultCache: writing the entry of <%s> failed.\n", entry.key.c_str());
+        return false;
+    }
+    return changed;
+}
+
+bool ResultCache::readEntry(const std::string &fileName, Entry &entry) const {
+    std::ifstream fs(fileName);
+    if (!fs.good()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(fs, line)) {
+        size_t pos = line.find(' ');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        const std::string field = line.substr(0, pos), value = line.substr(pos + 1);
+        if (field == "key") {
+            entry.key = value;
+        }
+        else if (field == "wirelength") {
+            entry.wl = atof(value.c_str());
+        }
+        else if (field == "bound") {
+            entry.bound = atof(value.c_str());
+        }
+        else if (field == "optimal") {
+            entry.optimal = atoi(value.c_str());
+        }
+        else if (field == "job") {
+            entry.job = value;
+        }
+        else if (field == "method") {
+            entry.method = atoi(value.c_str());
+        }
+    }
+    return !entry.key.empty();
+}
+
+bool ResultCache::writeEntry(const std::string &fileName, const Entry &entry) const {
+    const std::string tmp = tmpName(fileName);
+    FILE *fp = fopen(tmp.c_str(), "w");
+    if (fp == NULL) {
+        return false;
+    }
+    fprintf(fp, "key %s\nwirelength %.17g\nbound %.17g\noptimal %d\njob %s\nmethod %d\n",
+        entry.key.c_str(), entry.wl, entry.bound, (int)entry.optimal, entry.job.c_str(), entry.method);
+    fclose(fp);
+    return rename(tmp.c_str(), fileName.c_str()) == 0;
+}
@@ -0,0 +1,50 @@
+#ifndef __RESULTCACHE_H__
+#define __RESULTCACHE_H__
+
+#include "Placement.h"
+#include <string>
+
+
+/**
+ * @brief On-disk registry of the best placement known for every problem, shared by all runs (and hosts) that use the
+ * same directory. A problem is addressed by the hash of its normalized parameters (see problemKey()):
+ *   <dir>/<hash>.entry   the key, the wirelength, the best lower bound (at least the combinatorial bound of
+ *                        CutSeparator, whatever the method), whether the wirelength is proven optimal, and the job
+ *                        and method that found it;
+ *   <dir>/<hash>.sol     the placement.
+ * Files are replaced by atomic renames. A placement read back is checked for legality and its wirelength recomputed,
+ * so a stale or foreign file is never trusted.
+ *
+ */
+class ResultCache
+{
+public:
+    struct Entry {
+        std::string key;
+        double      wl = 0;
+        double      bound = 0;
+        bool        optimal = false;
+        std::string job;
+        int         method = -1;
+    };
+
+    explicit ResultCache(const std::string &dir);
+
+    static std::string problemKey(const PlacementProblem &prob);
+
+    bool    lookup(const PlacementProblem &prob, Entry &entry, Placement &pl) const;
+    bool    update(const PlacementProblem &prob, const Placement *pl, double bound, bool optimal,
+                   const std::string &job, int method, Entry &entry);
+    std::string solFileName(const PlacementProblem &prob) const { return path(prob, ".sol"); }
+
+private:
+    bool    readEntry(const std::string &fileName, Entry &entry) const;
+    bool    writeEntry(const std::string &fileName, const Entry &entry) const;
+    std::string path(const PlacementProblem &prob, const std::string &ext) const;
+    std::string tmpName(const std::string &fileName) const;
+
+    std::string m_dir;
+};
+
+
+#endif
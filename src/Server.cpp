@@ -0,0 +1,351 @@
+#include "Server.h"
+#include "util.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+PlacerServer::PlacerServer(const std::string &socketPath)
+    : m_socketPath(socketPath), m_stop(false)
+{}
+
+/**
+ * @brief Listen on the socket and serve requests until SHUTDOWN. Jobs run one at a time on a worker thread
+ * (each job parallelizes internally); connections are read on threads of their own and only parse and enqueue.
+ *
+ * @return int 0 on a clean shutdown, 1 if the socket could not be opened.
+ */
+int PlacerServer::run() {
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        printf("ERR: socket(): %s\n", strerror(errno));
+        return 1;
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(addr.sun_path)) {
+        printf("ERR: Socket path [%s] is too long.\n", m_socketPath.c_str());
+        close(listenFd);
+        return 1;
+    }
+    strncpy(addr.sun_path, m_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(m_socketPath.c_str());
+    if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 64) < 0) {
+        printf("ERR: Listen on [%s] failed: %s\n", m_socketPath.c_str(), strerror(errno));
+        close(listenFd);
+        return 1;
+    }
+    m_listenFd = listenFd;
+    printf("Placer server listening on <%s>.\n", m_socketPath.c_str());
+    fflush(stdout);
+
+    std::thread jobThread(&PlacerServer::worker, this);
+    while (!m_stop) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!m_stop) {
+                printf("ERR: accept(): %s\n", strerror(errno));
+            }
+            break;
+        }
+        timeval timeout;
+        timeout.tv_sec = kReadTimeout;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_numConnections++;
+        }
+        std::thread(&PlacerServer::serveConnection, this, fd).detach();
+    }
+
+    {
+        // Connections still being read may queue jobs; the queue is dropped after them.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_connectionDone.wait(lock, [this]() { return m_numConnections == 0; });
+        for (Request &req: m_queue) {
+            sendLine(req.fd, "ERR shutdown");
+            close(req.fd);
+        }
+        m_queue.clear();
+    }
+    m_queued.notify_all();
+    jobThread.join();
+    close(listenFd);
+    unlink(m_socketPath.c_str());
+    printf("Placer server stopped after %d jobs.\n", m_numRun);
+    return 0;
+}
+
+void PlacerServer::serveConnection(int fd) {
+    serve(fd);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_numConnections--;
+    m_connectionDone.notify_all();
+}
+
+/**
+ * @brief Read the request of a new connection. JOB requests keep the connection open until the worker answers;
+ * all others are answered and closed here.
+ *
+ * @param fd
+ */
+void PlacerServer::serve(int fd) {
+    std::string line;
+    if (!readLine(fd, line)) {
+        close(fd);
+        return;
+    }
+    std::istringstream is(line);
+    std::vector<std::string> tokens;
+    read_line_as_tokens(is, tokens);
+    if (tokens.empty()) {
+        sendLine(fd, "ERR empty request");
+        close(fd);
+        return;
+    }
+    const std::string cmd = tokens[0];
+    tokens.erase(tokens.begin());
+
+    if (cmd == "JOB") {
+        Request req;
+        std::string error;
+        if (!parseJob(tokens, req.job, error)) {
+            sendLine(fd, "ERR " + error);
+            close(fd);
+            return;
+        }
+        req.fd = fd;
+        req.priority = req.job[0].priority;
+        int position;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            req.id = m_nextId++;
+            // Stable: behind every queued request of the same or higher priority.
+            auto it = std::find_if(m_queue.begin(), m_queue.end(), [&](const Request &r) { return r.priority < req.priority; });
+            position = it - m_queue.begin();
+            m_queue.insert(it, req);
+            sendLine(fd, "QUEUED " + std::to_string(req.id) + " " + std::to_string(position));
+        }
+        m_queued.notify_one();
+    }
+    else if (cmd == "BEST" && tokens.size() >= 8) {
+        // Reuse the job parser with a dummy name, time limit and method.
+        std::vector<MacroPlacer::JOB> jobs;
+        tokens.insert(tokens.begin(), "best");
+        tokens.resize(9);
+        tokens.push_back("0");
+        tokens.push_back("0");
+        std::string error;
+        if (!parseJob(tokens, jobs, error)) {
+            sendLine(fd, "ERR " + error);
+            close(fd);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_best.find(problemKey(jobs[0]));
+        if (it == m_best.end()) {
+            lock.unlock();
+            sendLine(fd, "ERR no best known placement");
+        }
+        else {
+            BestKnown best = it->second;
+            lock.unlock();
+            char head[128];
+            snprintf(head, sizeof(head), "DONE - best %.10g 0", best.wl);
+            sendPlacement(fd, head, best.prob, best.pl);
+        }
+        close(fd);
+    }
+    else if (cmd == "STATS") {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sendLine(fd, "STATS queued " + std::to_string(m_queue.size()) + " run " + std::to_string(m_numRun)
+                     + " best " + std::to_string(m_best.size()));
+        close(fd);
+    }
+    else if (cmd == "SHUTDOWN") {
+        m_stop = true;
+        sendLine(fd, "BYE");
+        close(fd);
+        // Wake the accept() of run().
+        shutdown(m_listenFd, SHUT_RDWR);
+    }
+    else {
+        sendLine(fd, "ERR unknown request <" + cmd + ">");
+        close(fd);
+    }
+}
+
+/**
+ * @brief Parse a batch line into exactly one job. Malformed numbers make the job parser throw; they are reported in
+ * <error> instead, so a bad request never ends the daemon.
+ *
+ * @param tokens
+ * @param jobs
+ * @param error
+ * @return true if one job was parsed.
+ */
+bool PlacerServer::parseJob(const std::vector<std::string> &tokens, std::vector<MacroPlacer::JOB> &jobs, std::string &error) {
+    try {
+        if (!MacroPlacer::parseJobTokens(tokens, jobs) || jobs.size() != 1) {
+            error = "a job needs 11 fields";
+            return false;
+        }
+    } catch (const std::exception &e) {
+        error = std::string("malformed field (") + e.what() + ")";
+        jobs.clear();
+        return false;
+    }
+    return true;
+}
+
+void PlacerServer::worker() {
+    while (true) {
+        Request req;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queued.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_stop && m_queue.empty()) {
+                return;
+            }
+            req = m_queue.front();
+            m_queue.erase(m_queue.begin());
+        }
+        runRequest(req);
+        close(req.fd);
+    }
+}
+
+/**
+ * @brief Run one job on the shared placer. Without an initial solution the best known placement of the same problem
+ * is the start; the job's result replaces it if it is legal and shorter.
+ *
+ * @param req
+ */
+void PlacerServer::runRequest(Request &req) {
+    MacroPlacer::JOB &job = req.job[0];
+    const std::string key = problemKey(job);
+    const PlacementProblem prob = MacroPlacer::jobProblem(job);
+    sendLine(req.fd, "RUNNING " + std::to_string(req.id));
+
+    std::string startFileName;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_best.find(key);
+        if (job.initSolFileName == "" && it != m_best.end()) {
+            startFileName = "output/server_best_" + std::to_string(req.id) + ".sol";
+            writePlacementToSol(startFileName, it->second.prob, it->second.pl);
+            job.initSolFileName = startFileName;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    m_placer.runJob(job);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (startFileName != "") {
+        std::remove(startFileName.c_str());
+    }
+
+    Placement pl;
+    bool solved = m_placer.lastSolFileName() != "" && readPlacementFromSol(m_placer.lastSolFileName(), prob, pl)
+                  && isPlacementLegal(prob, pl);
+    double wl = solved ? placementWirelength(prob, pl) : 0;
+
+    BestKnown best;
+    bool haveBest;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_numRun++;
+        auto it = m_best.find(key);
+        if (solved && (it == m_best.end() || wl < it->second.wl)) {
+            BestKnown &b = m_best[key];
+            b.prob = prob;
+            b.pl = pl;
+            b.wl = wl;
+        }
+        it = m_best.find(key);
+        haveBest = (it != m_best.end());
+        if (haveBest) {
+            best = it->second;
+        }
+    }
+
+    char head[128];
+    if (solved) {
+        snprintf(head, sizeof(head), "DONE %d job %.10g %.3f", req.id, wl, elapsed.count());
+        sendPlacement(req.fd, head, prob, pl);
+    }
+    else if (haveBest) {
+        snprintf(head, sizeof(head), "DONE %d best %.10g %.3f", req.id, best.wl, elapsed.count());
+        sendPlacement(req.fd, head, best.prob, best.pl);
+    }
+    else {
+        sendLine(req.fd, "ERR " + std::to_string(req.id) + " no placement");
+    }
+}
+
+bool PlacerServer::sendPlacement(int fd, const std::string &head, const PlacementProblem &prob, const Placement &pl) {
+    std::string msg = head + "\n";
+    char buf[64];
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            int c = prob.cellId(i, j);
+            snprintf(buf, sizeof(buf), "X_%d_%d %d\nY_%d_%d %d\n", i, j, pl.x(c), i, j, pl.y(c));
+            msg += buf;
+        }
+    }
+    msg += "END";
+    return sendLine(fd, msg);
+}
+
+/**
+ * @brief Identity of a problem for the best-known registry: sizes, weights, relative constraints and site file.
+ *
+ */
+std::string PlacerServer::problemKey(const MacroPlacer::JOB &job) {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%d_%d_%d_%d_%g_%g_%d_%d", job.arraySizeY, job.arraySizeX, job.siteSizeY, job.siteSizeX,
+        job.weightX, job.weightY, job.relativeConstraintX, job.relativeConstraintY);
+    return buf + job.siteFileName;
+}
+
+bool PlacerServer::readLine(int fd, std::string &line) {
+    line.clear();
+    char c;
+    while (true) {
+        ssize_t n = recv(fd, &c, 1, 0);
+        if (n <= 0) {
+            return !line.empty();
+        }
+        if (c == '\n') {
+            return true;
+        }
+        line.push_back(c);
+    }
+}
+
+bool PlacerServer::sendLine(int fd, const std::string &line) {
+    std::string msg = line + "\n";
+    size_t sent = 0;
+    while (sent < msg.size()) {
+        // MSG_NOSIGNAL: a client that went away must not kill the server with SIGPIPE.
+        ssize_t n = send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include "ILPSolver.h"
+#include "Placement.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Placer daemon on a Unix domain socket. One long-lived MacroPlacer runs all requests, so its Gurobi environment
+ * pool stays warm, and the best placement seen for every problem is kept in memory and used as the start of later jobs.
+ *
+ * Protocol, one request per connection, one line each way per message:
+ *   JOB <batch line>     queue a job (batch-file syntax, "priority=<n>" orders the queue, higher first);
+ *                        replies "QUEUED <id> <position>", "RUNNING <id>", then
+ *                        "DONE <id> <job|best> <wirelength> <seconds>", the placement as "X_i_j v"/"Y_i_j v" lines, "END".
+ *   BEST <arraySizeY arraySizeX siteSizeY siteSizeX weightX weightY relativeConstraintX relativeConstraintY>
+ *                        the best known placement without solving: "DONE - best <wirelength> 0", lines, "END".
+ *   STATS                queue length, jobs run and problems with a best known placement.
+ *   SHUTDOWN             finish the running job, drop the queue and exit.
+ * Errors are answered with "ERR <message>".
+ * Every connection is read on its own thread, and a client idle for kReadTimeout seconds is dropped, so a slow client
+ * delays no other. Progress is streamed as the queue and run states only, not per incumbent. There is no model cache:
+ * every job builds its Gurobi model anew, since models depend on the job's options and start.
+ *
+ */
+class PlacerServer
+{
+public:
+    explicit PlacerServer(const std::string &socketPath);
+
+    int     run();
+
+private:
+    struct Request {
+        int                 id = 0;
+        int                 priority = 0;
+        int                 fd = -1;
+        std::vector<MacroPlacer::JOB> job; // Exactly one job; a vector since JOB has no default constructor.
+    };
+    struct BestKnown {
+        PlacementProblem    prob;
+        Placement           pl;
+        double              wl = 0;
+    };
+
+    void    serve(int fd);
+    void    serveConnection(int fd);
+    void    worker();
+    void    runRequest(Request &req);
+    bool    sendPlacement(int fd, const std::string &head, const PlacementProblem &prob, const Placement &pl);
+
+    static bool         parseJob(const std::vector<std::string> &tokens, std::vector<MacroPlacer::JOB> &jobs, std::string &error);
+    static std::string  problemKey(const MacroPlacer::JOB &job);
+    static bool         readLine(int fd, std::string &line);
+    static bool         sendLine(int fd, const std::string &line);
+
+    static const int    kReadTimeout = 30; // seconds.
+
+    std::string                         m_socketPath;
+    int                                 m_listenFd = -1;
+    MacroPlacer                         m_placer;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_queued;
+    std::condition_variable             m_connectionDone;
+    int                                 m_numConnections = 0;
+    std::vector<Request>                m_queue;
+    std::map<std::string, BestKnown>    m_best;
+    std::atomic<bool>                   m_stop;
+    int                                 m_nextId = 0;
+    int                                 m_numRun = 0;
+};
+
+
+#endif
@@ -0,0 +1,118 @@
+#include "SolvePhase.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+
+const char * SolvePhase::name() const {
+    switch (kind) {
+        case NOREL: return "norel";
+        case HEUR:  return "heur";
+        case BOUND: return "bound";
+        default:    return "bb";
+    }
+}
+
+/**
+ * @brief Parse a phase list "kind[:stallSeconds],...", e.g. "norel:600,bound:1800,bb".
+ * Every phase but the last needs a stall time, else the phases after it would never run.
+ *
+ * @param spec
+ * @param phases the phases; empty on error.
+ * @return true if <spec> is valid.
+ */
+bool parseSolvePhases(const std::string &spec, std::vector<SolvePhase> &phases) {
+    phases.clear();
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const size_t pos = item.find(':');
+        const std::string kind = item.substr(0, pos);
+        SolvePhase phase;
+        if (kind == "norel") phase.kind = SolvePhase::NOREL;
+        else if (kind == "heur") phase.kind = SolvePhase::HEUR;
+        else if (kind == "bound") phase.kind = SolvePhase::BOUND;
+        else if (kind == "bb") phase.kind = SolvePhase::BB;
+        else {
+            printf("ERR: unknown solve phase <%s> in <%s>\n", kind.c_str(), spec.c_str());
+            phases.clear();
+            return false;
+        }
+        if (pos != std::string::npos) {
+            phase.stallTime = atof(item.c_str() + pos + 1);
+        }
+        phases.push_back(phase);
+    }
+    for (size_t k = 0; k + 1 < phases.size(); k++) {
+        if (phases[k].stallTime <= 0) {
+            printf("ERR: solve phase <%s> of <%s> needs a stall time, it is not the last one\n", phases[k].name(), spec.c_str());
+            phases.clear();
+            return false;
+        }
+    }
+    return !phases.empty();
+}
+
+std::string solvePhasesString(const std::vector<SolvePhase> &phases) {
+    std::string s;
+    for (const SolvePhase &phase: phases) {
+        if (!s.empty()) {
+            s += ",";
+        }
+        s += phase.name();
+        if (phase.stallTime > 0) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), ":%g", phase.stallTime);
+            s += buf;
+        }
+    }
+    return s;
+}
+
+
+/**
+ * @brief Start watching <phase>; the incumbent and bound carry over from the previous phase.
+ *
+ * @param phase
+ */
+void StallMonitor::startPhase(const SolvePhase &phase) {
+    m_phase = phase;
+    m_phaseStart = m_lastProgress = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Record the solver's current incumbent and bound (GRB_INFINITY / -GRB_INFINITY if none).
+ *
+ * @param incumbent
+ * @param bound
+ */
+void StallMonitor::observe(double incumbent, double bound) {
+    // Each tolerance is relative to its own value; a missing incumbent or bound (|value| >= 1e100) scales nothing.
+    auto eps = [this](double value) {
+        return m_tol * std::max(1.0, (std::fabs(value) < 1e100) ? std::fabs(value) : 0.0);
+    };
+    const bool betterIncumbent = incumbent < m_incumbent - eps(incumbent);
+    const bool betterBound = bound > m_bound + eps(bound);
+    if ((betterIncumbent && m_phase.kind != SolvePhase::BOUND) || (betterBound && m_phase.kind != SolvePhase::NOREL && m_phase.kind != SolvePhase::HEUR)) {
+        m_lastProgress = std::chrono::steady_clock::now();
+    }
+    m_incumbent = std::min(m_incumbent, incumbent);
+    m_bound = std::max(m_bound, bound);
+}
+
+/**
+ * @brief Whether the phase went stallTime seconds without progress on what it watches.
+ *
+ * @return true
+ * @return false
+ */
+bool StallMonitor::stalled() const {
+    return m_phase.stallTime > 0 && seconds(m_lastProgress) >= m_phase.stallTime;
+}
+
+double StallMonitor::seconds(std::chrono::steady_clock::time_point since) const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - since;
+    return elapsed.count();
+}
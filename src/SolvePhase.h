@@ -0,0 +1,65 @@
+#ifndef __SOLVEPHASE_H__
+#define __SOLVEPHASE_H__
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief One phase of a staged MIP solve (see MacroPlacer::optimizeInPhases()):
+ *   norel   the NoRel heuristic before the root relaxation;
+ *   heur    MIPFocus=1, feasible solutions first;
+ *   bound   MIPFocus=3, the best bound first;
+ *   bb      MIPFocus=0, balanced branch and bound.
+ * A phase ends when neither the incumbent nor the bound it watches has improved for stallTime seconds; the next one
+ * resumes the search from where it stopped. The heuristic phases watch the incumbent, bound watches the bound and bb
+ * both. stallTime 0 runs the phase to the time limit (the last phase only).
+ *
+ */
+struct SolvePhase {
+    enum Kind { NOREL, HEUR, BOUND, BB };
+
+    Kind    kind = BB;
+    double  stallTime = 0;
+
+    const char * name() const;
+    int     mipFocus() const { return (kind == HEUR) ? 1 : (kind == BOUND) ? 3 : 0; }
+};
+
+bool    parseSolvePhases(const std::string &spec, std::vector<SolvePhase> &phases);
+std::string solvePhasesString(const std::vector<SolvePhase> &phases);
+
+
+/**
+ * @brief Stagnation trigger of the current phase, fed with the incumbent and bound seen by the solver callback.
+ * The incumbent is minimized and the bound maximized. A new value counts as progress if it improves by more than tol
+ * times its own magnitude (at least 1); a missing value (|v| >= 1e100) gets the absolute tolerance tol.
+ *
+ */
+class StallMonitor
+{
+public:
+    explicit StallMonitor(double tol) : m_tol(tol) {}
+
+    void    startPhase(const SolvePhase &phase);
+    void    observe(double incumbent, double bound);
+    bool    stalled() const;
+
+    double  incumbent() const { return m_incumbent; }
+    double  bound() const { return m_bound; }
+    double  phaseTime() const { return seconds(m_phaseStart); }
+
+private:
+    double  seconds(std::chrono::steady_clock::time_point since) const;
+
+    double      m_tol;
+    SolvePhase  m_phase;
+    double      m_incumbent = 1e100;
+    double      m_bound = -1e100;
+    std::chrono::steady_clock::time_point m_phaseStart;
+    std::chrono::steady_clock::time_point m_lastProgress;
+};
+
+
+#endif
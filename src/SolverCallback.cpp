@@ -0,0 +1,353 @@
+#include "SolverCallback.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+
+IncumbentPool::IncumbentPool(const PlacementProblem &prob, double timeLimit)
+    : m_prob(prob), m_bestObj(std::numeric_limits<double>::infinity()), m_stop(false)
+{
+    if (timeLimit > 0) {
+        m_hasDeadline = true;
+        m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((long long)(timeLimit * 1000));
+    }
+}
+
+/**
+ * @brief Offer a complete placement. It replaces the pool's best if it is legal and strictly better.
+ *
+ * @param pl
+ * @param memberId
+ * @return true if the pool's best improved.
+ */
+bool IncumbentPool::offer(const Placement &pl, int memberId) {
+    if (!isPlacementLegal(m_prob, pl)) {
+        return false;
+    }
+    double obj = placementWirelength(m_prob, pl);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (obj >= m_bestObj - 1e-6) {
+        return false;
+    }
+    m_best = pl;
+    m_bestObj = obj;
+    m_version++;
+    printf("Portfolio: member %d found incumbent %.1f (version %d)\n", memberId, obj, m_version);
+    return true;
+}
+
+/**
+ * @brief Copy the pool's best into <pl, obj> if it changed since <version>; <version> is updated.
+ *
+ * @param version
+ * @param pl
+ * @param obj
+ * @return true if a newer placement was copied.
+ */
+bool IncumbentPool::fetchIfNewer(int &version, Placement &pl, double &obj) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_version == version) {
+        return false;
+    }
+    version = m_version;
+    pl = m_best;
+    obj = m_bestObj;
+    return true;
+}
+
+bool IncumbentPool::best(Placement &pl, double &obj) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_best.empty()) {
+        return false;
+    }
+    pl = m_best;
+    obj = m_bestObj;
+    return true;
+}
+
+bool IncumbentPool::shouldStop() const {
+    return m_stop || (m_hasDeadline && std::chrono::steady_clock::now() >= m_deadline);
+}
+
+
+PlacerCallback::PlacerCallback(const PlacementProblem &prob, const std::vector<GRBVar> &x, const std::vector<GRBVar> &y)
+    : m_prob(prob), m_x(x), m_y(y), m_bestObj(std::numeric_limits<double>::infinity()),
+      m_start(std::chrono::steady_clock::now())
+{}
+
+/**
+ * @brief Refine incumbents and node relaxations with LocalSearch.
+ *
+ * @param timeBudget seconds of local search per call.
+ * @param relaxInterval minimum seconds between two node relaxation roundings.
+ */
+void PlacerCallback::enableLocalSearch(double timeBudget, double relaxInterval) {
+    m_enLocalSearch = true;
+    m_lsTimeBudget = timeBudget;
+    m_relaxInterval = relaxInterval;
+}
+
+/**
+ * @brief Add the inequalities of <separator> violated by node relaxations, and objective >= <objectiveBound> while
+ * the relaxation is below it.
+ *
+ * @param separator
+ * @param objective the model's objective.
+ * @param objectiveBound lower bound on <objective>; 0 for none.
+ */
+void PlacerCallback::enableCuts(const CutSeparator *separator, const GRBLinExpr &objective, double objectiveBound) {
+    m_separator = separator;
+    m_objVars.resize(objective.size());
+    m_objCoeffs.resize(objective.size());
+    for (unsigned int k = 0; k < objective.size(); k++) {
+        m_objVars[k] = objective.getVar(k);
+        m_objCoeffs[k] = objective.getCoeff(k);
+    }
+    m_objConstant = objective.getConstant();
+    m_objBound = objectiveBound;
+}
+
+void PlacerCallback::callback() {
+    try {
+        if (m_pool && m_pool->shouldStop()) {
+            abort();
+            return;
+        }
+
+        if (m_monitor) {
+            if (where == GRB_CB_MIP) {
+                m_monitor->observe(getDoubleInfo(GRB_CB_MIP_OBJBST), getDoubleInfo(GRB_CB_MIP_OBJBND));
+            }
+            else if (where == GRB_CB_MIPSOL) {
+                m_monitor->observe(getDoubleInfo(GRB_CB_MIPSOL_OBJBST), getDoubleInfo(GRB_CB_MIPSOL_OBJBND));
+            }
+            else if (where == GRB_CB_MIPNODE) {
+                m_monitor->observe(getDoubleInfo(GRB_CB_MIPNODE_OBJBST), getDoubleInfo(GRB_CB_MIPNODE_OBJBND));
+            }
+            if (m_monitor->stalled()) {
+                abort();
+                return;
+            }
+        }
+
+        if (where == GRB_CB_MIPSOL) {
+            onSolution();
+        }
+        else if (where == GRB_CB_MIPNODE) {
+            onNode();
+        }
+    } catch (GRBException e) {
+        printf("PlacerCallback: %s\n", e.getMessage().c_str());
+    }
+}
+
+/**
+ * @brief MIPSOL: record the new incumbent, publish it to the pool, and refine it.
+ *
+ */
+void PlacerCallback::onSolution() {
+    Placement pl(m_prob);
+    getSolutionPlacement(pl);
+    double obj = placementWirelength(m_prob, pl);
+    if (obj < m_bestObj) {
+        m_bestObj = obj;
+    }
+    if (m_pool) {
+        m_pool->offer(pl, m_memberId);
+    }
+
+    if (m_enLocalSearch && refine(pl)) {
+        m_pending = pl;
+    }
+}
+
+/**
+ * @brief MIPNODE: inject a pending or shared placement; otherwise round and refine the node relaxation.
+ *
+ */
+void PlacerCallback::onNode() {
+    if (m_separator && getIntInfo(GRB_CB_MIPNODE_STATUS) == GRB_OPTIMAL) {
+        separateCuts();
+    }
+
+    if (!m_pending.empty()) {
+        // Solutions can only be handed back at MIPNODE.
+        setPlacement(m_pending);
+        useSolution();
+        m_pending = Placement();
+        m_numInjected++;
+        printf("PlacerCallback: injected local search solution %.1f at %.1fs (%d so far)\n", m_bestObj, runtime(), m_numInjected);
+        return;
+    }
+
+    if (m_pool) {
+        Placement pl;
+        double obj;
+        if (m_pool->fetchIfNewer(m_version, pl, obj) && obj < m_bestObj - 1e-6) {
+            setPlacement(pl);
+            useSolution();
+            m_bestObj = obj;
+            return;
+        }
+    }
+
+    if (m_enLocalSearch && getIntInfo(GRB_CB_MIPNODE_STATUS) == GRB_OPTIMAL && runtime() - m_lastRelaxTime >= m_relaxInterval) {
+        m_lastRelaxTime = runtime();
+        Placement pl;
+        if (getNodeRelPlacement(pl) && refine(pl)) {
+            setPlacement(pl);
+            useSolution();
+            m_numInjected++;
+            printf("PlacerCallback: injected rounded relaxation %.1f at %.1fs (%d so far)\n", m_bestObj, runtime(), m_numInjected);
+        }
+    }
+}
+
+/**
+ * @brief Run the time-bounded local search on <pl>.
+ *
+ * @param pl
+ * @return true if the result is legal and better than the best known placement, which it then becomes.
+ */
+bool PlacerCallback::refine(Placement &pl) {
+    if (!isPlacementLegal(m_prob, pl)) {
+        return false;
+    }
+    LocalSearch ls(m_prob);
+    ls.setFixedCells(m_fixed);
+    double obj = ls.run(pl, m_lsTimeBudget);
+
+    // Keep y[0][0] <= y[last] of the one-column formulations; mirroring keeps the wirelength of unit-spaced free sites.
+    // A site geometry is not symmetric in general, and the models then have no such cut.
+    int last = m_prob.numCells() - 1;
+    if (m_x.empty() && pl.y(0) > pl.y(last) && !m_prob.strictOrderY && !m_prob.geometry) {
+        for (int c = 0; c < m_prob.numCells(); c++) {
+            pl.y(c) = m_prob.siteSizeY - 1 - pl.y(c);
+        }
+    }
+
+    if (obj < m_bestObj - 1e-6) {
+        m_bestObj = obj;
+        if (m_pool) {
+            m_pool->offer(pl, m_memberId);
+        }
+        return true;
+    }
+    return false;
+}
+
+void PlacerCallback::getSolutionPlacement(Placement &pl) {
+    int n = m_prob.numCells();
+    double *vals = getSolution(m_y.data(), n);
+    for (int c = 0; c < n; c++) {
+        pl.y(c) = (int)std::lround(vals[c]);
+    }
+    delete[] vals;
+
+    if (!m_x.empty()) {
+        vals = getSolution(m_x.data(), n);
+        for (int c = 0; c < n; c++) {
+            pl.x(c) = (int)std::lround(vals[c]);
+        }
+        delete[] vals;
+    }
+}
+
+/**
+ * @brief Round and repair the node relaxation into a legal placement.
+ *
+ * @param pl
+ * @return true if a legal placement was obtained.
+ */
+bool PlacerCallback::getNodeRelPlacement(Placement &pl) {
+    std::vector<double> relX, relY;
+    getNodeRelCoords(relX, relY);
+    return LocalSearch::roundAndRepair(m_prob, relX, relY, pl);
+}
+
+void PlacerCallback::getNodeRelCoords(std::vector<double> &relX, std::vector<double> &relY) {
+    int n = m_prob.numCells();
+    relY.resize(n);
+    double *vals = getNodeRel(m_y.data(), n);
+    std::copy(vals, vals + n, relY.begin());
+    delete[] vals;
+
+    relX.clear();
+    if (!m_x.empty()) {
+        relX.resize(n);
+        vals = getNodeRel(m_x.data(), n);
+        std::copy(vals, vals + n, relX.begin());
+        delete[] vals;
+    }
+}
+
+/**
+ * @brief MIPNODE: add the objective bound and the spread cuts violated by the node relaxation.
+ *
+ */
+void PlacerCallback::separateCuts() {
+    if (m_objBound > 0 && !m_objVars.empty()) {
+        double *vals = getNodeRel(m_objVars.data(), m_objVars.size());
+        double value = m_objConstant;
+        for (size_t k = 0; k < m_objVars.size(); k++) {
+            value += m_objCoeffs[k] * vals[k];
+        }
+        delete[] vals;
+        if (value < m_objBound - 1e-6) {
+            GRBLinExpr expr = m_objConstant;
+            expr.addTerms(m_objCoeffs.data(), m_objVars.data(), m_objVars.size());
+            addCut(expr, GRB_GREATER_EQUAL, m_objBound);
+            m_numCuts++;
+            printf("PlacerCallback: objective cut >= %.1f (relaxation %.1f) at %.1fs\n", m_objBound, value, runtime());
+        }
+    }
+
+    std::vector<double> relX, relY;
+    getNodeRelCoords(relX, relY);
+    std::vector<CutSeparator::Cut> cuts;
+    m_separator->separateSpread(relX, relY, 4, cuts);
+    for (const CutSeparator::Cut &cut: cuts) {
+        const std::vector<GRBVar> &v = cut.isY ? m_y : m_x;
+        std::vector<GRBVar> vars;
+        for (int c: cut.cells) {
+            vars.push_back(v[c]);
+        }
+        std::vector<double> ones(vars.size(), 1.0);
+        GRBLinExpr expr;
+        expr.addTerms(ones.data(), vars.data(), vars.size());
+        addCut(expr, cut.lower ? GRB_GREATER_EQUAL : GRB_LESS_EQUAL, cut.rhs);
+    }
+    m_numCuts += cuts.size();
+
+    // Log whenever the count passes a power of two.
+    if (m_numCuts >= m_nextCutLog) {
+        printf("PlacerCallback: %d user cuts at %.1fs\n", m_numCuts, runtime());
+        while (m_nextCutLog <= m_numCuts) {
+            m_nextCutLog *= 2;
+        }
+    }
+}
+
+void PlacerCallback::setPlacement(const Placement &pl) {
+    int n = m_prob.numCells();
+    std::vector<double> vals(n);
+    for (int c = 0; c < n; c++) {
+        vals[c] = pl.y(c);
+    }
+    setSolution(m_y.data(), vals.data(), n);
+
+    if (!m_x.empty()) {
+        for (int c = 0; c < n; c++) {
+            vals[c] = pl.x(c);
+        }
+        setSolution(m_x.data(), vals.data(), n);
+    }
+}
+
+double PlacerCallback::runtime() const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+    return elapsed.count();
+}
@@ -0,0 +1,111 @@
+#ifndef __SOLVERCALLBACK_H__
+#define __SOLVERCALLBACK_H__
+
+#include "gurobi_c++.h"
+#include "CutSeparator.h"
+#include "Placement.h"
+#include "SolvePhase.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+
+/**
+ * @brief Best placement shared by the concurrent solvers of a portfolio.
+ * Objectives are evaluated natively (placementWirelength()), so formulations with different objective scales compare fairly.
+ *
+ */
+class IncumbentPool
+{
+public:
+    IncumbentPool(const PlacementProblem &prob, double timeLimit);
+
+    bool    offer(const Placement &pl, int memberId);
+    bool    fetchIfNewer(int &version, Placement &pl, double &obj);
+    bool    best(Placement &pl, double &obj);
+
+    void    requestStop() { m_stop = true; }
+    bool    shouldStop() const;
+
+private:
+    PlacementProblem    m_prob;
+    std::mutex          m_mutex;
+    Placement           m_best;
+    double              m_bestObj;
+    int                 m_version = 0;
+    std::atomic<bool>   m_stop;
+    bool                m_hasDeadline = false;
+    std::chrono::steady_clock::time_point m_deadline;
+};
+
+
+/**
+ * @brief Callback installed on the run2()/run3()/run4() models. Its parts are enabled separately:
+ * - incumbent pool (portfolio): publish new incumbents (MIPSOL), inject better ones from other members (MIPNODE),
+ *   and abort when the portfolio is told to stop;
+ * - local search: refine new incumbents and rounded node relaxations natively and hand improvements back with setSolution;
+ * - stall monitor (staged solve): feed it the incumbent and bound, and abort when the current phase stalls;
+ * - user cuts: add the CutSeparator inequalities violated by the node relaxation (MIPNODE, needs PreCrush=1).
+ *
+ */
+class PlacerCallback : public GRBCallback
+{
+public:
+    PlacerCallback(const PlacementProblem &prob, const std::vector<GRBVar> &x, const std::vector<GRBVar> &y);
+
+    void    setIncumbentPool(IncumbentPool *pool, int memberId) { m_pool = pool; m_memberId = memberId; }
+    void    enableLocalSearch(double timeBudget, double relaxInterval);
+    void    setFixedCells(const std::vector<char> &fixed) { m_fixed = fixed; }
+    void    setStallMonitor(StallMonitor *monitor) { m_monitor = monitor; }
+    void    enableCuts(const CutSeparator *separator, const GRBLinExpr &objective, double objectiveBound);
+
+protected:
+    void    callback();
+
+private:
+    void    onSolution();
+    void    onNode();
+    bool    refine(Placement &pl);
+    void    getSolutionPlacement(Placement &pl);
+    bool    getNodeRelPlacement(Placement &pl);
+    void    getNodeRelCoords(std::vector<double> &relX, std::vector<double> &relY);
+    void    separateCuts();
+    void    setPlacement(const Placement &pl);
+    double  runtime() const;
+
+    PlacementProblem            m_prob;
+    const std::vector<GRBVar> & m_x; // Empty for one-column formulations.
+    const std::vector<GRBVar> & m_y;
+    double                      m_bestObj; // Native wirelength of the best placement known to this model.
+    std::chrono::steady_clock::time_point m_start;
+
+    // Incumbent pool.
+    IncumbentPool *             m_pool = nullptr;
+    int                         m_memberId = 0;
+    int                         m_version = 0;
+
+    // Local search.
+    bool                        m_enLocalSearch = false;
+    double                      m_lsTimeBudget = 1;
+    double                      m_relaxInterval = 10;
+    double                      m_lastRelaxTime = -1e100;
+    std::vector<char>           m_fixed;
+    Placement                   m_pending; // Improved placement waiting for the next MIPNODE.
+    int                         m_numInjected = 0;
+
+    // Staged solve.
+    StallMonitor *              m_monitor = nullptr;
+
+    // User cuts; the objective is kept as terms to evaluate it on node relaxations.
+    const CutSeparator *        m_separator = nullptr;
+    std::vector<GRBVar>         m_objVars;
+    std::vector<double>         m_objCoeffs;
+    double                      m_objConstant = 0;
+    double                      m_objBound = 0;
+    int                         m_numCuts = 0;
+    int                         m_nextCutLog = 1;
+};
+
+
+#endif
@@ -0,0 +1,409 @@
+#include "Spectral.h"
+#include "LocalSearch.h"
+#include <Eigen/Sparse>
+#include <Eigen/IterativeLinearSolvers>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+
+
+SpectralPlacer::SpectralPlacer(const PlacementProblem &prob)
+    : m_prob(prob)
+{}
+
+/**
+ * @brief Score the candidate orders, refine the shortest ones, then perturb the best until the time limit.
+ *
+ * @param timeLimit seconds for the whole run; <= 0: no limit, every candidate is refined and nothing perturbed.
+ * @param pl the result.
+ * @return true if <pl> is legal.
+ */
+bool SpectralPlacer::run(double timeLimit, Placement &pl) {
+    if (m_prob.siteSizeX != 1) {
+        printf("ERR: Spectral: one site column only.\n");
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+    auto remaining = [&]() {
+        return (timeLimit > 0) ? timeLimit - elapsed() : 1e100;
+    };
+
+    // Candidates are generated and scored in the first three quarters of the time limit; the Fiedler and row-major
+    // orders always.
+    const double scoreTime = (timeLimit > 0) ? 0.75 * timeLimit : -1;
+    std::vector<std::vector<int>> orders;
+    std::vector<std::string> names;
+    candidateOrders(orders, names, scoreTime);
+    std::vector<std::pair<double, int>> scored;
+    std::vector<Placement> packed(orders.size());
+    for (size_t k = 0; k < orders.size(); k++) {
+        if (names[k] != "Fiedler" && names[k] != "row bands 0" && scoreTime > 0 && elapsed() >= scoreTime) {
+            continue;
+        }
+        if (packOrder(orders[k], packed[k])) {
+            scored.push_back(std::make_pair(placementWirelength(m_prob, packed[k]), (int)k));
+        }
+    }
+    if (scored.empty()) {
+        printf("ERR: Spectral: no order fits the free rows.\n");
+        return false;
+    }
+    std::sort(scored.begin(), scored.end());
+    printf("Spectral: eigenvalue %.6g after %d iterations; best of %d orders: %s, wirelength %.1f (%.3fs)\n",
+        m_eigenvalue, m_iterations, (int)scored.size(), names[scored[0].second].c_str(), scored[0].first, elapsed());
+
+    // Refine the candidates from the shortest; the first always.
+    double bestWl = 0;
+    std::string bestName;
+    for (size_t k = 0; k < scored.size() && (k == 0 || remaining() > 0); k++) {
+        Placement cand = packed[scored[k].second];
+        double wl = LocalSearch(m_prob).run(cand, (timeLimit > 0) ? std::max(1e-3, remaining()) : -1);
+        if (k == 0 || wl < bestWl) {
+            pl = cand;
+            bestWl = wl;
+            bestName = names[scored[k].second];
+        }
+    }
+    printf("Spectral: refined wirelength %.1f from %s (%.3fs)\n", bestWl, bestName.c_str(), elapsed());
+
+    // Perturb: reverse a segment of the best order, re-extend it under the ROC and refine.
+    const int n = m_prob.numCells();
+    std::mt19937 rng(n);
+    int numKicks = 0, numImproved = 0;
+    while (timeLimit > 0 && remaining() > 0 && n > 2) {
+        std::vector<double> v(n);
+        for (int c = 0; c < n; c++) {
+            v[c] = pl.y(c);
+        }
+        const int len = std::uniform_int_distribution<int>(2, std::min(n, 4 * std::max(m_prob.arraySizeX, m_prob.arraySizeY)))(rng);
+        const double lo = std::uniform_int_distribution<int>(0, m_prob.siteSizeY - 1)(rng), hi = lo + len;
+        for (int c = 0; c < n; c++) {
+            if (v[c] >= lo && v[c] < hi) {
+                v[c] = lo + hi - v[c];
+            }
+        }
+        std::vector<int> order;
+        orderCells(v, order);
+        Placement cand;
+        numKicks++;
+        if (!packOrder(order, cand)) {
+            continue;
+        }
+        double wl = LocalSearch(m_prob).run(cand, std::max(1e-3, remaining()));
+        if (wl < bestWl - 1e-6) {
+            pl = cand;
+            bestWl = wl;
+            numImproved++;
+        }
+    }
+    if (numKicks > 0) {
+        printf("Spectral: %d perturbations (%d improving), wirelength %.1f (%.3fs)\n", numKicks, numImproved, bestWl, elapsed());
+    }
+    return isPlacementLegal(m_prob, pl);
+}
+
+/**
+ * @brief The candidate orders, each a linear extension of the ROC: the Fiedler order, row-major order, then the other
+ * band orders, row and column bands alternately.
+ *
+ * @param orders
+ * @param names one per order, for the log.
+ * @param timeLimit seconds; once over, only the Fiedler and row-major orders are still added. <= 0: no limit.
+ */
+void SpectralPlacer::candidateOrders(std::vector<std::vector<int>> &orders, std::vector<std::string> &names, double timeLimit) {
+    auto start = std::chrono::steady_clock::now();
+    auto timeLeft = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return timeLimit <= 0 || d.count() < timeLimit;
+    };
+    orders.clear();
+    names.clear();
+    std::vector<double> v;
+    if (fiedlerVector(v)) {
+        orders.push_back(std::vector<int>());
+        orderCells(v, orders.back());
+        names.push_back("Fiedler");
+    }
+    // Band widths coarse to fine, so that a cut-off list still spans them: 0, then half / 2, half / 4, 3 half / 4, ...
+    const int half = (std::max(m_prob.arraySizeX, m_prob.arraySizeY) + 1) / 2;
+    std::vector<int> widths(1, 0);
+    std::vector<char> taken(half, 0);
+    int step = 1;
+    while (2 * step < half) {
+        step *= 2;
+    }
+    for (; step >= 1; step /= 2) {
+        for (int a = step; a < half; a += step) {
+            if (!taken[a]) {
+                taken[a] = 1;
+                widths.push_back(a);
+            }
+        }
+    }
+    for (int a: widths) {
+        for (int t = 1; t >= 0; t--) {
+            const int width = t ? m_prob.arraySizeY : m_prob.arraySizeX;
+            if (2 * a >= width || ((a > 0 || t == 0) && !timeLeft())) {
+                continue;
+            }
+            bandKeys(a, t, v);
+            orders.push_back(std::vector<int>());
+            orderCells(v, orders.back());
+            names.push_back(std::string(t ? "row" : "column") + " bands " + std::to_string(a));
+        }
+    }
+}
+
+/**
+ * @brief Keys of a band order. Not transposed: the columns j < a are taken row by row, then the middle columns column
+ * by column, then the columns j >= arraySizeX - a row by row. Transposed: the same with rows and columns exchanged.
+ *
+ * @param a outer band width.
+ * @param transposed
+ * @param v key of every cell.
+ */
+void SpectralPlacer::bandKeys(int a, bool transposed, std::vector<double> &v) const {
+    const int rows = transposed ? m_prob.arraySizeX : m_prob.arraySizeY;
+    const int cols = transposed ? m_prob.arraySizeY : m_prob.arraySizeX;
+    v.resize(m_prob.numCells());
+    for (int i = 0; i < m_prob.arraySizeY; i++) {
+        for (int j = 0; j < m_prob.arraySizeX; j++) {
+            // (r, q): row and column in the (possibly transposed) frame.
+            const int r = transposed ? j : i, q = transposed ? i : j;
+            double key;
+            if (q < a) {
+                key = r * a + q;
+            }
+            else if (q < cols - a) {
+                key = rows * a + (q - a) * rows + r;
+            }
+            else {
+                key = rows * (cols - a) + r * a + (q - (cols - a));
+            }
+            v[m_prob.cellId(i, j)] = key;
+        }
+    }
+}
+
+/**
+ * @brief Pack the cells onto the free rows in <order>.
+ *
+ * @param order
+ * @param pl
+ * @return true if the result is legal.
+ */
+bool SpectralPlacer::packOrder(const std::vector<int> &order, Placement &pl) const {
+    std::vector<double> relY(m_prob.numCells());
+    for (size_t k = 0; k < order.size(); k++) {
+        relY[order[k]] = k;
+    }
+    return LocalSearch::roundAndRepair(m_prob, std::vector<double>(), relY, pl);
+}
+
+/**
+ * @brief The Fiedler vector of the mesh Laplacian, signed to increase with i + j.
+ *
+ * @param v its entry for every cell.
+ * @return true on success.
+ */
+bool SpectralPlacer::fiedlerVector(std::vector<double> &v) {
+    const int n = m_prob.numCells();
+    if (n < 2) {
+        v.assign(n, 0);
+        return n == 1;
+    }
+
+    typedef Eigen::SparseMatrix<double> SpMat;
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(5 * n);
+    std::vector<double> degree(n, 0);
+    const double w = (m_prob.weightY > 0) ? m_prob.weightY : 1;
+    auto edge = [&](int c0, int c1) {
+        triplets.push_back(Eigen::Triplet<double>(c0, c1, -w));
+        triplets.push_back(Eigen::Triplet<double>(c1, c0, -w));
+        degree[c0] += w;
+        degree[c1] += w;
+    };
+    for (int i = 0; i < m_prob.arraySizeY; i++) {
+        for (int j = 0; j < m_prob.arraySizeX; j++) {
+            const int c = m_prob.cellId(i, j);
+            if (j + 1 < m_prob.arraySizeX) edge(c, c + 1);
+            if (i + 1 < m_prob.arraySizeY) edge(c, c + m_prob.arraySizeX);
+        }
+    }
+    // A tiny shift keeps the singular Laplacian positive definite; the constant vector is projected out anyway.
+    for (int c = 0; c < n; c++) {
+        triplets.push_back(Eigen::Triplet<double>(c, c, degree[c] + 1e-9 * w));
+    }
+    SpMat lap(n, n);
+    lap.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen::ConjugateGradient<SpMat, Eigen::Lower | Eigen::Upper> cg;
+    cg.setTolerance(1e-8);
+    cg.compute(lap);
+    if (cg.info() != Eigen::Success) {
+        return false;
+    }
+
+    auto normalize = [](Eigen::VectorXd &x) {
+        x.array() -= x.mean();
+        const double norm = x.norm();
+        if (norm > 0) {
+            x /= norm;
+        }
+        return norm > 0;
+    };
+    Eigen::VectorXd x(n);
+    for (int c = 0; c < n; c++) {
+        x[c] = c / m_prob.arraySizeX + c % m_prob.arraySizeX;
+    }
+    if (!normalize(x)) {
+        return false;
+    }
+    double lambda = x.dot(lap * x);
+    for (m_iterations = 1; m_iterations <= m_maxIterations; m_iterations++) {
+        Eigen::VectorXd y = cg.solveWithGuess(x, x / std::max(lambda, 1e-12));
+        if (!normalize(y)) {
+            return false;
+        }
+        x = y;
+        const double next = x.dot(lap * x);
+        const bool converged = std::fabs(lambda - next) <= m_tol * next;
+        lambda = next;
+        if (converged) {
+            break;
+        }
+    }
+    m_iterations = std::min(m_iterations, m_maxIterations);
+    m_eigenvalue = lambda;
+
+    // Sign: along the array diagonal, like the ROC.
+    double corr = 0;
+    for (int c = 0; c < n; c++) {
+        corr += x[c] * (c / m_prob.arraySizeX + c % m_prob.arraySizeX);
+    }
+    v.resize(n);
+    for (int c = 0; c < n; c++) {
+        v[c] = (corr < 0) ? -x[c] : x[c];
+    }
+    return true;
+}
+
+/**
+ * @brief The cells by increasing <v> as far as the ROC allows: a cell is ready once its predecessors in the array
+ * (the cell below under the ROC in Y, and the cell to the left under the strict one-column order) are taken, and the
+ * ready cell with the smallest value goes next.
+ *
+ * @param v
+ * @param order
+ */
+void SpectralPlacer::orderCells(const std::vector<double> &v, std::vector<int> &order) const {
+    const int n = m_prob.numCells();
+    const bool colOrder = m_prob.relativeConstraintY || m_prob.strictOrderY;
+    const bool rowOrder = m_prob.strictOrderY;
+    std::vector<int> waiting(n, 0);
+    for (int i = 0; i < m_prob.arraySizeY; i++) {
+        for (int j = 0; j < m_prob.arraySizeX; j++) {
+            waiting[m_prob.cellId(i, j)] = (colOrder && i > 0) + (rowOrder && j > 0);
+        }
+    }
+
+    typedef std::pair<double, int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> ready;
+    for (int c = 0; c < n; c++) {
+        if (waiting[c] == 0) {
+            ready.push(Item(v[c], c));
+        }
+    }
+    order.clear();
+    while (!ready.empty()) {
+        const int c = ready.top().second;
+        ready.pop();
+        order.push_back(c);
+        const int i = c / m_prob.arraySizeX, j = c % m_prob.arraySizeX;
+        if (colOrder && i + 1 < m_prob.arraySizeY && --waiting[c + m_prob.arraySizeX] == 0) {
+            ready.push(Item(v[c + m_prob.arraySizeX], c + m_prob.arraySizeX));
+        }
+        if (rowOrder && j + 1 < m_prob.arraySizeX && --waiting[c + 1] == 0) {
+            ready.push(Item(v[c + 1], c + 1));
+        }
+    }
+}
+
+
+/**
+ * @brief Time the stages of SpectralPlacer on <prob> and compare with row-major order and the heur2 solution
+ * shipped in input/ for the shape, if any.
+ *
+ * @param prob
+ * @param seconds time limit of SpectralPlacer::run().
+ */
+void benchmarkSpectral(const PlacementProblem &prob, double seconds) {
+    printf("Spectral benchmark: %d x %d => %d x %d, weights %g / %g, ROC %d\n", prob.arraySizeY, prob.arraySizeX,
+        prob.siteSizeY, prob.siteSizeX, prob.weightX, prob.weightY, (int)prob.strictOrderY);
+    if (prob.siteSizeX != 1 || prob.numCells() > prob.numSites() || prob.numCells() == 0) {
+        printf("ERR: invalid benchmark size.\n");
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto lap = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        return d.count();
+    };
+    SpectralPlacer spectral(prob);
+    std::vector<std::vector<int>> orders;
+    std::vector<std::string> names;
+    spectral.candidateOrders(orders, names);
+    printf("  Fiedler vector: eigenvalue %.6g, %d iterations; %d candidate orders, %.3fs\n", spectral.eigenvalue(),
+        spectral.iterations(), (int)orders.size(), lap());
+    double bestWl = 0;
+    std::string bestName;
+    for (size_t k = 0; k < orders.size(); k++) {
+        Placement pl;
+        if (!spectral.packOrder(orders[k], pl)) {
+            continue;
+        }
+        double wl = placementWirelength(prob, pl);
+        if (names[k] == "Fiedler" || names[k] == "row bands 0") {
+            printf("  %s order: wirelength %.1f\n", (names[k] == "Fiedler") ? "Fiedler" : "row-major", wl);
+        }
+        if (bestName.empty() || wl < bestWl) {
+            bestWl = wl;
+            bestName = names[k];
+        }
+    }
+    printf("  best order: %s, wirelength %.1f, %.3fs\n", bestName.c_str(), bestWl, lap());
+
+    Placement pl;
+    if (spectral.run(seconds, pl)) {
+        printf("  run(%gs): wirelength %.1f, legal %d, %.3fs\n", seconds, placementWirelength(prob, pl),
+            (int)isPlacementLegal(prob, pl), lap());
+    }
+
+    std::vector<double> v;
+    spectral.bandKeys(0, true, v);
+    std::vector<int> order;
+    spectral.orderCells(v, order);
+    Placement rowMajor;
+    if (spectral.packOrder(order, rowMajor)) {
+        double wl = LocalSearch(prob).run(rowMajor, -1);
+        printf("  row-major refined: wirelength %.1f, %.3fs\n", wl, lap());
+    }
+
+    std::string heur2 = "input/macroPl_" + std::to_string(prob.arraySizeY) + "_" + std::to_string(prob.arraySizeX)
+                        + "_to_" + std::to_string(prob.siteSizeY) + "_1_heur2.sol";
+    Placement ref;
+    if (readPlacementFromSol(heur2, prob, ref)) {
+        printf("  %s: wirelength %.1f, legal %d\n", heur2.c_str(), placementWirelength(prob, ref), (int)isPlacementLegal(prob, ref));
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef __SPECTRAL_H__
+#define __SPECTRAL_H__
+
+#include "Placement.h"
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Ordering engine for one site column. The job is then a weighted linear arrangement of the array mesh
+ * (every edge costs weightY per row between its cells). Candidate orders are scored and the best ones refined:
+ * - the Fiedler vector of the mesh Laplacian, found by inverse iteration (Eigen's sparse conjugate gradient solves
+ *   on the complement of the constant vector) from i + j. On a square array the second eigenvalue is double and
+ *   this picks the diagonal vector of its eigenspace;
+ * - axis-aligned band orders: the outer bands of a cells along both sides taken row by row (column by column), the
+ *   middle band column by column (row by row). a = 0 gives column-major (row-major) order; the heur2 solutions
+ *   shipped in input/ are of this kind.
+ * Each candidate is taken as far as the ROC allows: a linear extension, with a priority queue choosing among the
+ * ready cells. It is packed onto the free rows, and the shortest ones are refined by LocalSearch. With a time limit,
+ * candidates beyond the Fiedler and row-major orders are only generated and scored in its first three quarters.
+ * The rest of the time goes to perturbations of the best order (a reversed segment, re-extended and refined).
+ *
+ */
+class SpectralPlacer
+{
+public:
+    explicit SpectralPlacer(const PlacementProblem &prob);
+
+    void    setMaxIterations(int iterations) { m_maxIterations = iterations; }
+    void    setTolerance(double tol) { m_tol = tol; }
+
+    bool    run(double timeLimit, Placement &pl);
+    void    candidateOrders(std::vector<std::vector<int>> &orders, std::vector<std::string> &names, double timeLimit = -1);
+    bool    fiedlerVector(std::vector<double> &v);
+    void    orderCells(const std::vector<double> &v, std::vector<int> &order) const;
+    void    bandKeys(int a, bool transposed, std::vector<double> &v) const;
+    bool    packOrder(const std::vector<int> &order, Placement &pl) const;
+    double  eigenvalue() const { return m_eigenvalue; }
+    int     iterations() const { return m_iterations; }
+
+private:
+    PlacementProblem    m_prob;
+    int                 m_maxIterations = 50;
+    double              m_tol = 1e-5; // relative change of the Rayleigh quotient at convergence.
+    double              m_eigenvalue = 0;
+    int                 m_iterations = 0;
+};
+
+void    benchmarkSpectral(const PlacementProblem &prob, double seconds);
+
+
+#endif
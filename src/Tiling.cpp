@@ -0,0 +1,263 @@
+#include "Tiling.h"
+#include "LocalSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+
+TilePlacer::TilePlacer(const PlacementProblem &prob, ExactSolver solver)
+    : m_prob(prob), m_solver(solver)
+{}
+
+/**
+ * @brief Solve the tile, replicate it over the array and stitch the copies.
+ *
+ * @param timeLimit seconds in total; <= 0 for no limit.
+ * @param pl the resulting placement of the array.
+ * @return true if a legal placement was found.
+ */
+bool TilePlacer::run(double timeLimit, Placement &pl) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    };
+    // LocalSearch runs to convergence for a limit <= 0, so an exhausted budget still passes a positive one.
+    auto remaining = [&](double fraction) {
+        return (timeLimit > 0) ? std::max(1e-3, (timeLimit - elapsed()) * fraction) : -1;
+    };
+
+    PlacementProblem tile;
+    if (!tileProblem(tile)) {
+        printf("ERR: Tiling: no tile%s fits the %d x %d sites.\n",
+            (m_tileRows > 0 && m_tileCols > 0) ? " of the given size" : "", m_prob.siteSizeY, m_prob.siteSizeX);
+        return false;
+    }
+    printf("Tiling: %d x %d tiles of %d x %d cells, each on %d x %d sites (%.2fs)\n",
+        m_tilesY, m_tilesX, m_rows, m_cols, m_blockY, m_blockX, elapsed());
+
+    // The tile: refined start, then solved exactly. The exact tile is kept only if it also replicates shorter.
+    Placement tilePl;
+    Layout layout;
+    if (!placeTile(tile, tilePl) || !replicateBest(tilePl, pl, layout)) {
+        printf("ERR: Tiling: no legal replication of the tile.\n");
+        return false;
+    }
+    double tileTime = (timeLimit > 0) ? timeLimit * m_tileTimeFraction : -1;
+    Placement exact, exactPl;
+    Layout exactLayout;
+    if (m_solver && m_solver(tile, tileTime, &tilePl, exact) && isPlacementLegal(tile, exact)
+        && replicateBest(exact, exactPl, exactLayout) && placementWirelength(m_prob, exactPl) <= placementWirelength(m_prob, pl)) {
+        tilePl = exact;
+        pl = exactPl;
+        layout = exactLayout;
+    }
+    printf("Tiling: tile solved, wirelength %.1f (%.2fs)\n", placementWirelength(tile, tilePl), elapsed());
+    printf("Tiling: replicated, wirelength %.1f (%s, mirror y %d, mirror x %d)\n", placementWirelength(m_prob, pl),
+        layout.columnMajor ? "column-major" : "row-major", layout.mirrorY, layout.mirrorX);
+
+    // Stitch: the cells next to a seam first, then everything.
+    LocalSearch seams(m_prob);
+    seams.setFixedCells(seamFixedCells());
+    double wl = seams.run(pl, remaining(0.5));
+    printf("Tiling: seams refined, wirelength %.1f (%.2fs)\n", wl, elapsed());
+    wl = LocalSearch(m_prob).run(pl, remaining(1));
+    printf("Tiling: refined, wirelength %.1f (%.2fs)\n", wl, elapsed());
+
+    return isPlacementLegal(m_prob, pl);
+}
+
+/**
+ * @brief The problem the exact solver gets for the tile; chooses the tile shape unless given.
+ *
+ * @param tile
+ * @return false if no tile fits the sites.
+ */
+bool TilePlacer::tileProblem(PlacementProblem &tile) {
+    if (!chooseTile()) {
+        return false;
+    }
+    tile = makeTileProblem();
+    return true;
+}
+
+/**
+ * @brief Use a rows x cols tile: count the tiles and cut the site block of one tile.
+ *
+ * @param rows
+ * @param cols
+ * @return false if the tile's cells do not fit its block.
+ */
+bool TilePlacer::setShape(int rows, int cols) {
+    m_rows = rows;
+    m_cols = cols;
+    m_tilesY = (m_prob.arraySizeY + rows - 1) / rows;
+    m_tilesX = (m_prob.arraySizeX + cols - 1) / cols;
+    if (m_prob.siteSizeX == 1) {
+        m_blockY = m_prob.siteSizeY / (m_tilesY * m_tilesX);
+        m_blockX = 1;
+    }
+    else {
+        m_blockY = m_prob.siteSizeY / m_tilesY;
+        m_blockX = m_prob.siteSizeX / m_tilesX;
+    }
+    return m_blockY * m_blockX >= rows * cols;
+}
+
+PlacementProblem TilePlacer::makeTileProblem() const {
+    PlacementProblem tile = m_prob;
+    tile.arraySizeY = m_rows;
+    tile.arraySizeX = m_cols;
+    tile.siteSizeY = m_blockY;
+    tile.siteSizeX = m_blockX;
+    // Blocks are cut from the site grid by index, so the tile is solved on unit-spaced, unblocked sites.
+    tile.geometry.reset();
+    return tile;
+}
+
+/**
+ * @brief Pick the tile shape unless given: among the shapes of at most m_maxTileCells cells that fit, the one whose
+ * LocalSearch tile replicates to the shortest wirelength, ties to the larger tile.
+ *
+ * @return false if no tile fits.
+ */
+bool TilePlacer::chooseTile() {
+    const int Y = m_prob.arraySizeY, X = m_prob.arraySizeX;
+    if (m_tileRows > 0 && m_tileCols > 0) {
+        return setShape(std::min(m_tileRows, Y), std::min(m_tileCols, X));
+    }
+
+    int bestRows = 0, bestCols = 0;
+    double bestWl = 0;
+    for (int rows = 1; rows <= Y; rows++) {
+        if (m_tileRows > 0 && rows != std::min(m_tileRows, Y)) {
+            continue;
+        }
+        for (int cols = 1; cols <= X; cols++) {
+            if ((m_tileCols > 0 && cols != std::min(m_tileCols, X)) || rows * cols > m_maxTileCells || !setShape(rows, cols)) {
+                continue;
+            }
+            Placement tilePl, pl;
+            Layout layout;
+            if (!placeTile(makeTileProblem(), tilePl) || !replicateBest(tilePl, pl, layout)) {
+                continue;
+            }
+            double wl = placementWirelength(m_prob, pl);
+            if (bestRows == 0 || wl < bestWl || (wl == bestWl && rows * cols > bestRows * bestCols)) {
+                bestRows = rows;
+                bestCols = cols;
+                bestWl = wl;
+            }
+        }
+    }
+    if (bestRows == 0) {
+        return false;
+    }
+    setShape(bestRows, bestCols);
+    return true;
+}
+
+/**
+ * @brief Constructive tile placement refined by LocalSearch.
+ *
+ * @param tile
+ * @param tilePl
+ * @return true if legal.
+ */
+bool TilePlacer::placeTile(const PlacementProblem &tile, Placement &tilePl) const {
+    if (!LocalSearch::initialPlacement(tile, tilePl)) {
+        return false;
+    }
+    LocalSearch(tile).run(tilePl, -1);
+    return isPlacementLegal(tile, tilePl);
+}
+
+/**
+ * @brief Replicate the tile in every layout (tile order, mirroring) and keep the legal one with the shortest wirelength.
+ *
+ * @param tilePl
+ * @param pl
+ * @param layout
+ * @return false if no layout is legal.
+ */
+bool TilePlacer::replicateBest(const Placement &tilePl, Placement &pl, Layout &layout) const {
+    const int numOrders = (m_prob.siteSizeX == 1 && m_tilesY > 1 && m_tilesX > 1) ? 2 : 1;
+    bool found = false;
+    double bestWl = 0;
+    Placement cand;
+    for (int order = 0; order < numOrders; order++) {
+        for (int mirror = 0; mirror < 4; mirror++) {
+            Layout l;
+            l.columnMajor = order;
+            l.mirrorY = (mirror & 1);
+            l.mirrorX = (mirror & 2);
+            if ((l.mirrorY && m_tilesY == 1) || (l.mirrorX && m_tilesX == 1)) {
+                continue;
+            }
+            replicate(tilePl, l, cand);
+            if (!isPlacementLegal(m_prob, cand)) {
+                continue;
+            }
+            double wl = placementWirelength(m_prob, cand);
+            if (!found || wl < bestWl) {
+                found = true;
+                bestWl = wl;
+                layout = l;
+                pl = cand;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Copy the tile placement to every tile. A mirrored tile reflects both its cells and its site block, so
+ * the cells on its boundary stay next to the same-numbered cells of its unmirrored neighbor.
+ *
+ * @param tilePl
+ * @param layout
+ * @param pl
+ */
+void TilePlacer::replicate(const Placement &tilePl, const Layout &layout, Placement &pl) const {
+    const int k = m_rows, l = m_cols;
+    pl.resize(m_prob);
+    for (int i = 0; i < m_prob.arraySizeY; i++) {
+        for (int j = 0; j < m_prob.arraySizeX; j++) {
+            const int ti = i / k, tj = j / l;
+            const bool fy = layout.mirrorY && (ti & 1);
+            const bool fx = layout.mirrorX && (tj & 1);
+            const int r = fy ? k - 1 - i % k : i % k;
+            const int c = fx ? l - 1 - j % l : j % l;
+            const int sy = tilePl.y(r * l + c), sx = tilePl.x(r * l + c);
+
+            const int cell = m_prob.cellId(i, j);
+            if (m_prob.siteSizeX == 1) {
+                const int block = layout.columnMajor ? tj * m_tilesY + ti : ti * m_tilesX + tj;
+                pl.y(cell) = block * m_blockY + ((fy != fx) ? m_blockY - 1 - sy : sy);
+                pl.x(cell) = 0;
+            }
+            else {
+                pl.y(cell) = ti * m_blockY + (fy ? m_blockY - 1 - sy : sy);
+                pl.x(cell) = tj * m_blockX + (fx ? m_blockX - 1 - sx : sx);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Cells not on a tile boundary, fixed for the seam pass.
+ *
+ * @return std::vector<char>
+ */
+std::vector<char> TilePlacer::seamFixedCells() const {
+    std::vector<char> fixed(m_prob.numCells(), 1);
+    for (int i = 0; i < m_prob.arraySizeY; i++) {
+        for (int j = 0; j < m_prob.arraySizeX; j++) {
+            const int r = i % m_rows, c = j % m_cols;
+            if (r == 0 || r == m_rows - 1 || c == 0 || c == m_cols - 1) {
+                fixed[m_prob.cellId(i, j)] = 0;
+            }
+        }
+    }
+    return fixed;
+}
@@ -0,0 +1,70 @@
+#ifndef __TILING_H__
+#define __TILING_H__
+
+#include "Placement.h"
+#include <functional>
+#include <vector>
+
+
+/**
+ * @brief Periodic tile replication for large regular arrays.
+ * A tileRows x tileCols tile of cells is placed exactly on one site block, and the tile placement is copied to every
+ * tile of the array, each tile on its own block. With several site columns the blocks form a grid like the tiles;
+ * with one site column the blocks are stacked in row-major or column-major tile order (both keep the ROC).
+ * Copies may be mirrored on odd tile rows / columns, so that facing tile boundaries meet on nearby sites.
+ * Unless given, the tile shape is chosen by trial: every shape up to maxTileCells cells is placed by LocalSearch and
+ * replicated, and the shape with the shortest replicated wirelength is solved exactly, so seam lengths decide the
+ * shape and not the tile alone.
+ * Stitching evaluates every legal order / mirroring, keeps the shortest, then refines the cells next to a seam
+ * with all others fixed, and finally the whole array, with LocalSearch.
+ * The exact solve sees tileRows * tileCols cells however large the array is.
+ *
+ */
+class TilePlacer
+{
+public:
+    // Exact solver of the tile: (problem, time limit, start or nullptr, result) -> success.
+    typedef std::function<bool(const PlacementProblem &, double, const Placement *, Placement &)> ExactSolver;
+
+    TilePlacer(const PlacementProblem &prob, ExactSolver solver);
+
+    void    setTileSize(int rows, int cols) { m_tileRows = rows; m_tileCols = cols; }
+    void    setMaxTileCells(int numCells) { m_maxTileCells = numCells; }
+    void    setTileTimeFraction(double fraction) { m_tileTimeFraction = fraction; }
+
+    bool    run(double timeLimit, Placement &pl);
+    bool    tileProblem(PlacementProblem &tile);
+
+private:
+    struct Layout {
+        bool    columnMajor = false; // One site column: tiles stacked column by column.
+        bool    mirrorY = false; // Odd tile rows mirrored.
+        bool    mirrorX = false; // Odd tile columns mirrored.
+    };
+
+    bool    chooseTile();
+    bool    setShape(int rows, int cols);
+    PlacementProblem makeTileProblem() const;
+    bool    placeTile(const PlacementProblem &tile, Placement &tilePl) const;
+    bool    replicateBest(const Placement &tilePl, Placement &pl, Layout &layout) const;
+    void    replicate(const Placement &tilePl, const Layout &layout, Placement &pl) const;
+    std::vector<char> seamFixedCells() const;
+
+    PlacementProblem    m_prob;
+    ExactSolver         m_solver;
+    int                 m_tileRows = 0; // 0: chosen by chooseTile().
+    int                 m_tileCols = 0;
+    int                 m_maxTileCells = 16;
+    double              m_tileTimeFraction = 0.5;
+
+    // Set by setShape().
+    int                 m_rows = 0; // Tile size.
+    int                 m_cols = 0;
+    int                 m_tilesY = 0;
+    int                 m_tilesX = 0;
+    int                 m_blockY = 0; // Site block of one tile.
+    int                 m_blockX = 0;
+};
+
+
+#endif
@@ -0,0 +1,259 @@
+#include "WirelengthBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WL_BATCH_X86
+#endif
+
+
+WirelengthBatch::WirelengthBatch(const PlacementProblem &prob)
+    : m_prob(prob)
+{
+    for (int i = 0; i < prob.arraySizeY; i++) {
+        for (int j = 0; j < prob.arraySizeX; j++) {
+            // top neighbor.
+            if (i + 1 < prob.arraySizeY) {
+                m_edge0.push_back(prob.cellId(i, j));
+                m_edge1.push_back(prob.cellId(i + 1, j));
+            }
+            // right neighbor.
+            if (j + 1 < prob.arraySizeX) {
+                m_edge0.push_back(prob.cellId(i, j));
+                m_edge1.push_back(prob.cellId(i, j + 1));
+            }
+        }
+    }
+    m_useSimd = simdSupported();
+}
+
+bool WirelengthBatch::simdSupported() {
+#ifdef WL_BATCH_X86
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Wirelength of every candidate of a structure-of-arrays batch.
+ *
+ * @param xs x of cell c in candidate b at xs[c * batchSize + b].
+ * @param ys y, same layout.
+ * @param batchSize
+ * @param wl output, batchSize entries.
+ */
+void WirelengthBatch::evaluate(const int *xs, const int *ys, int batchSize, double *wl) const {
+    int done = 0;
+    // The AVX2 kernel sums integer distances; with a site geometry the scalar kernel looks them up.
+    if (m_useSimd && !m_prob.geometry) {
+        done = evaluateAvx2(xs, ys, batchSize, wl);
+    }
+    evaluateScalar(xs, ys, batchSize, done, batchSize, wl);
+}
+
+/**
+ * @brief Wirelength of every placement in <pls>, packed into a batch first.
+ *
+ * @param pls
+ * @param wl
+ */
+void WirelengthBatch::evaluate(const std::vector<Placement> &pls, std::vector<double> &wl) const {
+    const int batchSize = pls.size();
+    const int numCells = m_prob.numCells();
+    std::vector<int> xs((size_t)numCells * batchSize), ys((size_t)numCells * batchSize);
+    for (int b = 0; b < batchSize; b++) {
+        for (int c = 0; c < numCells; c++) {
+            xs[(size_t)c * batchSize + b] = pls[b].x(c);
+            ys[(size_t)c * batchSize + b] = pls[b].y(c);
+        }
+    }
+    wl.resize(batchSize);
+    evaluate(xs.data(), ys.data(), batchSize, wl.data());
+}
+
+/**
+ * @brief Candidates [begin, end) of the batch, edge by edge so the inner loop runs over contiguous candidates.
+ *
+ */
+void WirelengthBatch::evaluateScalar(const int *xs, const int *ys, int batchSize, int begin, int end, double *wl) const {
+    if (begin >= end) {
+        return;
+    }
+    std::vector<double> sumX(end - begin, 0), sumY(end - begin, 0);
+    const SiteGeometry *geom = m_prob.geometry.get();
+    for (size_t e = 0; e < m_edge0.size(); e++) {
+        const int *x0 = xs + (size_t)m_edge0[e] * batchSize;
+        const int *x1 = xs + (size_t)m_edge1[e] * batchSize;
+        const int *y0 = ys + (size_t)m_edge0[e] * batchSize;
+        const int *y1 = ys + (size_t)m_edge1[e] * batchSize;
+        if (geom) {
+            for (int b = begin; b < end; b++) {
+                sumX[b - begin] += geom->distX(x0[b], x1[b]);
+                sumY[b - begin] += geom->distY(y0[b], y1[b]);
+            }
+        }
+        else {
+            for (int b = begin; b < end; b++) {
+                sumX[b - begin] += abs(x0[b] - x1[b]);
+                sumY[b - begin] += abs(y0[b] - y1[b]);
+            }
+        }
+    }
+    for (int b = begin; b < end; b++) {
+        wl[b] = m_prob.weightX * sumX[b - begin] + m_prob.weightY * sumY[b - begin];
+    }
+}
+
+#ifdef WL_BATCH_X86
+/**
+ * @brief AVX2 kernel: 16 candidates per iteration as two 8-lane vectors of 32-bit |dx| and |dy| sums.
+ * The 32-bit sums are flushed to double every kFlushEdges edges, so they cannot overflow for site coordinates below 2^16.
+ *
+ */
+__attribute__((target("avx2")))
+static void wlBatchAvx2Block(const int *xs, const int *ys, size_t batchSize, int b0,
+                             const std::vector<int> &edge0, const std::vector<int> &edge1, double *sumX, double *sumY) {
+    const size_t kFlushEdges = 1 << 14;
+    const size_t numEdges = edge0.size();
+    for (size_t eBegin = 0; eBegin < numEdges; eBegin += kFlushEdges) {
+        size_t eEnd = std::min(numEdges, eBegin + kFlushEdges);
+        __m256i ax0 = _mm256_setzero_si256(), ax1 = _mm256_setzero_si256();
+        __m256i ay0 = _mm256_setzero_si256(), ay1 = _mm256_setzero_si256();
+        for (size_t e = eBegin; e < eEnd; e++) {
+            const int *px0 = xs + edge0[e] * batchSize + b0;
+            const int *px1 = xs + edge1[e] * batchSize + b0;
+            const int *py0 = ys + edge0[e] * batchSize + b0;
+            const int *py1 = ys + edge1[e] * batchSize + b0;
+            __m256i dx0 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)px0), _mm256_loadu_si256((const __m256i *)px1));
+            __m256i dx1 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(px0 + 8)), _mm256_loadu_si256((const __m256i *)(px1 + 8)));
+            __m256i dy0 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)py0), _mm256_loadu_si256((const __m256i *)py1));
+            __m256i dy1 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(py0 + 8)), _mm256_loadu_si256((const __m256i *)(py1 + 8)));
+            ax0 = _mm256_add_epi32(ax0, _mm256_abs_epi32(dx0));
+            ax1 = _mm256_add_epi32(ax1, _mm256_abs_epi32(dx1));
+            ay0 = _mm256_add_epi32(ay0, _mm256_abs_epi32(dy0));
+            ay1 = _mm256_add_epi32(ay1, _mm256_abs_epi32(dy1));
+        }
+        alignas(32) int lx[16], ly[16];
+        _mm256_store_si256((__m256i *)lx, ax0);
+        _mm256_store_si256((__m256i *)(lx + 8), ax1);
+        _mm256_store_si256((__m256i *)ly, ay0);
+        _mm256_store_si256((__m256i *)(ly + 8), ay1);
+        for (int k = 0; k < 16; k++) {
+            sumX[k] += lx[k];
+            sumY[k] += ly[k];
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Evaluate the batch in blocks of 16 candidates with the AVX2 kernel.
+ *
+ * @return int the number of leading candidates evaluated (a multiple of 16); the rest is left to the scalar kernel.
+ */
+int WirelengthBatch::evaluateAvx2(const int *xs, const int *ys, int batchSize, double *wl) const {
+#ifdef WL_BATCH_X86
+    int b0 = 0;
+    for (; b0 + 16 <= batchSize; b0 += 16) {
+        double sumX[16] = {0}, sumY[16] = {0};
+        wlBatchAvx2Block(xs, ys, batchSize, b0, m_edge0, m_edge1, sumX, sumY);
+        for (int k = 0; k < 16; k++) {
+            wl[b0 + k] = m_prob.weightX * sumX[k] + m_prob.weightY * sumY[k];
+        }
+    }
+    return b0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Throughput of placementWirelength() in a loop against the scalar and AVX2 batch kernels on random placements.
+ *
+ * @param prob
+ * @param batchSize candidates per batch.
+ * @param seconds run time of each variant.
+ */
+void benchmarkWirelengthBatch(const PlacementProblem &prob, int batchSize, double seconds) {
+    const int numCells = prob.numCells();
+    printf("Wirelength benchmark: %d x %d => %d x %d, batch of %d, %.1fs per variant, AVX2 %s\n",
+        prob.arraySizeY, prob.arraySizeX, prob.siteSizeY, prob.siteSizeX, batchSize, seconds,
+        WirelengthBatch::simdSupported() ? "available" : "not available");
+    if (numCells > prob.numSites() || batchSize <= 0) {
+        printf("ERR: invalid benchmark size.\n");
+        return;
+    }
+
+    // Random overlap-free placements.
+    std::mt19937 rng(1);
+    std::vector<int> sites(prob.numSites());
+    for (size_t s = 0; s < sites.size(); s++) {
+        sites[s] = s;
+    }
+    std::vector<Placement> pls(batchSize, Placement(prob));
+    for (int b = 0; b < batchSize; b++) {
+        std::shuffle(sites.begin(), sites.end(), rng);
+        for (int c = 0; c < numCells; c++) {
+            pls[b].y(c) = sites[c] / prob.siteSizeX;
+            pls[b].x(c) = sites[c] % prob.siteSizeX;
+        }
+    }
+    std::vector<int> xs((size_t)numCells * batchSize), ys((size_t)numCells * batchSize);
+    for (int b = 0; b < batchSize; b++) {
+        for (int c = 0; c < numCells; c++) {
+            xs[(size_t)c * batchSize + b] = pls[b].x(c);
+            ys[(size_t)c * batchSize + b] = pls[b].y(c);
+        }
+    }
+
+    std::vector<double> ref(batchSize);
+    for (int b = 0; b < batchSize; b++) {
+        ref[b] = placementWirelength(prob, pls[b]);
+    }
+
+    auto timeIt = [&](const char *name, std::function<void(std::vector<double> &)> body) {
+        std::vector<double> wl(batchSize, 0);
+        long long evals = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        while (elapsed < seconds) {
+            body(wl);
+            evals += batchSize;
+            std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+            elapsed = d.count();
+        }
+        double maxErr = 0;
+        for (int b = 0; b < batchSize; b++) {
+            maxErr = std::max(maxErr, std::fabs(wl[b] - ref[b]));
+        }
+        printf("  %-28s %12.0f evals/s  (max error %g)\n", name, evals / elapsed, maxErr);
+        return evals / elapsed;
+    };
+
+    double base = timeIt("placementWirelength loop", [&](std::vector<double> &wl) {
+        for (int b = 0; b < batchSize; b++) {
+            wl[b] = placementWirelength(prob, pls[b]);
+        }
+    });
+
+    WirelengthBatch batch(prob);
+    batch.setUseSimd(false);
+    double scalar = timeIt("batch, scalar kernel", [&](std::vector<double> &wl) {
+        batch.evaluate(xs.data(), ys.data(), batchSize, wl.data());
+    });
+
+    if (WirelengthBatch::simdSupported()) {
+        batch.setUseSimd(true);
+        double simd = timeIt("batch, AVX2 kernel", [&](std::vector<double> &wl) {
+            batch.evaluate(xs.data(), ys.data(), batchSize, wl.data());
+        });
+        printf("  AVX2 speedup: %.2fx over the loop, %.2fx over the scalar kernel\n", simd / base, simd / scalar);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef __WIRELENGTHBATCH_H__
+#define __WIRELENGTHBATCH_H__
+
+#include "Placement.h"
+#include <vector>
+
+
+/**
+ * @brief Weighted Manhattan wirelength of run2() (sum of weightX*|dx| + weightY*|dy| over the array neighbor edges)
+ * for a batch of candidate placements at once.
+ * The batch is structure-of-arrays: the coordinate of cell c in candidate b is at index c * batchSize + b, so one edge
+ * covers 8 candidates per AVX2 instruction (16 per loop iteration). The AVX2 kernel is chosen at runtime if the CPU
+ * supports it and the sites are unit-spaced; otherwise, and for the tail of the batch, the scalar kernel is used
+ * (with the distance tables of the site geometry, if any).
+ *
+ */
+class WirelengthBatch
+{
+public:
+    explicit WirelengthBatch(const PlacementProblem &prob);
+
+    void    setUseSimd(bool b) { m_useSimd = b && simdSupported(); }
+    bool    useSimd() const { return m_useSimd; }
+
+    void    evaluate(const int *xs, const int *ys, int batchSize, double *wl) const;
+    void    evaluate(const std::vector<Placement> &pls, std::vector<double> &wl) const;
+
+    static bool simdSupported();
+
+private:
+    void    evaluateScalar(const int *xs, const int *ys, int batchSize, int begin, int end, double *wl) const;
+    int     evaluateAvx2(const int *xs, const int *ys, int batchSize, double *wl) const;
+
+    PlacementProblem    m_prob;
+    std::vector<int>    m_edge0; // Array neighbor edges (cell ids), top and right neighbors of every cell.
+    std::vector<int>    m_edge1;
+    bool                m_useSimd = false;
+};
+
+
+void    benchmarkWirelengthBatch(const PlacementProblem &prob, int batchSize, double seconds);
+
+
+#endif
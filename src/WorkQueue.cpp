@@ -0,0 +1,397 @@
+#include "WorkQueue.h"
+#include "util.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utime.h>
+
+
+namespace {
+
+const char *kSubDirs[] = {"pending", "claimed", "done", "results", "tmp"};
+
+double mtimeOf(const struct stat &st) {
+    return st.st_mtim.tv_sec + 1e-9 * st.st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Sequence number of a queue file name "<seq>_<name>.job[...]", -1 if it has none.
+ *
+ */
+int seqOf(const std::string &file) {
+    return isdigit(file[0]) ? atoi(file.c_str()) : -1;
+}
+
+} // namespace
+
+
+WorkQueue::WorkQueue(const std::string &dir)
+    : m_dir(dir)
+{
+    char host[256] = "host";
+    gethostname(host, sizeof(host) - 1);
+    m_workerId = std::string(host) + "." + std::to_string(getpid());
+}
+
+/**
+ * @brief Set how often a worker touches its claim and after how long without a touch a claim counts as dead.
+ *
+ * @param interval seconds.
+ * @param staleAfter seconds; should be several intervals.
+ */
+void WorkQueue::setHeartbeat(double interval, double staleAfter) {
+    m_heartbeatInterval = std::max(1.0, interval);
+    m_staleAfter = std::max(2 * m_heartbeatInterval, staleAfter);
+}
+
+/**
+ * @brief Add every job of a batch file to pending/, numbered after the jobs already in the queue.
+ * A job file only appears in pending/ once complete (written to tmp/, then linked).
+ *
+ * @param batchFileName
+ * @return int the number of jobs added, -1 if the queue or the batch file cannot be opened.
+ */
+int WorkQueue::submit(const std::string &batchFileName) {
+    if (!init()) {
+        return -1;
+    }
+    std::ifstream fs(batchFileName);
+    if (!fs.good()) {
+        printf("ERR: Read file [%s] failed!\n", batchFileName.c_str());
+        return -1;
+    }
+
+    int seq = 0;
+    for (const char *sub: {"pending", "claimed", "done"}) {
+        for (const std::string &f: listDir(path(sub))) {
+            seq = std::max(seq, seqOf(f) + 1);
+        }
+    }
+
+    int numAdded = 0;
+    std::vector<std::string> tokens;
+    while (read_line_as_tokens(fs, tokens)) {
+        std::vector<MacroPlacer::JOB> jobs;
+        if (strncmp(tokens[0].c_str(), "#", 1) == 0) {
+            continue;
+        }
+        if (!MacroPlacer::parseJobTokens(tokens, jobs)) {
+            printf("ERR: Unexpected input length: %d\n", (int)tokens.size());
+            continue;
+        }
+        std::string line;
+        for (const std::string &t: tokens) {
+            line += (line.empty() ? "" : " ") + t;
+        }
+
+        const std::string tmpFile = path("tmp", "submit." + m_workerId);
+        FILE *fp = fopen(tmpFile.c_str(), "w");
+        if (fp == NULL) {
+            printf("ERR: Open file [%s] failed!\n", tmpFile.c_str());
+            return numAdded;
+        }
+        fprintf(fp, "%s\n", line.c_str());
+        fclose(fp);
+
+        // link() fails if the name exists, so concurrent submitters never overwrite each other.
+        while (true) {
+            char name[64];
+            snprintf(name, sizeof(name), "%06d_", seq++);
+            std::string jobFile = name + tokens[0] + ".job";
+            if (link(tmpFile.c_str(), path("pending", jobFile).c_str()) == 0) {
+                printf("WorkQueue: queued <%s>\n", jobFile.c_str());
+                numAdded++;
+                break;
+            }
+            if (errno != EEXIST) {
+                printf("ERR: Queue job [%s] failed: %s\n", jobFile.c_str(), strerror(errno));
+                break;
+            }
+        }
+        unlink(tmpFile.c_str());
+    }
+    return numAdded;
+}
+
+/**
+ * @brief Work off the queue: claim a pending job, run it, write its result; reclaim dead workers' claims in between.
+ * Returns when nothing is pending or claimed any more, so a live worker outlasts every dead one.
+ *
+ * @return int the number of jobs this worker finished.
+ */
+int WorkQueue::work() {
+    if (!init()) {
+        return 0;
+    }
+    printf("WorkQueue: worker <%s> on <%s>, heartbeat %.0fs, stale after %.0fs\n",
+        m_workerId.c_str(), m_dir.c_str(), m_heartbeatInterval, m_staleAfter);
+
+    int numDone = 0;
+    while (true) {
+        reclaimStale();
+        std::string jobFile;
+        if (claim(jobFile)) {
+            runClaimed(jobFile);
+            numDone++;
+            continue;
+        }
+        if (listDir(path("pending")).empty() && listDir(path("claimed")).empty()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(5.0, m_heartbeatInterval)));
+    }
+    unlink(path("tmp", "clock@" + m_workerId).c_str());
+    printf("WorkQueue: worker <%s> finished %d jobs, queue empty.\n", m_workerId.c_str(), numDone);
+    return numDone;
+}
+
+void WorkQueue::printStatus() {
+    if (!init()) {
+        return;
+    }
+    std::vector<std::string> pending = listDir(path("pending"));
+    std::vector<std::string> claimed = listDir(path("claimed"));
+    std::vector<std::string> done = listDir(path("done"));
+    int numDone = std::count_if(done.begin(), done.end(), [](const std::string &f) { return f.size() > 4 && f.substr(f.size() - 4) == ".job"; });
+    printf("WorkQueue <%s>: %d pending, %d claimed, %d done\n", m_dir.c_str(), (int)pending.size(), (int)claimed.size(), numDone);
+
+    double t = now();
+    for (const std::string &c: claimed) {
+        struct stat st;
+        if (stat(path("claimed", c).c_str(), &st) == 0) {
+            printf("|claimed %s, last heartbeat %.0fs ago\n", c.c_str(), t - mtimeOf(st));
+        }
+    }
+    for (const std::string &f: done) {
+        if (f.size() <= 7 || f.substr(f.size() - 7) != ".result") {
+            continue;
+        }
+        std::ifstream is(path("done", f));
+        std::vector<std::string> tokens;
+        std::string worker, seconds, wl = "-", status;
+        while (read_line_as_tokens(is, tokens)) {
+            if (tokens.size() < 2) {
+                continue;
+            }
+            if (tokens[0] == "worker") {
+                worker = tokens[1];
+            }
+            else if (tokens[0] == "seconds") {
+                seconds = tokens[1];
+            }
+            else if (tokens[0] == "wirelength") {
+                wl = tokens[1];
+            }
+            else if (tokens[0] == "status") {
+                status = tokens[1];
+            }
+        }
+        printf("|done %s: %s, wirelength %s, %ss on %s\n", f.c_str(), status.c_str(), wl.c_str(), seconds.c_str(), worker.c_str());
+    }
+}
+
+bool WorkQueue::init() {
+    mkdir(m_dir.c_str(), 0775);
+    for (const char *sub: kSubDirs) {
+        if (mkdir(path(sub).c_str(), 0775) != 0 && errno != EEXIST) {
+            printf("ERR: Create directory [%s] failed: %s\n", path(sub).c_str(), strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Claim the first pending job by renaming it into claimed/ under this worker's name; a lost race moves on to the next.
+ *
+ * @param jobFile the claimed job.
+ * @return true if a job was claimed.
+ */
+bool WorkQueue::claim(std::string &jobFile) {
+    for (const std::string &f: listDir(path("pending"))) {
+        // Fresh mtime first: the claim must not look stale to a worker reclaiming right now.
+        utime(path("pending", f).c_str(), NULL);
+        if (rename(path("pending", f).c_str(), path("claimed", claimName(f)).c_str()) == 0) {
+            jobFile = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Move the claims whose heartbeat stopped back to pending/. Of several workers reclaiming the same claim,
+ * exactly one rename succeeds.
+ *
+ * @return int the number of claims reclaimed.
+ */
+int WorkQueue::reclaimStale() {
+    double t = now();
+    int numReclaimed = 0;
+    for (const std::string &c: listDir(path("claimed"))) {
+        struct stat st;
+        size_t at = c.rfind('@');
+        if (at == std::string::npos || stat(path("claimed", c).c_str(), &st) != 0 || t - mtimeOf(st) <= m_staleAfter) {
+            continue;
+        }
+        if (rename(path("claimed", c).c_str(), path("pending", c.substr(0, at)).c_str()) == 0) {
+            printf("WorkQueue: reclaimed <%s>, no heartbeat for %.0fs\n", c.c_str(), t - mtimeOf(st));
+            numReclaimed++;
+        }
+    }
+    return numReclaimed;
+}
+
+/**
+ * @brief Run a claimed job while a heartbeat thread touches the claim. The solution goes to results/, the metrics to
+ * done/<job>.result, and the claim to done/. If the claim was reclaimed meanwhile (this worker looked dead), the other
+ * worker owns the job and this result is dropped.
+ *
+ * @param jobFile
+ */
+void WorkQueue::runClaimed(const std::string &jobFile) {
+    const std::string claimFile = path("claimed", claimName(jobFile));
+    const std::string base = jobFile.substr(0, jobFile.size() - 4);
+    printf("WorkQueue: <%s> runs <%s>\n", m_workerId.c_str(), jobFile.c_str());
+
+    std::ifstream is(claimFile);
+    std::vector<std::string> tokens;
+    std::vector<MacroPlacer::JOB> jobs;
+    read_line_as_tokens(is, tokens);
+    is.close();
+    std::string line;
+    for (const std::string &t: tokens) {
+        line += (line.empty() ? "" : " ") + t;
+    }
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool isFinished = false;
+    bool lost = false;
+    std::thread heartbeat([&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finished.wait_for(lock, std::chrono::duration<double>(m_heartbeatInterval), [&]() { return isFinished; })) {
+            if (utime(claimFile.c_str(), NULL) != 0 && errno == ENOENT && !lost) {
+                lost = true;
+                printf("WRN: WorkQueue: claim <%s> was reclaimed by another worker.\n", jobFile.c_str());
+            }
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    const std::string tmpSol = path("tmp", base + ".sol." + m_workerId);
+    std::string status = "invalid";
+    std::string solFile = "";
+    double wl = 0;
+    bool legal = false;
+    if (MacroPlacer::parseJobTokens(tokens, jobs)) {
+        m_placer.runJob(jobs[0]);
+        status = "no_solution";
+        Placement pl;
+        PlacementProblem prob = MacroPlacer::jobProblem(jobs[0]);
+        if (m_placer.lastSolFileName() != "" && readPlacementFromSol(m_placer.lastSolFileName(), prob, pl)) {
+            status = "solved";
+            wl = placementWirelength(prob, pl);
+            legal = isPlacementLegal(prob, pl);
+            solFile = "results/" + base + ".sol";
+            // Published to results/ only once the claim is confirmed ours, below.
+            writePlacementToSol(tmpSol, prob, pl);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isFinished = true;
+    }
+    finished.notify_all();
+    heartbeat.join();
+
+    char buf[256];
+    std::string result = "job " + line + "\n" + "worker " + m_workerId + "\n" + "status " + status + "\n";
+    snprintf(buf, sizeof(buf), "seconds %.3f\n", elapsed.count());
+    result += buf;
+    if (status == "solved") {
+        snprintf(buf, sizeof(buf), "wirelength %.10g\nlegal %d\nsolution %s\n", wl, legal, solFile.c_str());
+        result += buf;
+    }
+
+    const std::string tmpResult = path("tmp", base + ".result." + m_workerId);
+    if (rename(claimFile.c_str(), path("done", jobFile).c_str()) != 0) {
+        printf("WRN: WorkQueue: <%s> is owned by another worker now, result dropped.\n", jobFile.c_str());
+        if (status == "solved") {
+            remove(tmpSol.c_str());
+        }
+        return;
+    }
+    if (status == "solved" && rename(tmpSol.c_str(), path("results", base + ".sol").c_str()) != 0) {
+        printf("ERR: WorkQueue: publishing the solution of <%s> failed.\n", jobFile.c_str());
+    }
+    if (!writeFileAtomic(tmpResult, path("done", base + ".result"), result)) {
+        printf("ERR: WorkQueue: writing the result of <%s> failed.\n", jobFile.c_str());
+    }
+    printf("WorkQueue: <%s> %s in %.1fs\n", jobFile.c_str(), status.c_str(), elapsed.count());
+}
+
+/**
+ * @brief The file server's current time: the mtime of a file this worker touches now.
+ *
+ * @return double seconds.
+ */
+double WorkQueue::now() {
+    const std::string probe = path("tmp", "clock@" + m_workerId);
+    int fd = open(probe.c_str(), O_CREAT | O_WRONLY, 0664);
+    if (fd >= 0) {
+        close(fd);
+    }
+    utime(probe.c_str(), NULL);
+    struct stat st;
+    if (stat(probe.c_str(), &st) != 0) {
+        return time(NULL);
+    }
+    return mtimeOf(st);
+}
+
+std::string WorkQueue::path(const std::string &sub, const std::string &file) const {
+    return m_dir + "/" + sub + (file.empty() ? "" : "/" + file);
+}
+
+/**
+ * @brief Names in <dir>, sorted, without "." entries.
+ *
+ */
+std::vector<std::string> WorkQueue::listDir(const std::string &dir) {
+    std::vector<std::string> names;
+    DIR *d = opendir(dir.c_str());
+    if (d == NULL) {
+        return names;
+    }
+    while (struct dirent *e = readdir(d)) {
+        if (e->d_name[0] != '.') {
+            names.push_back(e->d_name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool WorkQueue::writeFileAtomic(const std::string &tmpFile, const std::string &file, const std::string &content) {
+    FILE *fp = fopen(tmpFile.c_str(), "w");
+    if (fp == NULL) {
+        return false;
+    }
+    fputs(content.c_str(), fp);
+    fclose(fp);
+    return rename(tmpFile.c_str(), file.c_str()) == 0;
+}
@@ -0,0 +1,53 @@
+#ifndef __WORKQUEUE_H__
+#define __WORKQUEUE_H__
+
+#include "ILPSolver.h"
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Batch queue in a shared directory (e.g. NFS), worked off by any number of worker processes on any hosts.
+ * All state is files; every state change is one atomic link() or rename() within the directory:
+ *   pending/<seq>_<name>.job           one batch line, waiting;
+ *   claimed/<seq>_<name>.job@<worker>  claimed by a worker, which touches it every heartbeat interval;
+ *   done/<seq>_<name>.job              finished, next to <seq>_<name>.result (worker, seconds, wirelength, legality);
+ *   results/<seq>_<name>.sol           the solution of a finished job;
+ *   tmp/                               files being written, and the clock probes of the workers.
+ * A claim not touched for the stale time belongs to a dead worker and is moved back to pending/ by any worker.
+ * Ages are measured against a file freshly touched in the directory, so only the file server's clock matters.
+ *
+ */
+class WorkQueue
+{
+public:
+    explicit WorkQueue(const std::string &dir);
+
+    void    setHeartbeat(double interval, double staleAfter);
+
+    int     submit(const std::string &batchFileName);
+    int     work();
+    void    printStatus();
+
+private:
+    bool    init();
+    bool    claim(std::string &jobFile);
+    int     reclaimStale();
+    void    runClaimed(const std::string &jobFile);
+    double  now();
+
+    std::string path(const std::string &sub, const std::string &file = "") const;
+    std::string claimName(const std::string &jobFile) const { return jobFile + "@" + m_workerId; }
+
+    static std::vector<std::string> listDir(const std::string &dir);
+    static bool writeFileAtomic(const std::string &tmpFile, const std::string &file, const std::string &content);
+
+    std::string     m_dir;
+    std::string     m_workerId; // <host>.<pid>
+    MacroPlacer     m_placer; // One placer for all jobs of this worker, so its Gurobi environments stay warm.
+    double          m_heartbeatInterval = 30;
+    double          m_staleAfter = 300;
+};
+
+
+#endif
@@ -4,6 +4,14 @@
 #include <string.h>
 
 #include "ILPSolver.h"
+#include "CostKernel.h"
+#include "CutSeparator.h"
+#include "Spectral.h"
+#include "Analytical.h"
+#include "WirelengthBatch.h"
+#include "Render.h"
+#include "Server.h"
+#include "WorkQueue.h"
 
 int main(int argc, char** argv)  {
 
@@ -16,13 +24,123 @@ int main(int argc, char** argv)  {
         solver.setProblemSize(3, 3, 10, 2);
         solver.run3();
     }
-    else if (argc == 3) {
+    else if (argc >= 4 && strcmp(argv[1], "--queue-submit") == 0) {
+        // --queue-submit queueDir batchFile
+        WorkQueue queue(argv[2]);
+        int added = queue.submit(argv[3]);
+        printf("Queued %d jobs in <%s>.\n", added, argv[2]);
+        return (added < 0) ? 1 : 0;
+    }
+    else if (argc >= 3 && strcmp(argv[1], "--worker") == 0) {
+        // --worker queueDir [heartbeatSeconds staleSeconds]
+        WorkQueue queue(argv[2]);
+        if (argc >= 5) {
+            queue.setHeartbeat(atof(argv[3]), atof(argv[4]));
+        }
+        queue.work();
+    }
+    else if (argc >= 3 && strcmp(argv[1], "--queue-status") == 0) {
+        WorkQueue queue(argv[2]);
+        queue.printStatus();
+    }
+    else if (argc >= 5 && strcmp(argv[1], "--design") == 0) {
+        // --design design.rglr timeLimit method [initSolFileName] [key=value ...]
+        MacroPlacer solver;
+        std::vector<std::string> fields(argv + 3, argv + argc);
+        if (!solver.addDesignJob(argv[2], fields)) {
+            return 1;
+        }
+        solver.runJobs();
+    }
+    else if (argc == 3 && (strcmp(argv[1], "--batch") == 0 || strcmp(argv[1], "-b") == 0 || strcmp(argv[1], "--server") == 0)) {
         if ((strcmp(argv[1], "--batch") == 0 ) || (strcmp(argv[1], "-b") == 0 )) {
             const std::string batchFileName = argv[2];
             printf("Run batch mode from file <%s>.\n", argv[2]);
             MacroPlacer solver;
             solver.runBatchFromFile(argv[2]);
         }
+        else if (strcmp(argv[1], "--server") == 0) {
+            PlacerServer server(argv[2]);
+            return server.run();
+        }
+    }
+    else if (argc >= 6 && strcmp(argv[1], "--bench-wl") == 0) {
+        // --bench-wl arraySizeY arraySizeX siteSizeY siteSizeX [batchSize]
+        PlacementProblem prob;
+        prob.arraySizeY = atoi(argv[2]);
+        prob.arraySizeX = atoi(argv[3]);
+        prob.siteSizeY = atoi(argv[4]);
+        prob.siteSizeX = atoi(argv[5]);
+        prob.weightX = 15;
+        int batchSize = (argc >= 7) ? atoi(argv[6]) : 256;
+        benchmarkWirelengthBatch(prob, batchSize, 2.0);
+    }
+    else if (argc >= 6 && strcmp(argv[1], "--bench-kernels") == 0) {
+        // --bench-kernels arraySizeY arraySizeX siteSizeY siteSizeX [seconds]
+        PlacementProblem prob;
+        prob.arraySizeY = atoi(argv[2]);
+        prob.arraySizeX = atoi(argv[3]);
+        prob.siteSizeY = atoi(argv[4]);
+        prob.siteSizeX = atoi(argv[5]);
+        prob.weightX = 15;
+        benchmarkCostKernels(prob, (argc >= 7) ? atof(argv[6]) : 1.0);
+    }
+    else if (argc >= 6 && strcmp(argv[1], "--bench-cuts") == 0) {
+        // --bench-cuts arraySizeY arraySizeX siteSizeY siteSizeX
+        PlacementProblem prob;
+        prob.arraySizeY = atoi(argv[2]);
+        prob.arraySizeX = atoi(argv[3]);
+        prob.siteSizeY = atoi(argv[4]);
+        prob.siteSizeX = atoi(argv[5]);
+        prob.weightX = 15;
+        benchmarkCuts(prob);
+    }
+    else if (argc >= 4 && strcmp(argv[1], "--bench-spectral") == 0) {
+        // --bench-spectral arraySizeY arraySizeX [siteSizeY [rp [seconds]]]: one column, relative ordering on both axes unless rp is 0.
+        PlacementProblem prob;
+        prob.arraySizeY = atoi(argv[2]);
+        prob.arraySizeX = atoi(argv[3]);
+        prob.siteSizeY = (argc >= 5) ? atoi(argv[4]) : prob.numCells();
+        prob.siteSizeX = 1;
+        prob.weightX = 15;
+        prob.relativeConstraintX = prob.relativeConstraintY = prob.strictOrderY = (argc >= 6) ? atoi(argv[5]) : 1;
+        benchmarkSpectral(prob, (argc >= 7) ? atof(argv[6]) : 1.0);
+    }
+    else if (argc >= 6 && strcmp(argv[1], "--bench-analytical") == 0) {
+        // --bench-analytical arraySizeY arraySizeX siteSizeY siteSizeX [rpX rpY]
+        PlacementProblem prob;
+        prob.arraySizeY = atoi(argv[2]);
+        prob.arraySizeX = atoi(argv[3]);
+        prob.siteSizeY = atoi(argv[4]);
+        prob.siteSizeX = atoi(argv[5]);
+        prob.weightX = 15;
+        if (argc >= 8) {
+            prob.relativeConstraintX = atoi(argv[6]);
+            prob.relativeConstraintY = atoi(argv[7]);
+        }
+        benchmarkAnalytical(prob);
+    }
+    else if (argc >= 3 && strcmp(argv[1], "--render") == 0) {
+        // --render [--ppm] [--threads n] [--weight weightX weightY] file.sol ...
+        RenderOptions opt;
+        std::vector<std::string> solFileNames;
+        for (int k = 2; k < argc; k++) {
+            if (strcmp(argv[k], "--ppm") == 0) {
+                opt.format = "ppm";
+            }
+            else if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc) {
+                opt.threads = atoi(argv[++k]);
+            }
+            else if (strcmp(argv[k], "--weight") == 0 && k + 2 < argc) {
+                opt.weightX = atof(argv[++k]);
+                opt.weightY = atof(argv[++k]);
+            }
+            else {
+                solFileNames.push_back(argv[k]);
+            }
+        }
+        int written = renderSolFiles(solFileNames, opt);
+        printf("Rendered %d of %d files.\n", written, (int)solFileNames.size());
     }
     
     // solver.exampleGurobiOptimization();
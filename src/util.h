@@ -9,6 +9,7 @@
 #include <set>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <algorithm>
 
 /// Ref: RippleFPGA